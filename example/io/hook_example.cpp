@@ -0,0 +1,240 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <include/io/hook.h>
+#include <include/io/io_manager.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static const size_t s_msg_size = 64;
+
+static double ms_since(uint64_t begin)
+{
+	return (RareVoyager::GetMonotonicNS() - begin) / 1e6;
+}
+
+static void wait_for(const std::atomic<int>& counter, int target)
+{
+	while (counter.load() < target)
+	{
+		usleep(1000);
+	}
+}
+
+/**
+ * @brief: 阻塞写法的收发，在开启 hook 的协程里不会阻塞线程
+ */
+static bool recv_full(int fd, char* buf, size_t len)
+{
+	size_t off = 0;
+	while (off < len)
+	{
+		ssize_t n = recv(fd, buf + off, len - off, 0);
+		if (n <= 0)
+		{
+			return false;
+		}
+		off += n;
+	}
+	return true;
+}
+
+static bool send_full(int fd, const char* buf, size_t len)
+{
+	size_t off = 0;
+	while (off < len)
+	{
+		ssize_t n = send(fd, buf + off, len - off, 0);
+		if (n <= 0)
+		{
+			return false;
+		}
+		off += n;
+	}
+	return true;
+}
+
+/**
+ * @brief: 1M 次 1 字节 read，比较 hook 后的 read 与原函数
+ */
+static void bench_read(const char* label, int fd)
+{
+	const int loops = 1000000;
+	char c;
+	// 预热
+	for (int i = 0; i < loops / 10; ++i)
+	{
+		read(fd, &c, 1);
+	}
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < loops; ++i)
+	{
+		read_f(fd, &c, 1);
+	}
+	double origin_ns = ms_since(begin) * 1e6 / loops;
+	begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < loops; ++i)
+	{
+		read(fd, &c, 1);
+	}
+	double hooked_ns = ms_since(begin) * 1e6 / loops;
+	RAREVOYAGER_LOG_INFO(g_logger) << label << ": read_f " << origin_ns << " ns/call, hooked read " << hooked_ns
+			<< " ns/call";
+}
+
+/**
+ * @brief: 用法 hook_example [工作线程数，默认 2] [连接数，默认 50] [每个连接往返次数，默认 200]
+ */
+int main(int argc, char** argv)
+{
+	size_t threads = argc > 1 ? atoi(argv[1]) : 2;
+	int conns = argc > 2 ? atoi(argv[2]) : 50;
+	int rounds = argc > 3 ? atoi(argv[3]) : 200;
+
+	RareVoyager::IOManager iom(threads, false, "hook");
+
+	// 1. 1000 个协程各 usleep 50ms、nanosleep 30ms，只有 threads 个线程也应当约 80ms 完成
+	const int sleepers = 1000;
+	std::atomic<int> slept{0};
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < sleepers; ++i)
+	{
+		iom.schedule([&slept]() {
+			usleep(50000);
+			timespec ts = {0, 30000000};
+			nanosleep(&ts, nullptr);
+			++slept;
+		});
+	}
+	wait_for(slept, sleepers);
+	double sleep_ms = ms_since(begin);
+
+	// 2. 阻塞写法的回环 echo: socket/bind/listen/accept/recv/send 全部走 hook
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	std::atomic<int> listen_fd{-1};
+	std::atomic<int> listening{0};
+	iom.schedule([&]() {
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		socklen_t len = sizeof(addr);
+		if (bind(fd, (sockaddr*)&addr, sizeof(addr)) || listen(fd, 1024) || getsockname(fd, (sockaddr*)&addr, &len))
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "listen failed: " << strerror(errno);
+		}
+		listen_fd = fd;
+		++listening;
+		while (true)
+		{
+			int client = accept(fd, nullptr, nullptr);
+			if (client < 0)
+			{
+				break;
+			}
+			iom.schedule([client]() {
+				char buf[s_msg_size];
+				while (recv_full(client, buf, sizeof(buf)) && send_full(client, buf, sizeof(buf)))
+				{
+				}
+				close(client);
+			});
+		}
+	});
+	wait_for(listening, 1);
+
+	std::atomic<int> finished{0};
+	std::atomic<int> errors{0};
+	begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < conns; ++i)
+	{
+		iom.schedule([&]() {
+			int fd = socket(AF_INET, SOCK_STREAM, 0);
+			if (connect(fd, (sockaddr*)&addr, sizeof(addr)))
+			{
+				++errors;
+			}
+			char buf[s_msg_size];
+			memset(buf, 'x', sizeof(buf));
+			for (int k = 0; k < rounds; ++k)
+			{
+				if (!send_full(fd, buf, sizeof(buf)) || !recv_full(fd, buf, sizeof(buf)))
+				{
+					++errors;
+					break;
+				}
+			}
+			close(fd);
+			++finished;
+		});
+	}
+	wait_for(finished, conns);
+	double echo_ms = ms_since(begin);
+
+	// 3. SO_RCVTIMEO: 没有数据时 100ms 后返回 EAGAIN，期间线程可以跑其它协程
+	std::atomic<int> timed_out{0};
+	std::atomic<int> recv_errno{0};
+	std::atomic<uint64_t> recv_ns{0};
+	iom.schedule([&]() {
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		connect(fd, (sockaddr*)&addr, sizeof(addr));
+		timeval tv = {0, 100000};
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		char c;
+		uint64_t start = RareVoyager::GetMonotonicNS();
+		ssize_t n = recv(fd, &c, 1, 0);
+		recv_ns = RareVoyager::GetMonotonicNS() - start;
+		recv_errno = n < 0 ? errno : 0;
+		close(fd);
+		++timed_out;
+	});
+	wait_for(timed_out, 1);
+
+	// 4. 用户设置的非阻塞: hook 不等待，直接返回 EAGAIN
+	std::atomic<int> nonblock_done{0};
+	std::atomic<int> nonblock_errno{0};
+	std::atomic<int> nonblock_flag{0};
+	iom.schedule([&]() {
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		connect(fd, (sockaddr*)&addr, sizeof(addr));
+		// hook 后系统层面已经是非阻塞，用户看到的仍是阻塞
+		nonblock_flag = fcntl(fd, F_GETFL, 0) & O_NONBLOCK;
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+		char c;
+		nonblock_errno = recv(fd, &c, 1, 0) < 0 ? errno : 0;
+		close(fd);
+		++nonblock_done;
+	});
+	wait_for(nonblock_done, 1);
+
+	RAREVOYAGER_LOG_INFO(g_logger) << threads << " workers: " << sleepers << " fibers usleep(50ms)+nanosleep(30ms) "
+			<< sleep_ms << " ms; blocking-style echo " << conns << " x " << rounds << " round trips " << echo_ms
+			<< " ms (errors = " << errors << "); recv with SO_RCVTIMEO 100ms returned after " << recv_ns / 1e6
+			<< " ms, errno = " << strerror(recv_errno) << "; O_NONBLOCK seen by user before F_SETFL = "
+			<< nonblock_flag << ", recv after F_SETFL O_NONBLOCK errno = " << strerror(nonblock_errno);
+
+	// 5. hook 的开销: 当前线程没开启 hook、开启 hook 但 fd 不是 socket
+	int zero_fd = open("/dev/zero", O_RDONLY);
+	bench_read("hook disabled", zero_fd);
+	std::atomic<int> benched{0};
+	iom.schedule([&]() {
+		bench_read("hook enabled, non-socket fd", zero_fd);
+		++benched;
+	});
+	wait_for(benched, 1);
+	close(zero_fd);
+
+	// 6. 在 IOManager 的协程里关闭监听 fd，hook 的 close 会取消 accept 上的等待
+	iom.schedule([&]() { close(listen_fd); });
+	iom.stop();
+	RAREVOYAGER_LOG_INFO(g_logger) << "stopped, pending events = " << iom.getPendingEventCount();
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <include/io/io_manager.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static double ms_since(uint64_t begin)
+{
+	return (RareVoyager::GetMonotonicNS() - begin) / 1e6;
+}
+
+/**
+ * @brief: 读协程在管道上等待，定时器到期后写入，唤醒读协程
+ */
+static void pipe_round(RareVoyager::IOManager& iom, std::atomic<int>& done, uint64_t& woken_at)
+{
+	int fds[2];
+	if (pipe2(fds, O_NONBLOCK | O_CLOEXEC))
+	{
+		RAREVOYAGER_LOG_ERROR(g_logger) << "pipe2 failed, errno = " << errno;
+		return;
+	}
+	iom.schedule([&iom, &done, &woken_at, fds]() {
+		char c;
+		while (read(fds[0], &c, 1) != 1)
+		{
+			if (!iom.addEvent(fds[0], RareVoyager::IOManager::READ))
+			{
+				RareVoyager::Fiber::YieldToHold();
+			}
+		}
+		woken_at = RareVoyager::GetMonotonicNS();
+		close(fds[0]);
+		++done;
+	});
+	iom.addTimer(20, [fds]() {
+		char c = 'x';
+		write(fds[1], &c, 1);
+		close(fds[1]);
+	});
+}
+
+/**
+ * @brief: 默认构造(use_caller = true)的 IOManager。调用者线程在 stop 里参与调度
+ */
+int main(int argc, char** argv)
+{
+	// 1. 只有调用者线程: 任务、事件、定时器全部在 stop 里跑完，stop 之后析构不能再 stop
+	{
+		std::atomic<int> done{0};
+		uint64_t woken_at = 0;
+		uint64_t begin = RareVoyager::GetMonotonicNS();
+		RareVoyager::IOManager iom;
+		pipe_round(iom, done, woken_at);
+		iom.stop();
+		RAREVOYAGER_LOG_INFO(g_logger) << "caller only: done = " << done << ", woken after "
+				<< (woken_at - begin) / 1e6 << " ms, stop returned after " << ms_since(begin)
+				<< " ms, pending events = " << iom.getPendingEventCount();
+	}
+
+	// 2. 调用者线程加一个工作线程，不显式 stop，由析构在调用者线程上停止
+	{
+		std::atomic<int> done{0};
+		uint64_t woken_at = 0;
+		uint64_t begin = RareVoyager::GetMonotonicNS();
+		{
+			RareVoyager::IOManager iom(2);
+			pipe_round(iom, done, woken_at);
+			std::atomic<int> tasks{0};
+			for (int i = 0; i < 100; ++i)
+			{
+				iom.schedule([&tasks]() { ++tasks; });
+			}
+			while (tasks < 100)
+			{
+				usleep(1000);
+			}
+			RAREVOYAGER_LOG_INFO(g_logger) << "caller + 1 worker: " << tasks << " tasks ran before stop";
+		}
+		RAREVOYAGER_LOG_INFO(g_logger) << "caller + 1 worker: done = " << done << ", woken after "
+				<< (woken_at - begin) / 1e6 << " ms, destroyed after " << ms_since(begin) << " ms";
+	}
+	return 0;
+}
@@ -0,0 +1,214 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <include/io/io_manager.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static const size_t s_msg_size = 64;
+
+static double cpu_ms()
+{
+	timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int make_socket()
+{
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return fd;
+}
+
+/**
+ * @brief: 在协程里等待 fd 就绪
+ */
+static void wait_event(int fd, RareVoyager::IOManager::Event event)
+{
+	if (!RareVoyager::IOManager::GetThis()->addEvent(fd, event))
+	{
+		RareVoyager::Fiber::YieldToHold();
+	}
+}
+
+/**
+ * @brief: 读满 len 字节，对端关闭或出错返回 false
+ */
+static bool read_full(int fd, char* buf, size_t len)
+{
+	size_t off = 0;
+	while (off < len)
+	{
+		ssize_t n = read(fd, buf + off, len - off);
+		if (n > 0)
+		{
+			off += n;
+		}
+		else if (n < 0 && errno == EAGAIN)
+		{
+			wait_event(fd, RareVoyager::IOManager::READ);
+		}
+		else if (n < 0 && errno == EINTR)
+		{
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool write_full(int fd, const char* buf, size_t len)
+{
+	size_t off = 0;
+	while (off < len)
+	{
+		ssize_t n = write(fd, buf + off, len - off);
+		if (n >= 0)
+		{
+			off += n;
+		}
+		else if (errno == EAGAIN)
+		{
+			wait_event(fd, RareVoyager::IOManager::WRITE);
+		}
+		else if (errno != EINTR)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void echo(int fd)
+{
+	char buf[s_msg_size];
+	while (read_full(fd, buf, sizeof(buf)) && write_full(fd, buf, sizeof(buf)))
+	{
+	}
+	close(fd);
+}
+
+/**
+ * @brief: 用法 io_manager_example [工作线程数，默认 2] [连接数，默认 100] [每个连接往返次数，默认 1000]
+ */
+int main(int argc, char** argv)
+{
+	size_t threads = argc > 1 ? atoi(argv[1]) : 2;
+	int conns = argc > 2 ? atoi(argv[2]) : 100;
+	int rounds = argc > 3 ? atoi(argv[3]) : 1000;
+
+	RareVoyager::IOManager iom(threads, false, "io");
+
+	// 1. 监听 127.0.0.1 的随机端口，accept 协程为每个连接起一个 echo 协程
+	int listen_fd = make_socket();
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addr_len = sizeof(addr);
+	if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) || listen(listen_fd, 1024)
+		|| getsockname(listen_fd, (sockaddr*)&addr, &addr_len))
+	{
+		RAREVOYAGER_LOG_ERROR(g_logger) << "listen failed: " << strerror(errno);
+		return 1;
+	}
+	std::atomic<bool> closing{false};
+	std::atomic<int> accepted{0};
+	iom.schedule([&]() {
+		while (!closing)
+		{
+			int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if (fd >= 0)
+			{
+				++accepted;
+				iom.schedule([fd]() { echo(fd); });
+			}
+			else if (errno == EAGAIN)
+			{
+				wait_event(listen_fd, RareVoyager::IOManager::READ);
+			}
+		}
+	});
+
+	// 2. 客户端协程: 非阻塞 connect 后做 rounds 次 64 字节的往返
+	std::atomic<int> finished{0};
+	std::atomic<uint64_t> round_trips{0};
+	std::atomic<int> errors{0};
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	double cpu_begin = cpu_ms();
+	for (int i = 0; i < conns; ++i)
+	{
+		iom.schedule([&]() {
+			int fd = make_socket();
+			if (connect(fd, (sockaddr*)&addr, sizeof(addr)) && errno == EINPROGRESS)
+			{
+				wait_event(fd, RareVoyager::IOManager::WRITE);
+			}
+			char buf[s_msg_size];
+			memset(buf, 'x', sizeof(buf));
+			for (int k = 0; k < rounds; ++k)
+			{
+				if (!write_full(fd, buf, sizeof(buf)) || !read_full(fd, buf, sizeof(buf)))
+				{
+					++errors;
+					break;
+				}
+				round_trips.fetch_add(1, std::memory_order_relaxed);
+			}
+			close(fd);
+			++finished;
+		});
+	}
+	while (finished < conns)
+	{
+		usleep(1000);
+	}
+	double elapsed_ms = (RareVoyager::GetMonotonicNS() - begin) / 1e6;
+	double busy_cpu = cpu_ms() - cpu_begin;
+
+	// 3. 定时器由 epoll_wait 的超时驱动
+	std::atomic<uint64_t> fired_at{0};
+	uint64_t timer_begin = RareVoyager::GetMonotonicNS();
+	iom.addTimer(50, [&]() { fired_at = RareVoyager::GetMonotonicNS(); });
+	std::atomic<int> ticks{0};
+	RareVoyager::Timer::ptr ticker = iom.addTimer(10, [&]() { ++ticks; }, true);
+	while (!fired_at)
+	{
+		usleep(1000);
+	}
+	ticker->cancel();
+
+	// 4. 空闲时不占 CPU
+	usleep(20000);
+	double cpu_before = cpu_ms();
+	usleep(200000);
+	double idle_cpu = cpu_ms() - cpu_before;
+
+	RAREVOYAGER_LOG_INFO(g_logger) << threads << " workers, " << conns << " connections (accepted " << accepted
+			<< "): " << round_trips << " round trips in " << elapsed_ms << " ms ("
+			<< round_trips * 1e3 / elapsed_ms << " rt/s, cpu " << busy_cpu << " ms, errors = " << errors
+			<< "); 50ms timer fired after " << (fired_at - timer_begin) / 1e6 << " ms, 10ms ticker ticks = " << ticks
+			<< "; cpu while idle 200ms = " << idle_cpu << " ms; pending events = " << iom.getPendingEventCount();
+	RAREVOYAGER_LOG_INFO(g_logger) << iom.statsToString();
+
+	// 5. 取消 accept 上的等待，让 stop 能够结束
+	closing = true;
+	iom.cancelEvent(listen_fd, RareVoyager::IOManager::READ);
+	iom.stop();
+	close(listen_fd);
+	RAREVOYAGER_LOG_INFO(g_logger) << "stopped, pending events = " << iom.getPendingEventCount();
+	return 0;
+}
@@ -0,0 +1,205 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <include/io/io_manager.h>
+#include <include/config/config.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static const size_t s_msg_size = 64;
+
+static double cpu_ms()
+{
+	timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void wait_for(const std::atomic<int>& counter, int target)
+{
+	while (counter.load() < target)
+	{
+		usleep(1000);
+	}
+}
+
+/**
+ * @brief: 读满或写满 len 字节，fixed 时 buf 位于 0 号固定缓冲区
+ */
+static bool transfer(RareVoyager::IOManager* iom, int fd, char* buf, size_t len, bool reading, bool fixed)
+{
+	size_t off = 0;
+	int buf_index = fixed ? 0 : -1;
+	while (off < len)
+	{
+		ssize_t n = reading ? iom->asyncReadFixed(fd, buf + off, len - off, buf_index)
+							: iom->asyncWriteFixed(fd, buf + off, len - off, buf_index);
+		if (n <= 0)
+		{
+			return false;
+		}
+		off += n;
+	}
+	return true;
+}
+
+/**
+ * @brief: 一轮测试: 建立 conns 个回环连接，每个连接做 rounds 次 64 字节往返
+ * @param fixed io_uring 时注册固定缓冲区与固定文件
+ */
+static void run(const std::string& backend, bool fixed, size_t threads, int conns, int rounds)
+{
+	RareVoyager::Config::Lookup<std::string>("io.backend")->setValue(backend);
+	RareVoyager::IOManager iom(threads, false, backend);
+	bool uring = iom.getBackend() == RareVoyager::IOManager::IO_URING;
+	// io_uring 用阻塞 socket，由内核在就绪时完成请求；epoll 必须是非阻塞的
+	int nonblock = uring ? 0 : SOCK_NONBLOCK;
+
+	// 1. 建立连接
+	int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | nonblock, 0);
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addr_len = sizeof(addr);
+	if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) || listen(listen_fd, 4096)
+		|| getsockname(listen_fd, (sockaddr*)&addr, &addr_len))
+	{
+		RAREVOYAGER_LOG_ERROR(g_logger) << "listen failed: " << strerror(errno);
+		return;
+	}
+	std::vector<int> clients(conns, -1);
+	std::vector<int> servers(conns, -1);
+	std::atomic<int> ready{0};
+	iom.schedule([&]() {
+		for (int i = 0; i < conns; ++i)
+		{
+			servers[i] = iom.asyncAccept(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | nonblock);
+			++ready;
+		}
+	});
+	for (int i = 0; i < conns; ++i)
+	{
+		iom.schedule([&, i]() {
+			int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | nonblock, 0);
+			int one = 1;
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+			if (iom.asyncConnect(fd, (sockaddr*)&addr, sizeof(addr)))
+			{
+				RAREVOYAGER_LOG_ERROR(g_logger) << "connect failed: " << strerror(errno);
+			}
+			clients[i] = fd;
+			++ready;
+		});
+	}
+	wait_for(ready, conns * 2);
+
+	// 2. 固定缓冲区与固定文件: 每个连接两端各 64 字节，全部放在 0 号缓冲区里
+	std::vector<char> arena(conns * 2 * s_msg_size, 'x');
+	if (fixed)
+	{
+		std::vector<iovec> buffers(1);
+		buffers[0].iov_base = arena.data();
+		buffers[0].iov_len = arena.size();
+		std::vector<int> fds(clients);
+		fds.insert(fds.end(), servers.begin(), servers.end());
+		if (iom.registerBuffers(buffers) || iom.registerFiles(fds))
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "register failed: " << strerror(errno);
+			fixed = false;
+		}
+	}
+
+	// 3. 往返
+	std::atomic<int> finished{0};
+	std::atomic<int> errors{0};
+	uint64_t syscalls = iom.getSyscallCount();
+	double cpu_begin = cpu_ms();
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < conns; ++i)
+	{
+		char* client_buf = &arena[i * 2 * s_msg_size];
+		char* server_buf = client_buf + s_msg_size;
+		iom.schedule([&, i, server_buf]() {
+			for (int k = 0; k < rounds; ++k)
+			{
+				if (!transfer(&iom, servers[i], server_buf, s_msg_size, true, fixed)
+					|| !transfer(&iom, servers[i], server_buf, s_msg_size, false, fixed))
+				{
+					++errors;
+					break;
+				}
+			}
+			++finished;
+		});
+		iom.schedule([&, i, client_buf]() {
+			for (int k = 0; k < rounds; ++k)
+			{
+				if (!transfer(&iom, clients[i], client_buf, s_msg_size, false, fixed)
+					|| !transfer(&iom, clients[i], client_buf, s_msg_size, true, fixed))
+				{
+					++errors;
+					break;
+				}
+			}
+			++finished;
+		});
+	}
+	wait_for(finished, conns * 2);
+	double elapsed_ms = (RareVoyager::GetMonotonicNS() - begin) / 1e6;
+	double cpu = cpu_ms() - cpu_begin;
+	syscalls = iom.getSyscallCount() - syscalls;
+	uint64_t round_trips = static_cast<uint64_t>(conns) * rounds;
+
+	// 4. asyncSleep: io_uring 下是 IORING_OP_TIMEOUT，epoll 下是定时器
+	std::atomic<int> slept{0};
+	std::atomic<uint64_t> sleep_ns{0};
+	iom.schedule([&]() {
+		uint64_t start = RareVoyager::GetMonotonicNS();
+		iom.asyncSleep(20);
+		sleep_ns = RareVoyager::GetMonotonicNS() - start;
+		++slept;
+	});
+	wait_for(slept, 1);
+
+	RAREVOYAGER_LOG_INFO(g_logger) << (uring ? "io_uring" : "epoll") << (fixed ? " + fixed buffers/files" : "")
+			<< ": " << round_trips << " round trips in " << elapsed_ms << " ms (" << round_trips * 1e3 / elapsed_ms
+			<< " rt/s), syscalls " << syscalls << " (" << (double)syscalls / round_trips << " per round trip), cpu "
+			<< cpu << " ms, errors = " << errors << "; asyncSleep(20) took " << sleep_ns / 1e6 << " ms";
+
+	if (fixed)
+	{
+		iom.unregisterFiles();
+	}
+	for (int i = 0; i < conns; ++i)
+	{
+		close(clients[i]);
+		close(servers[i]);
+	}
+	close(listen_fd);
+	iom.stop();
+}
+
+/**
+ * @brief: 用法 io_uring_bench_example [工作线程数，默认 1] [连接数，默认 100] [每个连接往返次数，默认 1000]
+ * 依次用 epoll、io_uring、io_uring 加固定缓冲区与固定文件跑回环往返，比较吞吐与系统调用次数
+ */
+int main(int argc, char** argv)
+{
+	size_t threads = argc > 1 ? atoi(argv[1]) : 1;
+	int conns = argc > 2 ? atoi(argv[2]) : 100;
+	int rounds = argc > 3 ? atoi(argv[3]) : 1000;
+
+	run("epoll", false, threads, conns, rounds);
+	run("io_uring", false, threads, conns, rounds);
+	run("io_uring", true, threads, conns, rounds);
+	return 0;
+}
@@ -0,0 +1,50 @@
+#include <random>
+
+#include <include/metrics/hdr_histogram.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+
+// 所有线程共享，record 是 wait-free 的
+RareVoyager::HdrHistogram g_shared;
+
+void func()
+{
+	// 每个线程一个私有实例，结束时合并
+	RareVoyager::HdrHistogram local;
+	std::mt19937_64 rng(RareVoyager::getThreadPid());
+	std::exponential_distribution<double> dist(1.0 / 2000);
+	for (int i = 0; i < 1000000; ++i)
+	{
+		uint64_t v = static_cast<uint64_t>(dist(rng));
+		local.record(v);
+		g_shared.record(v);
+	}
+	static RareVoyager::Mutex s_mutex;
+	static RareVoyager::LatencyHistogram::ptr s_latency =
+		RareVoyager::Metrics::Lookup<RareVoyager::LatencyHistogram>("example.latency_ns", "example latency");
+	RareVoyager::Mutex::Lock lock(&s_mutex);
+	s_latency->merge(local);
+}
+
+int main()
+{
+	std::vector<RareVoyager::Thread::ptr> threads;
+	for (int i = 0; i < 4; ++i)
+	{
+		threads.emplace_back(new RareVoyager::Thread(&func, "hdr_" + std::to_string(i)));
+	}
+	for (auto& i: threads)
+	{
+		i->join();
+	}
+
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "shared: " << g_shared.toString();
+
+	std::string data = g_shared.serialize();
+	auto copy = RareVoyager::HdrHistogram::Deserialize(data);
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "serialized " << data.size() << " bytes, copy: "
+			<< copy->toString();
+
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "\n" << RareVoyager::Metrics::ToPrometheusString();
+	return 0;
+}
@@ -0,0 +1,48 @@
+#include <include/metrics/metrics.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+
+RareVoyager::Counter::ptr g_accept_count =
+	RareVoyager::Metrics::Lookup<RareVoyager::Counter>("net.accept.count", "accepted connections");
+
+RareVoyager::Gauge::ptr g_conn_gauge =
+	RareVoyager::Metrics::Lookup<RareVoyager::Gauge>("net.connections", "alive connections");
+
+RareVoyager::Histogram::ptr g_latency =
+	RareVoyager::Metrics::Lookup<RareVoyager::Histogram>("net.request.latency_ms", "request latency",
+	                                                     std::vector<double>{1, 5, 10, 50, 100});
+
+void func()
+{
+	for (int i = 0; i < 100000; ++i)
+	{
+		g_accept_count->inc();
+		g_conn_gauge->inc();
+		g_latency->observe(i % 120);
+		g_conn_gauge->dec();
+	}
+}
+
+int main()
+{
+	std::vector<RareVoyager::Thread::ptr> threads;
+	for (int i = 0; i < 4; ++i)
+	{
+		threads.emplace_back(new RareVoyager::Thread(&func, "metrics_" + std::to_string(i)));
+	}
+	for (auto& i: threads)
+	{
+		i->join();
+	}
+
+	// 同名同类型返回同一个实例，类型不同返回 nullptr
+	auto same = RareVoyager::Metrics::Lookup<RareVoyager::Counter>("net.accept.count");
+	auto wrong = RareVoyager::Metrics::Lookup<RareVoyager::Gauge>("net.accept.count");
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "same = " << (same == g_accept_count)
+			<< " wrong = " << (wrong == nullptr) << " count = " << same->getValue();
+
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "\n" << RareVoyager::Metrics::ToYamlString();
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "\n" << RareVoyager::Metrics::ToPrometheusString();
+	RareVoyager::Metrics::DumpToFile("metrics.prom", RareVoyager::Metrics::FORMAT_PROMETHEUS);
+	return 0;
+}
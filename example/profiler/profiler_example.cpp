@@ -0,0 +1,61 @@
+#include <cmath>
+
+#include <include/profiler/profiler.h>
+#include <include/config/config.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+
+static volatile double g_sink = 0;
+
+__attribute__((noinline)) void hot_sqrt(int n)
+{
+	for (int i = 0; i < n; ++i)
+	{
+		g_sink = g_sink + std::sqrt(i);
+	}
+}
+
+__attribute__((noinline)) void hot_sin(int n)
+{
+	for (int i = 0; i < n; ++i)
+	{
+		g_sink = g_sink + std::sin(i);
+	}
+}
+
+void func()
+{
+	for (int i = 0; i < 200; ++i)
+	{
+		// 预期 hot_sin 占大头
+		hot_sqrt(100000);
+		hot_sin(300000);
+	}
+}
+
+int main()
+{
+	// 主线程不是 RareVoyager::Thread，需要手动注册
+	RareVoyager::Profiler::RegisterThread();
+
+	// 通过配置项在运行时开关
+	RareVoyager::Config::LoadFromYaml(YAML::Load("profiler:\n  frequency: 199\n  output: profile.folded\n  enable: true\n"));
+
+	std::vector<RareVoyager::Thread::ptr> threads;
+	for (int i = 0; i < 2; ++i)
+	{
+		threads.emplace_back(new RareVoyager::Thread(&func, "cpu_" + std::to_string(i)));
+	}
+	func();
+	for (auto& i: threads)
+	{
+		i->join();
+	}
+
+	RareVoyager::Config::LoadFromYaml(YAML::Load("profiler:\n  enable: false\n"));
+	RareVoyager::Profiler::UnregisterThread();
+
+	// flamegraph.pl profile.folded > profile.svg
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "\n" << RareVoyager::Profiler::GetFoldedStacks();
+	return 0;
+}
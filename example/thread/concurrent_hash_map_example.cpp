@@ -0,0 +1,137 @@
+#include <cstdlib>
+#include <map>
+#include <string_view>
+
+#include <include/thread/concurrent_hash_map.h>
+#include <include/thread/mutex.h>
+#include <include/thread/thread.h>
+#include <include/config/config.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static const int s_keys = 256;
+
+static std::string key_of(int i)
+{
+	return "registry.key_" + std::to_string(i);
+}
+
+/**
+ * @brief: threads 个线程各查找 ops 次，返回每次查找的平均耗时(纳秒)
+ */
+template<class F>
+double run(int threads, int ops, F lookup)
+{
+	std::vector<RareVoyager::Thread::ptr> workers;
+	std::atomic<uint64_t> found{0};
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back(new RareVoyager::Thread([&lookup, &found, ops, t]() {
+			std::vector<std::string> keys;
+			for (int i = 0; i < s_keys; ++i)
+			{
+				keys.push_back(key_of(i));
+			}
+			uint64_t n = 0;
+			for (int i = 0; i < ops; ++i)
+			{
+				n += lookup(keys[(i + t * 7) % s_keys]);
+			}
+			found.fetch_add(n);
+		}, "lookup_" + std::to_string(t)));
+	}
+	for (auto& w: workers)
+	{
+		w->join();
+	}
+	if (found != static_cast<uint64_t>(threads) * ops)
+	{
+		RAREVOYAGER_LOG_ERROR(g_logger) << "lookup missed " << static_cast<uint64_t>(threads) * ops - found;
+	}
+	return static_cast<double>(RareVoyager::GetMonotonicNS() - begin) / ops;
+}
+
+/**
+ * @brief: 用法 concurrent_hash_map_example [线程数，默认 4]
+ */
+int main(int argc, char** argv)
+{
+	int threads = argc > 1 ? atoi(argv[1]) : 4;
+	const int ops = 2000000;
+
+	// 1. 并发插入、覆盖、删除、查找，最后检查内容
+	RareVoyager::ConcurrentHashMap<std::string, std::shared_ptr<int> > map(8);
+	std::vector<RareVoyager::Thread::ptr> workers;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back(new RareVoyager::Thread([&map, t]() {
+			for (int round = 0; round < 20; ++round)
+			{
+				for (int i = 0; i < 1000; ++i)
+				{
+					std::string key = "t" + std::to_string(t) + "_" + std::to_string(i);
+					map.insertOrAssign(key, std::make_shared<int>(round));
+					std::shared_ptr<int> v;
+					if (!map.find(std::string_view(key), v) || *v != round)
+					{
+						RAREVOYAGER_LOG_ERROR(g_logger) << "lost " << key;
+					}
+					if (i % 3 == 0)
+					{
+						map.erase(key);
+					}
+				}
+			}
+		}, "writer_" + std::to_string(t)));
+	}
+	for (auto& w: workers)
+	{
+		w->join();
+	}
+	size_t visited = 0;
+	map.forEach([&visited](const std::string&, const std::shared_ptr<int>& v) { visited += *v == 19; });
+	RAREVOYAGER_LOG_INFO(g_logger) << "size = " << map.size() << ", visited = " << visited << ", expect = "
+			<< threads * (1000 - 334);
+
+	// 2. 注册表查找: std::map + Mutex、std::map + ShardedRWMutex、ConcurrentHashMap
+	std::map<std::string, std::shared_ptr<int> > plain;
+	RareVoyager::ConcurrentHashMap<std::string, std::shared_ptr<int> > registry;
+	for (int i = 0; i < s_keys; ++i)
+	{
+		plain[key_of(i)] = std::make_shared<int>(i);
+		registry.insert(key_of(i), std::make_shared<int>(i));
+	}
+	RareVoyager::Mutex mutex;
+	RareVoyager::ShardedRWMutex rwmutex;
+	double mutex_ns = run(threads, ops, [&](const std::string& key) {
+		RareVoyager::Mutex::Lock lock(&mutex);
+		auto it = plain.find(key);
+		return it == plain.end() ? 0 : 1;
+	});
+	double rw_ns = run(threads, ops, [&](const std::string& key) {
+		RareVoyager::ShardedRWMutex::ReadLock lock(&rwmutex);
+		auto it = plain.find(key);
+		return it == plain.end() ? 0 : 1;
+	});
+	double map_ns = run(threads, ops, [&](const std::string& key) {
+		std::shared_ptr<int> v;
+		return registry.find(key, v) ? 1 : 0;
+	});
+	RAREVOYAGER_LOG_INFO(g_logger) << threads << " threads, " << s_keys << " keys, ns per lookup: map+Mutex "
+			<< mutex_ns << ", map+ShardedRWMutex " << rw_ns << ", ConcurrentHashMap " << map_ns;
+
+	// 3. 实际的注册表
+	RareVoyager::Config::Lookup("registry.example", 1, "example");
+	double config_ns = run(threads, ops, [](const std::string&) {
+		return RareVoyager::Config::Lookup<int>("registry.example") ? 1 : 0;
+	});
+	double logger_ns = run(threads, ops, [](const std::string&) {
+		return RAREVOYAGER_LOG_NAME("system") ? 1 : 0;
+	});
+	RAREVOYAGER_LOG_INFO(g_logger) << "Config::Lookup " << config_ns << " ns, LogManager::getLogger " << logger_ns
+			<< " ns";
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+#include <include/thread/mutex.h>
+#include <include/thread/thread.h>
+#include <include/metrics/hdr_histogram.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static volatile uint64_t g_shared = 0;
+static std::atomic<bool> g_start{false};
+static std::atomic<bool> g_stop{false};
+
+/**
+ * @brief: MCSLock 的显式节点用法，包装成和其它锁一样的 Lock 类型
+ */
+struct MCSNodeLock : public RareVoyager::MCSLock
+{
+	typedef RareVoyager::MCSLock::NodeLock Lock;
+};
+
+template<class LockT>
+static void worker(LockT* lock, uint64_t* acquisitions, RareVoyager::HdrHistogram* hist)
+{
+	while (!g_start.load(std::memory_order_acquire))
+	{
+		sched_yield();
+	}
+	uint64_t n = 0;
+	while (!g_stop.load(std::memory_order_relaxed))
+	{
+		uint64_t b = (n & 15) ? 0 : RareVoyager::GetMonotonicNS();
+		{
+			typename LockT::Lock l(lock);
+			if (b)
+			{
+				hist->record(RareVoyager::GetMonotonicNS() - b);
+			}
+			++g_shared;
+		}
+		++n;
+	}
+	*acquisitions = n;
+}
+
+/**
+ * @brief: threads 个线程在 ms 毫秒内抢同一把锁，统计每个线程拿到锁的次数
+ * Jain 公平指数 = (Σx)^2 / (n·Σx^2)，1 表示完全平均，1/n 表示一个线程独占
+ */
+template<class LockT>
+void bench(const char* name, int threads, int ms)
+{
+	LockT lock;
+	std::vector<uint64_t> acquisitions(threads);
+	RareVoyager::HdrHistogram hist;
+	std::vector<RareVoyager::Thread::ptr> workers;
+	g_start = false;
+	g_stop = false;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back(new RareVoyager::Thread(std::bind(&worker<LockT>, &lock, &acquisitions[t], &hist),
+		                                             "fair_" + std::to_string(t)));
+	}
+	g_start = true;
+	usleep(ms * 1000);
+	g_stop = true;
+	for (auto& w: workers)
+	{
+		w->join();
+	}
+
+	double sum = 0, sum2 = 0;
+	uint64_t min = UINT64_MAX, max = 0;
+	for (auto a: acquisitions)
+	{
+		sum += a;
+		sum2 += static_cast<double>(a) * a;
+		min = std::min(min, a);
+		max = std::max(max, a);
+	}
+	double jain = sum2 ? sum * sum / (threads * sum2) : 0;
+
+	std::stringstream ss;
+	ss << std::left << std::setw(12) << name << std::right
+			<< std::setw(8) << threads
+			<< std::setw(12) << static_cast<uint64_t>(sum / ms * 1000)
+			<< std::setw(10) << min
+			<< std::setw(10) << max
+			<< std::setw(8) << std::fixed << std::setprecision(3) << jain
+			<< std::setw(10) << hist.getValueAtPercentile(50)
+			<< std::setw(12) << hist.getValueAtPercentile(99)
+			<< std::setw(12) << hist.getMax();
+	RAREVOYAGER_LOG_INFO(g_logger) << ss.str();
+}
+
+/**
+ * @brief: 用法 fair_lock_bench_example [线程数，默认 8] [每组毫秒数，默认 500]
+ * 比较各种锁在竞争下每个线程拿到锁的次数是否平均
+ */
+int main(int argc, char** argv)
+{
+	int threads = argc > 1 ? atoi(argv[1]) : 8;
+	int ms = argc > 2 ? atoi(argv[2]) : 500;
+
+	std::stringstream ss;
+	ss << std::left << std::setw(12) << "lock" << std::right << std::setw(8) << "threads"
+			<< std::setw(12) << "ops/s" << std::setw(10) << "min" << std::setw(10) << "max"
+			<< std::setw(8) << "jain" << std::setw(10) << "p50_ns" << std::setw(12) << "p99_ns"
+			<< std::setw(12) << "max_ns";
+	RAREVOYAGER_LOG_INFO(g_logger) << ss.str();
+
+	bench<RareVoyager::Mutex>("Mutex", threads, ms);
+	bench<RareVoyager::Spinlock>("Spinlock", threads, ms);
+	bench<RareVoyager::CASLock>("CASLock", threads, ms);
+	bench<RareVoyager::TicketLock>("TicketLock", threads, ms);
+	bench<RareVoyager::MCSLock>("MCSLock", threads, ms);
+	bench<MCSNodeLock>("MCSNodeLock", threads, ms);
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include <cstdlib>
+
+#include <include/thread/fiber.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static double ns_per(uint64_t begin, uint64_t n)
+{
+	return static_cast<double>(RareVoyager::GetMonotonicNS() - begin) / n;
+}
+
+/**
+ * @brief: 每个线程: 主协程与两个嵌套的子协程交替执行，日志里的协程 id 随之变化
+ */
+static void nested_demo()
+{
+	RAREVOYAGER_LOG_INFO(g_logger) << "before any fiber, id = " << RareVoyager::Fiber::GetFiberId()
+			<< ", main fiber id = " << RareVoyager::Fiber::GetThis()->getId();
+	RareVoyager::Fiber::ptr inner(new RareVoyager::Fiber([]() {
+		RAREVOYAGER_LOG_INFO(g_logger) << "inner begin";
+		RareVoyager::Fiber::YieldToHold();
+		RAREVOYAGER_LOG_INFO(g_logger) << "inner end";
+	}));
+	RareVoyager::Fiber::ptr outer(new RareVoyager::Fiber([inner]() {
+		RAREVOYAGER_LOG_INFO(g_logger) << "outer begin";
+		inner->resume();
+		RAREVOYAGER_LOG_INFO(g_logger) << "outer back from inner, inner state = " << inner->getState();
+		RareVoyager::Fiber::YieldToReady();
+		inner->resume();
+		RAREVOYAGER_LOG_INFO(g_logger) << "outer end";
+	}));
+	outer->resume();
+	RAREVOYAGER_LOG_INFO(g_logger) << "main back, outer state = " << outer->getState();
+	outer->resume();
+	RAREVOYAGER_LOG_INFO(g_logger) << "done, outer state = " << outer->getState() << ", inner state = "
+			<< inner->getState();
+}
+
+/**
+ * @brief: 用法 fiber_example [切换次数，默认 10000000]
+ */
+int main(int argc, char** argv)
+{
+	uint64_t rounds = argc > 1 ? atoll(argv[1]) : 10000000;
+
+	RareVoyager::Thread::ptr t(new RareVoyager::Thread(nested_demo, "fiber_demo"));
+	t->join();
+	nested_demo();
+
+	// 1. 切换: 每轮一次 resume 一次 yield
+	uint64_t count = 0;
+	RareVoyager::Fiber::ptr pingpong(new RareVoyager::Fiber([&count]() {
+		while (true)
+		{
+			++count;
+			RareVoyager::Fiber::YieldToHold();
+		}
+	}));
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (uint64_t i = 0; i < rounds; ++i)
+	{
+		pingpong->resume();
+	}
+	double switch_ns = ns_per(begin, rounds * 2);
+
+	// 2. 创建、运行、销毁 与 reset 复用栈
+	const uint64_t n = 200000;
+	uint64_t sum = 0;
+	begin = RareVoyager::GetMonotonicNS();
+	for (uint64_t i = 0; i < n; ++i)
+	{
+		RareVoyager::Fiber::ptr f(new RareVoyager::Fiber([&sum, i]() { sum += i; }));
+		f->resume();
+	}
+	double create_ns = ns_per(begin, n);
+
+	RareVoyager::Fiber::ptr reused(new RareVoyager::Fiber(nullptr));
+	begin = RareVoyager::GetMonotonicNS();
+	for (uint64_t i = 0; i < n; ++i)
+	{
+		reused->reset([&sum, i]() { sum += i; });
+		reused->resume();
+	}
+	double reset_ns = ns_per(begin, n);
+
+	// 3. 挂起中的协程被析构时展开栈上的对象
+	struct Guard
+	{
+		bool* flag;
+
+		~Guard() { *flag = true; }
+	};
+	bool unwound = false;
+	{
+		RareVoyager::Fiber::ptr f(new RareVoyager::Fiber([&unwound]() {
+			Guard g{&unwound};
+			RareVoyager::Fiber::YieldToHold();
+		}));
+		f->resume();
+	}
+
+	RAREVOYAGER_LOG_INFO(g_logger) << "switch " << switch_ns << " ns (count = " << count << "), create+run+destroy "
+			<< create_ns << " ns, reset+run " << reset_ns << " ns, sum = " << sum << " (expect "
+			<< (n - 1) * n << "), suspended fiber unwound = " << unwound << ", alive fibers = "
+			<< RareVoyager::Fiber::TotalFibers();
+	return 0;
+}
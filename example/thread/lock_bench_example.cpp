@@ -0,0 +1,108 @@
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#include <include/thread/mutex.h>
+#include <include/thread/thread.h>
+#include <include/metrics/hdr_histogram.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+// 临界区内写的共享数据，占两条缓存行
+static volatile uint64_t g_shared[16];
+// 每隔多少次加锁测一次等待时间，避免读时钟的开销淹没结果
+static const int s_sample_interval = 16;
+
+static void critical_section()
+{
+	for (int i = 0; i < 16; i += 8)
+	{
+		++g_shared[i];
+	}
+}
+
+static void outside_work()
+{
+	volatile uint64_t sink = 0;
+	for (int i = 0; i < 50; ++i)
+	{
+		sink += i;
+	}
+}
+
+/**
+ * @brief: threads 个线程共做 total_ops 次加锁，返回吞吐量(万次/秒)，并把加锁等待时间写入 hist
+ */
+template<class LockT>
+double run(int threads, int total_ops, RareVoyager::HdrHistogram& hist)
+{
+	LockT lock;
+	int ops = total_ops / threads;
+	std::vector<RareVoyager::Thread::ptr> workers;
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back(new RareVoyager::Thread([&lock, &hist, ops]() {
+			for (int i = 0; i < ops; ++i)
+			{
+				if (i % s_sample_interval == 0)
+				{
+					uint64_t b = RareVoyager::GetMonotonicNS();
+					typename LockT::Lock l(&lock);
+					hist.record(RareVoyager::GetMonotonicNS() - b);
+					critical_section();
+				}
+				else
+				{
+					typename LockT::Lock l(&lock);
+					critical_section();
+				}
+				outside_work();
+			}
+		}, "bench_" + std::to_string(t)));
+	}
+	for (auto& w: workers)
+	{
+		w->join();
+	}
+	uint64_t elapsed = RareVoyager::GetMonotonicNS() - begin;
+	return static_cast<double>(ops) * threads / elapsed * 1e9 / 1e4;
+}
+
+template<class LockT>
+void bench(const char* name, int total_ops)
+{
+	static const int s_threads[] = {2, 4, 8, 16, 32, 64};
+	std::stringstream ss;
+	ss << "\n" << std::left << std::setw(10) << name << std::right
+			<< std::setw(8) << "threads" << std::setw(12) << "万次/秒"
+			<< std::setw(10) << "p50_ns" << std::setw(10) << "p99_ns" << std::setw(12) << "p99.9_ns"
+			<< std::setw(12) << "max_ns";
+	for (int threads: s_threads)
+	{
+		RareVoyager::HdrHistogram hist;
+		double throughput = run<LockT>(threads, total_ops, hist);
+		ss << "\n" << std::setw(10) << "" << std::setw(8) << threads
+				<< std::setw(12) << std::fixed << std::setprecision(1) << throughput
+				<< std::setw(10) << hist.getValueAtPercentile(50)
+				<< std::setw(10) << hist.getValueAtPercentile(99)
+				<< std::setw(12) << hist.getValueAtPercentile(99.9)
+				<< std::setw(12) << hist.getMax();
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << ss.str();
+}
+
+/**
+ * @brief: 用法 lock_bench_example [每组总加锁次数，默认 2000000]
+ * 比较 Mutex、Spinlock 与自适应 CASLock 在 2~64 个线程下的吞吐和加锁等待时间分布
+ */
+int main(int argc, char** argv)
+{
+	int total_ops = argc > 1 ? atoi(argv[1]) : 2000000;
+	bench<RareVoyager::Mutex>("Mutex", total_ops);
+	bench<RareVoyager::Spinlock>("Spinlock", total_ops);
+	bench<RareVoyager::CASLock>("CASLock", total_ops);
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include <include/thread/lock_profiler.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static volatile uint64_t g_count = 0;
+RareVoyager::NamedMutex g_hot_mutex("example.hot");
+RareVoyager::NamedSpinlock g_cold_lock("example.cold");
+RareVoyager::NamedRWMutex g_rw_mutex("example.rw");
+
+void hot_path()
+{
+	for (int i = 0; i < 200000; ++i)
+	{
+		RareVoyager::NamedMutex::Lock lock(&g_hot_mutex);
+		++g_count;
+	}
+}
+
+void cold_path()
+{
+	for (int i = 0; i < 1000; ++i)
+	{
+		RareVoyager::NamedSpinlock::Lock lock(&g_cold_lock);
+		++g_count;
+	}
+}
+
+void rw_path()
+{
+	for (int i = 0; i < 100000; ++i)
+	{
+		if (i % 16)
+		{
+			RareVoyager::NamedRWMutex::ReadLock lock(&g_rw_mutex);
+			(void)g_count;
+		}
+		else
+		{
+			RareVoyager::NamedRWMutex::WriteLock lock(&g_rw_mutex);
+			++g_count;
+		}
+	}
+}
+
+void func()
+{
+	hot_path();
+	cold_path();
+	rw_path();
+}
+
+/**
+ * @brief: 对比默认策略与统计策略下一次无竞争加解锁的开销
+ */
+void overhead()
+{
+	const int n = 1000000;
+	RareVoyager::Mutex plain;
+	RareVoyager::NamedMutex named("example.overhead");
+
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < n; ++i)
+	{
+		RareVoyager::Mutex::Lock lock(&plain);
+	}
+	uint64_t plain_ns = RareVoyager::GetMonotonicNS() - begin;
+
+	begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < n; ++i)
+	{
+		RareVoyager::NamedMutex::Lock lock(&named);
+	}
+	uint64_t named_ns = RareVoyager::GetMonotonicNS() - begin;
+
+	RAREVOYAGER_LOG_INFO(g_logger) << "uncontended lock/unlock: Mutex " << plain_ns / (double)n
+			<< " ns, NamedMutex " << named_ns / (double)n << " ns";
+}
+
+int main()
+{
+	overhead();
+
+	std::vector<RareVoyager::Thread::ptr> threads;
+	for (int i = 0; i < 4; ++i)
+	{
+		threads.emplace_back(new RareVoyager::Thread(&func, "worker_" + std::to_string(i)));
+	}
+	for (auto& t: threads)
+	{
+		t->join();
+	}
+
+	RAREVOYAGER_LOG_INFO(g_logger) << "count = " << g_count << "\n"
+			<< RareVoyager::LockProfiler::Report(5, 2);
+	return 0;
+}
@@ -0,0 +1,269 @@
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <sstream>
+
+#include <sched.h>
+
+#include <include/thread/lockfree_queue.h>
+#include <include/thread/mutex.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static const size_t s_capacity = 1024;
+static const size_t s_batch = 32;
+
+/**
+ * @brief: Mutex 保护的有界 std::deque，作为对照组
+ */
+class MutexDeque
+{
+public:
+	typedef uint64_t value_type;
+
+	explicit MutexDeque(size_t capacity) : m_capacity(capacity)
+	{
+	}
+
+	bool tryPush(uint64_t v)
+	{
+		RareVoyager::Mutex::Lock lock(&m_mutex);
+		if (m_items.size() >= m_capacity)
+		{
+			return false;
+		}
+		m_items.push_back(v);
+		return true;
+	}
+
+	bool tryPop(uint64_t& v)
+	{
+		RareVoyager::Mutex::Lock lock(&m_mutex);
+		if (m_items.empty())
+		{
+			return false;
+		}
+		v = m_items.front();
+		m_items.pop_front();
+		return true;
+	}
+
+	size_t tryPushN(uint64_t* items, size_t n)
+	{
+		RareVoyager::Mutex::Lock lock(&m_mutex);
+		size_t k = 0;
+		for (; k < n && m_items.size() < m_capacity; ++k)
+		{
+			m_items.push_back(items[k]);
+		}
+		return k;
+	}
+
+	size_t tryPopN(uint64_t* items, size_t n)
+	{
+		RareVoyager::Mutex::Lock lock(&m_mutex);
+		size_t k = 0;
+		for (; k < n && !m_items.empty(); ++k)
+		{
+			items[k] = m_items.front();
+			m_items.pop_front();
+		}
+		return k;
+	}
+
+private:
+	size_t m_capacity;
+	RareVoyager::Mutex m_mutex;
+	std::deque<uint64_t> m_items;
+};
+
+/**
+ * @brief: 非阻塞队列满或空时让出 CPU 重试
+ */
+template<class Q>
+struct SpinAdapter
+{
+	explicit SpinAdapter(size_t capacity) : queue(capacity)
+	{
+	}
+
+	void push(uint64_t v)
+	{
+		while (!queue.tryPush(v))
+		{
+			sched_yield();
+		}
+	}
+
+	uint64_t pop()
+	{
+		uint64_t v;
+		while (!queue.tryPop(v))
+		{
+			sched_yield();
+		}
+		return v;
+	}
+
+	void pushN(uint64_t* items, size_t n)
+	{
+		while (n)
+		{
+			size_t k = queue.tryPushN(items, n);
+			if (!k)
+			{
+				sched_yield();
+			}
+			items += k;
+			n -= k;
+		}
+	}
+
+	size_t popN(uint64_t* items, size_t n)
+	{
+		size_t k;
+		while (!(k = queue.tryPopN(items, n)))
+		{
+			sched_yield();
+		}
+		return k;
+	}
+
+	Q queue;
+};
+
+template<class Q>
+struct BlockingAdapter
+{
+	explicit BlockingAdapter(size_t capacity) : queue(capacity)
+	{
+	}
+
+	void push(uint64_t v) { queue.push(v); }
+
+	uint64_t pop() { return queue.pop(); }
+
+	void pushN(uint64_t* items, size_t n) { queue.pushN(items, n); }
+
+	size_t popN(uint64_t* items, size_t n) { return queue.popN(items, n); }
+
+	RareVoyager::BlockingQueue<Q> queue;
+};
+
+/**
+ * @brief: producers 个线程共写入 total 个数，consumers 个线程平分读出，返回吞吐量(万个/秒)
+ * 读出的和与写入的和不一致时打错误日志
+ */
+template<class AdapterT>
+double run(int producers, int consumers, uint64_t total, bool batch)
+{
+	AdapterT adapter(s_capacity);
+	std::atomic<uint64_t> sum{0};
+	std::vector<RareVoyager::Thread::ptr> threads;
+	uint64_t per_producer = total / producers;
+	uint64_t per_consumer = total / consumers;
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int c = 0; c < consumers; ++c)
+	{
+		threads.emplace_back(new RareVoyager::Thread([&adapter, &sum, per_consumer, batch]() {
+			uint64_t local = 0;
+			uint64_t items[s_batch];
+			for (uint64_t i = 0; i < per_consumer;)
+			{
+				if (batch)
+				{
+					size_t k = adapter.popN(items, std::min<uint64_t>(s_batch, per_consumer - i));
+					for (size_t j = 0; j < k; ++j)
+					{
+						local += items[j];
+					}
+					i += k;
+				}
+				else
+				{
+					local += adapter.pop();
+					++i;
+				}
+			}
+			sum.fetch_add(local);
+		}, "consumer_" + std::to_string(c)));
+	}
+	for (int p = 0; p < producers; ++p)
+	{
+		threads.emplace_back(new RareVoyager::Thread([&adapter, p, per_producer, batch]() {
+			uint64_t base = p * per_producer;
+			uint64_t items[s_batch];
+			for (uint64_t i = 0; i < per_producer;)
+			{
+				if (batch)
+				{
+					size_t k = std::min<uint64_t>(s_batch, per_producer - i);
+					for (size_t j = 0; j < k; ++j)
+					{
+						items[j] = base + i + j + 1;
+					}
+					adapter.pushN(items, k);
+					i += k;
+				}
+				else
+				{
+					adapter.push(base + i + 1);
+					++i;
+				}
+			}
+		}, "producer_" + std::to_string(p)));
+	}
+	for (auto& t: threads)
+	{
+		t->join();
+	}
+	uint64_t elapsed = RareVoyager::GetMonotonicNS() - begin;
+	uint64_t n = per_producer * producers;
+	if (sum != n * (n + 1) / 2)
+	{
+		RAREVOYAGER_LOG_ERROR(g_logger) << "sum mismatch: " << sum << " != " << n * (n + 1) / 2;
+	}
+	return static_cast<double>(total) / elapsed * 1e9 / 1e4;
+}
+
+/**
+ * @brief: 用法 queue_bench_example [最大线程数，默认 8] [元素个数，默认 1048576]
+ * 生产者与消费者数相同，从 1 翻倍到最大线程数
+ */
+int main(int argc, char** argv)
+{
+	int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+	uint64_t total = argc > 2 ? strtoull(argv[2], nullptr, 10) : (1 << 20);
+
+	std::stringstream ss;
+	ss << "\n" << std::left << std::setw(12) << "P x C" << std::right
+			<< std::setw(14) << "mutex deque" << std::setw(14) << "mutex batch"
+			<< std::setw(12) << "mpmc" << std::setw(14) << "mpmc batch"
+			<< std::setw(16) << "mpmc blocking" << std::setw(12) << "spsc"
+			<< std::setw(14) << "spsc batch" << "   (万个/秒)";
+	for (int n = 1; n <= max_threads; n <<= 1)
+	{
+		typedef SpinAdapter<MutexDeque> MutexAdapter;
+		typedef SpinAdapter<RareVoyager::MPMCQueue<uint64_t> > MPMCAdapter;
+		typedef BlockingAdapter<RareVoyager::MPMCQueue<uint64_t> > MPMCBlocking;
+		typedef SpinAdapter<RareVoyager::SPSCQueue<uint64_t> > SPSCAdapter;
+		uint64_t items = total / n * n;
+		ss << "\n" << std::left << std::setw(12) << (std::to_string(n) + " x " + std::to_string(n)) << std::right
+				<< std::fixed << std::setprecision(1)
+				<< std::setw(14) << run<MutexAdapter>(n, n, items, false)
+				<< std::setw(14) << run<MutexAdapter>(n, n, items, true)
+				<< std::setw(12) << run<MPMCAdapter>(n, n, items, false)
+				<< std::setw(14) << run<MPMCAdapter>(n, n, items, true)
+				<< std::setw(16) << run<MPMCBlocking>(n, n, items, false);
+		if (n == 1)
+		{
+			ss << std::setw(12) << run<SPSCAdapter>(1, 1, items, false)
+					<< std::setw(14) << run<SPSCAdapter>(1, 1, items, true);
+		}
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << ss.str();
+	return 0;
+}
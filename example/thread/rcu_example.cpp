@@ -0,0 +1,137 @@
+#include <cstdlib>
+
+#include <include/thread/rcu.h>
+#include <include/thread/mutex.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+/**
+ * @brief: 写者每次发布时 a、b 相同，读者看到不同说明读到了正在修改或已经释放的对象
+ */
+struct Snapshot
+{
+	uint64_t a = 0;
+	std::vector<uint64_t> data = std::vector<uint64_t>(16);
+	uint64_t b = 0;
+};
+
+static double ns_since(uint64_t begin, uint64_t ops)
+{
+	return static_cast<double>(RareVoyager::GetMonotonicNS() - begin) / ops;
+}
+
+/**
+ * @brief: 用法 rcu_example [读线程数，默认 4]
+ */
+int main(int argc, char** argv)
+{
+	int readers = argc > 1 ? atoi(argv[1]) : 4;
+	RAREVOYAGER_LOG_INFO(g_logger) << "membarrier = " << RareVoyager::Rcu::UseMembarrier();
+
+	// 1. 读者不停读取，写者不停复制修改发布
+	RareVoyager::RcuPtr<Snapshot> ptr(new Snapshot);
+	std::atomic<bool> stop{false};
+	std::atomic<uint64_t> reads{0};
+	std::atomic<uint64_t> torn{0};
+	std::vector<RareVoyager::Thread::ptr> threads;
+	for (int i = 0; i < readers; ++i)
+	{
+		threads.emplace_back(new RareVoyager::Thread([&]() {
+			uint64_t n = 0;
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				RareVoyager::RcuReadLock lock;
+				const Snapshot* s = ptr.load();
+				if (s->a != s->b || s->data[15] != s->a)
+				{
+					torn.fetch_add(1);
+				}
+				++n;
+			}
+			reads.fetch_add(n);
+		}, "reader_" + std::to_string(i)));
+	}
+	const uint64_t updates = 20000;
+	for (uint64_t i = 1; i <= updates; ++i)
+	{
+		ptr.update([i](Snapshot& s) {
+			s.a = i;
+			s.data.assign(16, i);
+			s.b = i;
+		});
+	}
+	stop = true;
+	for (auto& t: threads)
+	{
+		t->join();
+	}
+	size_t pending = RareVoyager::Rcu::GetPendingCount();
+	RareVoyager::Rcu::Barrier();
+	RAREVOYAGER_LOG_INFO(g_logger) << updates << " updates, " << reads << " reads, torn = " << torn
+			<< ", pending before barrier = " << pending << ", after = " << RareVoyager::Rcu::GetPendingCount();
+
+	// 2. 单线程读开销: RCU 读临界区 对比 读写锁的读锁
+	const uint64_t ops = 20000000;
+	volatile uint64_t sink = 0;
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (uint64_t i = 0; i < ops; ++i)
+	{
+		RareVoyager::RcuReadLock lock;
+		sink += ptr.load()->a;
+	}
+	double rcu_ns = ns_since(begin, ops);
+
+	RareVoyager::RWMutex rwmutex;
+	Snapshot plain;
+	begin = RareVoyager::GetMonotonicNS();
+	for (uint64_t i = 0; i < ops; ++i)
+	{
+		RareVoyager::RWMutex::ReadLock lock(&rwmutex);
+		sink += plain.a;
+	}
+	double rw_ns = ns_since(begin, ops);
+
+	RareVoyager::ShardedRWMutex sharded;
+	begin = RareVoyager::GetMonotonicNS();
+	for (uint64_t i = 0; i < ops; ++i)
+	{
+		RareVoyager::ShardedRWMutex::ReadLock lock(&sharded);
+		sink += plain.a;
+	}
+	double sharded_ns = ns_since(begin, ops);
+	RAREVOYAGER_LOG_INFO(g_logger) << "read side: rcu " << rcu_ns << " ns, RWMutex " << rw_ns
+			<< " ns, ShardedRWMutex " << sharded_ns << " ns";
+
+	// 3. 写日志的同时增删 Appender
+	RareVoyager::Logger::ptr logger = RAREVOYAGER_LOG_NAME("rcu");
+	logger->setLevel(RareVoyager::LogLevel::ERROR);
+	// 保持至少一个 Appender，避免转发给 root 打到控制台
+	logger->addAppender(RareVoyager::LogAppender::ptr(new RareVoyager::FileLogAppender("/dev/null")));
+	stop = false;
+	threads.clear();
+	for (int i = 0; i < readers; ++i)
+	{
+		threads.emplace_back(new RareVoyager::Thread([&]() {
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				RAREVOYAGER_LOG_FATAL(logger) << "";
+			}
+		}, "logger_" + std::to_string(i)));
+	}
+	for (int i = 0; i < 2000; ++i)
+	{
+		RareVoyager::LogAppender::ptr appender(new RareVoyager::FileLogAppender("/dev/null"));
+		logger->addAppender(appender);
+		logger->delAppender(appender);
+	}
+	stop = true;
+	for (auto& t: threads)
+	{
+		t->join();
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << "2000 appender add/del while logging done";
+	return 0;
+}
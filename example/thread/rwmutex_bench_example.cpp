@@ -0,0 +1,90 @@
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+#include <include/thread/mutex.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static volatile uint64_t g_value = 0;
+
+/**
+ * @brief: threads 个读者各做 ops 次读锁；writer 为真时另有一个线程每 1ms 加一次写锁
+ * 返回所有读者合计的吞吐量(百万次/秒)
+ */
+template<class RWMutexT>
+double run(int threads, int ops, bool writer)
+{
+	RWMutexT mutex;
+	std::atomic<bool> stop{false};
+	RareVoyager::Thread::ptr w;
+	if (writer)
+	{
+		w.reset(new RareVoyager::Thread([&mutex, &stop]() {
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				{
+					typename RWMutexT::WriteLock lock(&mutex);
+					++g_value;
+				}
+				usleep(1000);
+			}
+		}, "rw_writer"));
+	}
+
+	std::vector<RareVoyager::Thread::ptr> readers;
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int t = 0; t < threads; ++t)
+	{
+		readers.emplace_back(new RareVoyager::Thread([&mutex, ops]() {
+			uint64_t sink = 0;
+			for (int i = 0; i < ops; ++i)
+			{
+				typename RWMutexT::ReadLock lock(&mutex);
+				sink += g_value;
+			}
+			(void)sink;
+		}, "rw_reader_" + std::to_string(t)));
+	}
+	for (auto& r: readers)
+	{
+		r->join();
+	}
+	uint64_t elapsed = RareVoyager::GetMonotonicNS() - begin;
+	stop = true;
+	if (w)
+	{
+		w->join();
+	}
+	return static_cast<double>(threads) * ops / elapsed * 1e3;
+}
+
+/**
+ * @brief: 用法 rwmutex_bench_example [每个读者的次数，默认 2000000]
+ * 比较 RWMutex(pthread_rwlock) 与 ShardedRWMutex 的读锁扩展性，线程数从 1 增加到 CPU 核数的两倍
+ */
+int main(int argc, char** argv)
+{
+	int ops = argc > 1 ? atoi(argv[1]) : 2000000;
+	int max_threads = std::max(2u, std::thread::hardware_concurrency() * 2);
+
+	std::stringstream ss;
+	ss << "\n" << std::setw(8) << "readers"
+			<< std::setw(14) << "RWMutex" << std::setw(14) << "Sharded"
+			<< std::setw(16) << "RWMutex+w" << std::setw(16) << "Sharded+w" << "   (Mops/s)";
+	for (int threads = 1; threads <= max_threads; threads *= 2)
+	{
+		ss << "\n" << std::setw(8) << threads << std::fixed << std::setprecision(1)
+				<< std::setw(14) << run<RareVoyager::RWMutex>(threads, ops, false)
+				<< std::setw(14) << run<RareVoyager::ShardedRWMutex>(threads, ops, false)
+				<< std::setw(16) << run<RareVoyager::RWMutex>(threads, ops, true)
+				<< std::setw(16) << run<RareVoyager::ShardedRWMutex>(threads, ops, true);
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << ss.str();
+	return 0;
+}
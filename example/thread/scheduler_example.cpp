@@ -0,0 +1,141 @@
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+#include <include/thread/scheduler.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static double ms_since(uint64_t begin)
+{
+	return (RareVoyager::GetMonotonicNS() - begin) / 1e6;
+}
+
+static double cpu_ms()
+{
+	timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/**
+ * @brief: 递归拆分，在工作线程里调度的任务进本线程队列，由空闲线程窃取
+ */
+static void spawn_tree(RareVoyager::Scheduler* sc, std::atomic<uint64_t>* leaves, int depth)
+{
+	if (!depth)
+	{
+		leaves->fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	sc->schedule([sc, leaves, depth]() { spawn_tree(sc, leaves, depth - 1); });
+	sc->schedule([sc, leaves, depth]() { spawn_tree(sc, leaves, depth - 1); });
+}
+
+/**
+ * @brief: 用法 scheduler_example [工作线程数，默认 4] [任务数，默认 1000000]
+ */
+int main(int argc, char** argv)
+{
+	size_t threads = argc > 1 ? atoi(argv[1]) : 4;
+	uint64_t tasks = argc > 2 ? atoll(argv[2]) : 1000000;
+
+	RareVoyager::Scheduler sc(threads, false, "sched");
+	sc.start();
+
+	// 1. 外部线程投递回调
+	std::atomic<uint64_t> done{0};
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (uint64_t i = 0; i < tasks; ++i)
+	{
+		sc.schedule([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+	}
+	while (sc.getTaskCount())
+	{
+		usleep(100);
+	}
+	double external_ms = ms_since(begin);
+
+	// 2. 工作线程里递归调度，靠窃取分摊
+	std::atomic<uint64_t> leaves{0};
+	const int depth = 18;
+	begin = RareVoyager::GetMonotonicNS();
+	sc.schedule([&sc, &leaves]() { spawn_tree(&sc, &leaves, depth); });
+	while (sc.getTaskCount())
+	{
+		usleep(100);
+	}
+	double tree_ms = ms_since(begin);
+
+	// 3. 协程 yield: 每个协程让出 1000 次，检查指定线程的任务只在该线程执行
+	std::atomic<uint64_t> yields{0};
+	std::atomic<uint64_t> wrong_thread{0};
+	const int fibers = 100;
+	begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < fibers; ++i)
+	{
+		int pin = i % 3 == 0 ? static_cast<int>(i % threads) : -1;
+		sc.schedule(RareVoyager::Fiber::ptr(new RareVoyager::Fiber([&, pin]() {
+			for (int k = 0; k < 1000; ++k)
+			{
+				if (pin >= 0 && RareVoyager::Scheduler::GetWorkerIndex() != pin)
+				{
+					wrong_thread.fetch_add(1, std::memory_order_relaxed);
+				}
+				yields.fetch_add(1, std::memory_order_relaxed);
+				RareVoyager::Fiber::YieldToReady();
+			}
+		})), pin);
+	}
+	while (sc.getTaskCount())
+	{
+		usleep(100);
+	}
+	double yield_ms = ms_since(begin);
+
+	// 4. HOLD 的协程由另一个任务唤醒
+	std::atomic<int> woken{0};
+	RareVoyager::Fiber::ptr sleeper(new RareVoyager::Fiber([&woken]() {
+		RareVoyager::Fiber::YieldToHold();
+		woken = 1;
+	}));
+	sc.schedule(sleeper);
+	while (sleeper->getState() != RareVoyager::Fiber::HOLD)
+	{
+		usleep(100);
+	}
+	sc.schedule([&sc, sleeper]() { sc.schedule(sleeper); });
+
+	// 5. 空闲时不占 CPU
+	usleep(20000);
+	double cpu_before = cpu_ms();
+	usleep(200000);
+	double idle_cpu = cpu_ms() - cpu_before;
+
+	RAREVOYAGER_LOG_INFO(g_logger) << threads << " workers: " << tasks << " external tasks " << external_ms
+			<< " ms (" << external_ms * 1e6 / tasks << " ns/task, done = " << done << "); tree of "
+			<< (1u << depth) << " leaves " << tree_ms << " ms (leaves = " << leaves << "); " << fibers * 1000
+			<< " yields " << yield_ms << " ms (" << yield_ms * 1e6 / (fibers * 1000) << " ns/yield, count = "
+			<< yields << ", wrong thread = " << wrong_thread << "); hold fiber woken = " << woken
+			<< "; cpu while idle 200ms = " << idle_cpu << " ms";
+	RAREVOYAGER_LOG_INFO(g_logger) << sc.statsToString();
+	sc.stop();
+
+	// 6. use_caller: 调用者线程在 stop 时加入执行
+	RareVoyager::Scheduler caller(2, true, "caller");
+	caller.start();
+	std::atomic<uint64_t> on_caller{0};
+	std::atomic<uint64_t> total{0};
+	for (int i = 0; i < 1000; ++i)
+	{
+		caller.schedule([&]() {
+			total.fetch_add(1);
+			on_caller += RareVoyager::Scheduler::GetWorkerIndex() == 0;
+		}, i % 2 ? 0 : -1);
+	}
+	caller.stop();
+	RAREVOYAGER_LOG_INFO(g_logger) << "use_caller: total = " << total << ", on caller thread = " << on_caller;
+	return 0;
+}
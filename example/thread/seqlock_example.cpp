@@ -0,0 +1,83 @@
+#include <include/thread/seqlock.h>
+#include <include/thread/thread.h>
+#include <include/config/config.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+struct Point
+{
+	uint64_t x;
+	uint64_t y;
+	uint64_t z;
+};
+
+static RareVoyager::SeqLock<Point> g_point(Point{0, 0, 0});
+static std::atomic<bool> g_stop{false};
+static std::atomic<uint64_t> g_torn{0};
+
+/**
+ * @brief: 写者一直写 x、2x、3x，读者检查读到的三个值是否属于同一次写入
+ */
+void writer()
+{
+	for (uint64_t i = 1; !g_stop.load(std::memory_order_relaxed); ++i)
+	{
+		g_point.store(Point{i, i * 2, i * 3});
+	}
+}
+
+void reader()
+{
+	for (int i = 0; i < 2000000; ++i)
+	{
+		Point p = g_point.load();
+		if (p.y != p.x * 2 || p.z != p.x * 3)
+		{
+			++g_torn;
+		}
+	}
+}
+
+/**
+ * @brief: 对比 ConfigVar 两种存储策略的读取开销
+ */
+template<class VarT>
+double read_cost(VarT& var)
+{
+	const int n = 10000000;
+	uint64_t sink = 0;
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < n; ++i)
+	{
+		sink += var.getValue();
+	}
+	uint64_t elapsed = RareVoyager::GetMonotonicNS() - begin;
+	return sink ? elapsed / (double)n : 0;
+}
+
+int main()
+{
+	RareVoyager::Thread::ptr w(new RareVoyager::Thread(&writer, "writer"));
+	std::vector<RareVoyager::Thread::ptr> readers;
+	for (int i = 0; i < 4; ++i)
+	{
+		readers.emplace_back(new RareVoyager::Thread(&reader, "reader_" + std::to_string(i)));
+	}
+	for (auto& r: readers)
+	{
+		r->join();
+	}
+	g_stop = true;
+	w->join();
+	RAREVOYAGER_LOG_INFO(g_logger) << "torn reads: " << g_torn << " last x: " << g_point.load().x;
+
+	RareVoyager::ConfigVar<uint64_t> seq_var("example.seq", 1);
+	RareVoyager::ConfigVar<uint64_t, RareVoyager::LexicalCast<std::string, uint64_t>,
+		RareVoyager::LexicalCast<uint64_t, std::string>,
+		RareVoyager::RWMutexConfigStorage<uint64_t> > rw_var("example.rw", 1);
+	RAREVOYAGER_LOG_INFO(g_logger) << "ConfigVar<uint64_t>::getValue SeqLock " << read_cost(seq_var)
+			<< " ns, RWMutex " << read_cost(rw_var) << " ns";
+	return 0;
+}
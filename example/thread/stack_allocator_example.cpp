@@ -0,0 +1,129 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <include/thread/stack_allocator.h>
+#include <include/thread/fiber.h>
+#include <include/config/config.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static double ns_per(uint64_t begin, uint64_t n)
+{
+	return static_cast<double>(RareVoyager::GetMonotonicNS() - begin) / n;
+}
+
+/**
+ * @brief: 进程常驻内存，单位 KB
+ */
+static size_t rss_kb()
+{
+	long pages = 0;
+	long resident = 0;
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (f)
+	{
+		if (fscanf(f, "%ld %ld", &pages, &resident) != 2)
+		{
+			resident = 0;
+		}
+		fclose(f);
+	}
+	return resident * RareVoyager::StackAllocator::GetPageSize() / 1024;
+}
+
+/**
+ * @brief: 每层递归占用约 1KB 栈
+ */
+static int recurse(int depth)
+{
+	volatile char buf[1024];
+	memset(const_cast<char*>(buf), depth, sizeof(buf));
+	return depth ? recurse(depth - 1) + buf[depth % sizeof(buf)] : 0;
+}
+
+/**
+ * @brief: 用法 stack_allocator_example [协程数，默认 20000]
+ */
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? atoi(argv[1]) : 20000;
+	size_t stack_size = RareVoyager::StackAllocator::GetDefaultStackSize();
+
+	// 1. 分配、释放: 第一轮走 mmap，释放后进缓存，第二轮直接复用
+	{
+		const size_t n = 200;
+		std::vector<void*> stacks;
+		uint64_t begin = RareVoyager::GetMonotonicNS();
+		for (size_t i = 0; i < n; ++i)
+		{
+			stacks.push_back(RareVoyager::StackAllocator::Alloc(stack_size));
+		}
+		double mmap_ns = ns_per(begin, n);
+		for (auto s: stacks)
+		{
+			RareVoyager::StackAllocator::Dealloc(s, stack_size);
+		}
+		size_t pooled = RareVoyager::StackAllocator::GetPooledCount();
+		begin = RareVoyager::GetMonotonicNS();
+		for (size_t i = 0; i < n; ++i)
+		{
+			stacks[i] = RareVoyager::StackAllocator::Alloc(stack_size);
+		}
+		double pooled_ns = ns_per(begin, n);
+		for (auto s: stacks)
+		{
+			RareVoyager::StackAllocator::Dealloc(s, stack_size);
+		}
+		RAREVOYAGER_LOG_INFO(g_logger) << "stack " << stack_size / 1024 << " KB: mmap alloc " << mmap_ns
+				<< " ns, pooled alloc " << pooled_ns << " ns, pooled after free = " << pooled;
+	}
+
+	// 2. 大量挂起的协程，物理内存只按实际用到的页计算
+	{
+		size_t rss_before = rss_kb();
+		std::vector<RareVoyager::Fiber::ptr> fibers;
+		fibers.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			fibers.emplace_back(new RareVoyager::Fiber([]() { RareVoyager::Fiber::YieldToHold(); }));
+			fibers.back()->resume();
+		}
+		size_t rss_after = rss_kb();
+		RAREVOYAGER_LOG_INFO(g_logger) << count << " suspended fibers: virtual " << count * stack_size / 1024 / 1024
+				<< " MB, rss +" << (rss_after - rss_before) / 1024 << " MB ("
+				<< (rss_after - rss_before) * 1024 / count << " bytes/fiber), mapped stacks = "
+				<< RareVoyager::StackAllocator::GetMappedCount();
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << "after free: mapped stacks = " << RareVoyager::StackAllocator::GetMappedCount()
+			<< ", pooled = " << RareVoyager::StackAllocator::GetPooledCount();
+
+	// 3. 高水位: 递归 40 层约 40KB
+	RareVoyager::Config::Lookup<bool>("fiber.stack_high_water")->setValue(true);
+	{
+		RareVoyager::Fiber::ptr f(new RareVoyager::Fiber([]() { recurse(40); }));
+		f->resume();
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << "high water after recursing ~40KB: "
+			<< RareVoyager::StackAllocator::GetHighWater() / 1024 << " KB";
+
+	// 4. 保护页: 子进程里在 16KB 的栈上递归 64 层，应当被 SIGSEGV 终止
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		RareVoyager::Fiber::ptr f(new RareVoyager::Fiber([]() { recurse(64); }, 16 * 1024));
+		f->resume();
+		_exit(0);
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+	RAREVOYAGER_LOG_INFO(g_logger) << "stack overflow child: "
+			<< (WIFSIGNALED(status) ? strsignal(WTERMSIG(status)) : "exited normally");
+	return 0;
+}
@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstdlib>
+
+#include <include/thread/task_scheduler.h>
+#include <include/thread/thread_pool.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static double ms_since(uint64_t begin)
+{
+	return (RareVoyager::GetMonotonicNS() - begin) / 1e6;
+}
+
+uint64_t fib_seq(int n)
+{
+	return n < 2 ? n : fib_seq(n - 1) + fib_seq(n - 2);
+}
+
+/**
+ * @brief: 递归拆分的斐波那契，每一层都是一个细粒度任务
+ */
+uint64_t fib_task(int n)
+{
+	if (n < 16)
+	{
+		return fib_seq(n);
+	}
+	uint64_t a = 0;
+	RareVoyager::TaskGroup group;
+	group.run([&a, n]() { a = fib_task(n - 1); });
+	uint64_t b = fib_task(n - 2);
+	group.wait();
+	return a + b;
+}
+
+/**
+ * @brief: 用法 task_scheduler_example [线程数，默认 CPU 核数]
+ */
+int main(int argc, char** argv)
+{
+	uint32_t threads = argc > 1 ? atoi(argv[1]) : 0;
+	RareVoyager::TaskScheduler scheduler("ws", threads);
+	RareVoyager::ThreadPool pool("pool", scheduler.getWorkerCount());
+	RAREVOYAGER_LOG_INFO(g_logger) << "workers = " << scheduler.getWorkerCount();
+
+	// 1. 递归任务
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	uint64_t expect = fib_seq(32);
+	double seq_ms = ms_since(begin);
+	begin = RareVoyager::GetMonotonicNS();
+	uint64_t result = 0;
+	{
+		RareVoyager::TaskGroup group(&scheduler);
+		group.run([&result]() { result = fib_task(32); });
+		group.wait();
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << "fib(32) sequential " << seq_ms << " ms, task group " << ms_since(begin)
+			<< " ms, ok = " << (result == expect);
+
+	// 2. 细粒度循环: 工作窃取 parallelFor 对比 每 1000 个元素一个任务提交到共享队列的线程池
+	const size_t n = 4000000;
+	std::vector<double> data(n);
+	auto body = [&data](size_t i) { data[i] = std::sqrt(static_cast<double>(i)) * 1.0001; };
+
+	begin = RareVoyager::GetMonotonicNS();
+	for (size_t i = 0; i < n; ++i)
+	{
+		body(i);
+	}
+	seq_ms = ms_since(begin);
+
+	begin = RareVoyager::GetMonotonicNS();
+	scheduler.parallelFor(0, n, body);
+	double ws_ms = ms_since(begin);
+
+	begin = RareVoyager::GetMonotonicNS();
+	std::vector<std::function<void()> > chunks;
+	for (size_t b = 0; b < n; b += 1000)
+	{
+		chunks.push_back([b, &body, n]() {
+			for (size_t i = b; i < std::min(b + 1000, n); ++i)
+			{
+				body(i);
+			}
+		});
+	}
+	for (auto& f: pool.submitN(chunks))
+	{
+		f.wait();
+	}
+	double pool_ms = ms_since(begin);
+	RAREVOYAGER_LOG_INFO(g_logger) << "for " << n << " items: sequential " << seq_ms << " ms, parallelFor "
+			<< ws_ms << " ms, thread pool " << pool_ms << " ms";
+
+	// 3. 归约
+	begin = RareVoyager::GetMonotonicNS();
+	double sum = scheduler.parallelReduce(0, n, 0.0,
+	                                      [&data](size_t b, size_t e) {
+		                                      double s = 0;
+		                                      for (size_t i = b; i < e; ++i)
+		                                      {
+			                                      s += data[i];
+		                                      }
+		                                      return s;
+	                                      },
+	                                      [](double a, double b) { return a + b; });
+	double check = 0;
+	for (auto v: data)
+	{
+		check += v;
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << "parallelReduce " << ms_since(begin) << " ms, relative error "
+			<< std::fabs(sum - check) / check;
+
+	// 4. 一百万个空任务的调度开销
+	const int tasks = 1000000;
+	std::atomic<int> counter{0};
+	begin = RareVoyager::GetMonotonicNS();
+	{
+		RareVoyager::TaskGroup group(&scheduler);
+		group.run([&]() {
+			RareVoyager::TaskGroup inner;
+			for (int i = 0; i < tasks; ++i)
+			{
+				inner.run([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+			}
+			inner.wait();
+		});
+		group.wait();
+	}
+	ws_ms = ms_since(begin);
+
+	begin = RareVoyager::GetMonotonicNS();
+	std::vector<std::future<void> > futures;
+	futures.reserve(tasks);
+	for (int i = 0; i < tasks; ++i)
+	{
+		futures.push_back(pool.submit([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); }));
+	}
+	for (auto& f: futures)
+	{
+		f.wait();
+	}
+	pool_ms = ms_since(begin);
+	RAREVOYAGER_LOG_INFO(g_logger) << tasks << " empty tasks: work stealing " << ws_ms * 1e6 / tasks
+			<< " ns/task, thread pool " << pool_ms * 1e6 / tasks << " ns/task, counter = " << counter;
+	return 0;
+}
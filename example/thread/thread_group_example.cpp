@@ -0,0 +1,86 @@
+#include <cstdlib>
+
+#include <include/thread/thread_group.h>
+#include <include/thread/barrier.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static double ms_since(uint64_t begin)
+{
+	return (RareVoyager::GetMonotonicNS() - begin) / 1e6;
+}
+
+/**
+ * @brief: 用法 thread_group_example [线程数，默认 64] [栅栏轮数，默认 10000]
+ */
+int main(int argc, char** argv)
+{
+	size_t threads = argc > 1 ? atoi(argv[1]) : 64;
+	uint32_t rounds = argc > 2 ? atoi(argv[2]) : 10000;
+
+	// 1. 启动耗时: 逐个构造 Thread(每个都等握手) 对比 ThreadGroup(只等一次)
+	RareVoyager::Latch release(1);
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	std::vector<RareVoyager::Thread::ptr> serial;
+	for (size_t i = 0; i < threads; ++i)
+	{
+		serial.emplace_back(new RareVoyager::Thread([&release]() { release.wait(); },
+		                                            "serial_" + std::to_string(i)));
+	}
+	double serial_ms = ms_since(begin);
+	release.countDown();
+	for (auto& t: serial)
+	{
+		t->join();
+	}
+
+	RareVoyager::Latch release2(1);
+	begin = RareVoyager::GetMonotonicNS();
+	{
+		RareVoyager::ThreadGroup group("group");
+		group.start(threads, [&release2](size_t) { release2.wait(); });
+		double group_ms = ms_since(begin);
+		release2.countDown();
+		group.join();
+		RAREVOYAGER_LOG_INFO(g_logger) << "start " << threads << " threads: one by one " << serial_ms
+				<< " ms, ThreadGroup " << group_ms << " ms";
+	}
+
+	// 2. 栅栏: 每轮每个线程给自己的格子加一，最后到达的线程检查这一轮所有格子都已经更新
+	size_t workers = std::min<size_t>(threads, 8);
+	std::vector<uint64_t> cells(workers, 0);
+	uint64_t errors = 0;
+	uint64_t round = 0;
+	RareVoyager::Barrier barrier(static_cast<uint32_t>(workers), [&]() {
+		++round;
+		for (auto c: cells)
+		{
+			errors += c != round;
+		}
+	});
+	begin = RareVoyager::GetMonotonicNS();
+	{
+		RareVoyager::ThreadGroup group("phase");
+		group.start(workers, [&](size_t i) {
+			for (uint32_t r = 0; r < rounds; ++r)
+			{
+				++cells[i];
+				barrier.arriveAndWait();
+			}
+		});
+	}
+	double barrier_ms = ms_since(begin);
+	RAREVOYAGER_LOG_INFO(g_logger) << workers << " threads x " << rounds << " barrier rounds: "
+			<< barrier_ms * 1e6 / rounds << " ns/round, generation = " << barrier.getGeneration()
+			<< ", errors = " << errors;
+
+	// 3. Latch 超时
+	RareVoyager::Latch never(1);
+	begin = RareVoyager::GetMonotonicNS();
+	bool ok = never.waitFor(std::chrono::milliseconds(20));
+	RAREVOYAGER_LOG_INFO(g_logger) << "latch waitFor 20ms returned " << ok << " after " << ms_since(begin) << " ms";
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include <cstdlib>
+#include <thread>
+
+#include <include/thread/thread_local.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+/**
+ * @brief: 用 ThreadLocal 实现的分片计数器
+ * 每个线程只写自己的原子变量；线程退出时把计数合并到 m_retired，读取时汇总
+ */
+class ShardedCounter
+{
+public:
+	ShardedCounter()
+		: m_local([this](std::atomic<uint64_t>& v) { m_retired.fetch_add(v.load(), std::memory_order_relaxed); })
+	{
+	}
+
+	void add(uint64_t v)
+	{
+		std::atomic<uint64_t>& local = m_local.get();
+		// 只有本线程写，不需要原子的读-改-写
+		local.store(local.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+	}
+
+	uint64_t sum() const
+	{
+		return m_local.combine(m_retired.load(std::memory_order_relaxed),
+		                       [](uint64_t acc, std::atomic<uint64_t>& v) { return acc + v.load(); });
+	}
+
+	size_t getThreadCount() const { return m_local.getThreadCount(); }
+
+private:
+	std::atomic<uint64_t> m_retired{0};
+	RareVoyager::ThreadLocal<std::atomic<uint64_t> > m_local;
+};
+
+/**
+ * @brief: 用法 thread_local_example [线程数，默认 4]
+ */
+int main(int argc, char** argv)
+{
+	int threads = argc > 1 ? atoi(argv[1]) : 4;
+	const uint64_t ops = 20000000;
+
+	// 1. 分片计数器与共享原子计数器，一半线程用 RareVoyager::Thread，一半用 std::thread
+	ShardedCounter counter;
+	std::atomic<uint64_t> shared{0};
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	{
+		std::vector<RareVoyager::Thread::ptr> workers;
+		std::vector<std::thread> std_workers;
+		for (int t = 0; t < threads; ++t)
+		{
+			auto body = [&counter, ops]() {
+				for (uint64_t i = 0; i < ops; ++i)
+				{
+					counter.add(1);
+				}
+			};
+			if (t % 2)
+			{
+				std_workers.emplace_back(body);
+			}
+			else
+			{
+				workers.emplace_back(new RareVoyager::Thread(body, "counter_" + std::to_string(t)));
+			}
+		}
+		RAREVOYAGER_LOG_INFO(g_logger) << "running, threads with a slot = " << counter.getThreadCount()
+				<< ", partial sum = " << counter.sum();
+		for (auto& w: workers)
+		{
+			w->join();
+		}
+		for (auto& w: std_workers)
+		{
+			w.join();
+		}
+	}
+	double local_ns = static_cast<double>(RareVoyager::GetMonotonicNS() - begin) / ops / threads;
+
+	begin = RareVoyager::GetMonotonicNS();
+	{
+		std::vector<RareVoyager::Thread::ptr> workers;
+		for (int t = 0; t < threads; ++t)
+		{
+			workers.emplace_back(new RareVoyager::Thread([&shared, ops]() {
+				for (uint64_t i = 0; i < ops; ++i)
+				{
+					shared.fetch_add(1, std::memory_order_relaxed);
+				}
+			}, "shared_" + std::to_string(t)));
+		}
+		for (auto& w: workers)
+		{
+			w->join();
+		}
+	}
+	double shared_ns = static_cast<double>(RareVoyager::GetMonotonicNS() - begin) / ops / threads;
+
+	RAREVOYAGER_LOG_INFO(g_logger) << "after exit: threads with a slot = " << counter.getThreadCount()
+			<< ", sum = " << counter.sum() << ", expect = " << ops * threads
+			<< "; ns per add: ThreadLocal " << local_ns << ", shared atomic " << shared_ns;
+
+	// 2. 反复创建、销毁 ThreadLocal，编号复用后不会读到旧值
+	for (int i = 0; i < 1000; ++i)
+	{
+		RareVoyager::ThreadLocal<int> tl(i);
+		if (tl.get() != i)
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "stale slot at " << i;
+			return 1;
+		}
+		tl.get() = -1;
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << "1000 create/destroy rounds ok";
+	return 0;
+}
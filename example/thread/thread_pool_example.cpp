@@ -0,0 +1,74 @@
+#include <unistd.h>
+
+#include <include/thread/thread_pool.h>
+#include <include/logger/logger.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+int fib(int n)
+{
+	return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+int main()
+{
+	// 2 个常驻线程，最多扩到 8 个，多余线程空闲 100ms 后退出
+	RareVoyager::ThreadPool pool("example", 2, 8, 100);
+
+	std::vector<std::future<int> > results;
+	for (int i = 20; i < 30; ++i)
+	{
+		results.push_back(pool.submit([i]() { return fib(i); }));
+	}
+	for (auto& f: results)
+	{
+		RAREVOYAGER_LOG_INFO(g_logger) << "fib = " << f.get();
+	}
+
+	// 批量提交只唤醒一次
+	std::atomic<int> counter{0};
+	std::vector<std::function<void()> > batch(1000, [&counter]() { ++counter; });
+	for (auto& f: pool.submitN(batch))
+	{
+		f.wait();
+	}
+	RAREVOYAGER_LOG_INFO(g_logger) << "batch counter = " << counter;
+
+	// 排队中的任务可以取消，对应 future 抛 broken_promise
+	RareVoyager::ThreadPool single("single", 1);
+	single.submit([]() { usleep(50000); });
+	RareVoyager::ThreadPool::Task::ptr task;
+	auto cancelled = single.submit([]() { return 1; }, &task);
+	RAREVOYAGER_LOG_INFO(g_logger) << "cancel = " << task->cancel();
+	try
+	{
+		cancelled.get();
+	}
+	catch (std::future_error& e)
+	{
+		RAREVOYAGER_LOG_INFO(g_logger) << "cancelled task: " << e.what();
+	}
+
+	// 异常通过 future 传回
+	auto failed = pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+	try
+	{
+		failed.get();
+	}
+	catch (std::exception& e)
+	{
+		RAREVOYAGER_LOG_INFO(g_logger) << "exception: " << e.what();
+	}
+
+	RAREVOYAGER_LOG_INFO(g_logger) << "stats: " << pool.toString();
+	usleep(300000);
+	RAREVOYAGER_LOG_INFO(g_logger) << "after idle: " << pool.toString();
+
+	for (int i = 0; i < 100; ++i)
+	{
+		single.submit([]() { usleep(1000); });
+	}
+	single.shutdown(RareVoyager::ThreadPool::ABANDON);
+	RAREVOYAGER_LOG_INFO(g_logger) << "abandon: " << single.toString();
+	return 0;
+}
@@ -0,0 +1,53 @@
+#include <sched.h>
+#include <sys/mman.h>
+#include <cstring>
+
+#include <include/thread/thread.h>
+#include <include/thread/topology.h>
+#include <include/util.h>
+#include <include/logger/logger.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+/**
+ * @brief: 打印 CPU 拓扑，每个物理核起一个绑核的线程，确认它确实跑在指定的 CPU 上
+ */
+int main()
+{
+	const RareVoyager::CpuTopology& topology = RareVoyager::CpuTopology::Get();
+	RAREVOYAGER_LOG_INFO(g_logger) << topology.toString();
+
+	std::vector<int> cores = topology.onePerPhysicalCore();
+	std::vector<RareVoyager::Thread::ptr> threads;
+	for (size_t i = 0; i < cores.size(); ++i)
+	{
+		RareVoyager::ThreadOptions options;
+		options.cpus.push_back(cores[i]);
+		options.numaNode = topology.getNodeOfCpu(cores[i]);
+		options.stackSize = 256 * 1024;
+		options.schedPolicy = SCHED_BATCH;
+		threads.emplace_back(new RareVoyager::Thread([cpu = cores[i]]() {
+			pthread_attr_t attr;
+			size_t stack = 0;
+			pthread_getattr_np(pthread_self(), &attr);
+			pthread_attr_getstacksize(&attr, &stack);
+			pthread_attr_destroy(&attr);
+			RAREVOYAGER_LOG_INFO(g_logger) << RareVoyager::Thread::GetName() << " want cpu " << cpu
+					<< " running on " << sched_getcpu() << " stack " << stack / 1024 << "KB policy "
+					<< sched_getscheduler(0);
+		}, "core_" + std::to_string(cores[i]), options));
+	}
+	for (auto& t: threads)
+	{
+		t->join();
+	}
+
+	// 把一块匿名内存绑定到节点 0
+	size_t len = 4 << 20;
+	void* mem = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	bool bound = RareVoyager::NumaBindMemory(mem, len, 0);
+	memset(mem, 0, len);
+	RAREVOYAGER_LOG_INFO(g_logger) << "mbind 4MB to node 0: " << bound;
+	munmap(mem, len);
+	return 0;
+}
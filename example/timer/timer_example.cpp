@@ -0,0 +1,132 @@
+#include <cstdlib>
+#include <random>
+#include <unistd.h>
+
+#include <include/timer/timer.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static RareVoyager::Logger::ptr g_logger = RAREVOYAGER_LOG_ROOT();
+
+static uint64_t now_ms()
+{
+	return RareVoyager::GetMonotonicNS() / 1000000;
+}
+
+/**
+ * @brief: 模拟事件循环，按 getNextTimer 睡眠，醒来后批量执行到期回调，直到没有定时器或超过 max_ms
+ */
+static void run_loop(RareVoyager::TimerManager& manager, uint64_t max_ms)
+{
+	uint64_t end = now_ms() + max_ms;
+	std::vector<std::function<void()> > cbs;
+	while (manager.hasTimer() && now_ms() < end)
+	{
+		uint64_t next = manager.getNextTimer();
+		if (next)
+		{
+			usleep(std::min<uint64_t>(next, 50) * 1000);
+		}
+		manager.listExpiredCallbacks(cbs);
+		for (auto& cb: cbs)
+		{
+			cb();
+		}
+		cbs.clear();
+	}
+}
+
+/**
+ * @brief: 用法 timer_example [定时器数量，默认 1000000]
+ */
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? atoi(argv[1]) : 1000000;
+	std::mt19937_64 rng(42);
+
+	// 1. 大量定时器的添加、取消
+	{
+		RareVoyager::TimerManager manager;
+		std::vector<RareVoyager::Timer::ptr> timers;
+		timers.reserve(count);
+		uint64_t begin = RareVoyager::GetMonotonicNS();
+		for (size_t i = 0; i < count; ++i)
+		{
+			timers.push_back(manager.addTimer(1 + rng() % 3600000, []() {}));
+		}
+		double add_ns = static_cast<double>(RareVoyager::GetMonotonicNS() - begin) / count;
+		size_t pending = manager.getTimerCount();
+
+		begin = RareVoyager::GetMonotonicNS();
+		for (size_t i = 0; i < count; i += 2)
+		{
+			timers[i]->refresh();
+		}
+		double refresh_ns = static_cast<double>(RareVoyager::GetMonotonicNS() - begin) / ((count + 1) / 2);
+
+		begin = RareVoyager::GetMonotonicNS();
+		size_t cancelled = 0;
+		for (auto& t: timers)
+		{
+			cancelled += t->cancel();
+		}
+		double cancel_ns = static_cast<double>(RareVoyager::GetMonotonicNS() - begin) / count;
+		RAREVOYAGER_LOG_INFO(g_logger) << count << " timers: add " << add_ns << " ns, refresh " << refresh_ns
+				<< " ns, cancel " << cancel_ns << " ns; pending after add = " << pending << ", cancelled = "
+				<< cancelled << ", left = " << manager.getTimerCount();
+	}
+
+	// 2. 到期顺序与精度: 回调执行时不能早于到期时间
+	{
+		RareVoyager::TimerManager manager;
+		const size_t n = 5000;
+		uint64_t early = 0;
+		uint64_t fired = 0;
+		uint64_t max_late = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			uint64_t delay = rng() % 600;
+			uint64_t deadline = RareVoyager::GetMonotonicNS() + delay * 1000000;
+			manager.addTimer(delay, [&, deadline]() {
+				uint64_t now = RareVoyager::GetMonotonicNS();
+				++fired;
+				early += now < deadline;
+				max_late = std::max(max_late, now > deadline ? (now - deadline) / 1000000 : 0);
+			});
+		}
+		// 超过第 0 层范围和最大范围的定时器，只检查下次到期时间是合理的下界
+		auto far = manager.addTimer(1ull << 34, []() {});
+		auto mid = manager.addTimer(100000, []() {});
+		uint64_t next = manager.getNextTimer();
+		far->cancel();
+		mid->cancel();
+		run_loop(manager, 2000);
+		RAREVOYAGER_LOG_INFO(g_logger) << "expiry: fired " << fired << "/" << n << ", early = " << early
+				<< ", max late = " << max_late << " ms, first next = " << next << " ms";
+	}
+
+	// 3. 循环定时器、条件定时器、reset
+	{
+		RareVoyager::TimerManager manager;
+		int ticks = 0;
+		auto recurring = manager.addTimer(10, [&ticks]() { ++ticks; }, true);
+
+		int cond_fired = 0;
+		auto alive = std::make_shared<int>(1);
+		auto dead = std::make_shared<int>(2);
+		manager.addConditionTimer(20, [&cond_fired]() { ++cond_fired; }, alive);
+		manager.addConditionTimer(20, [&cond_fired]() { cond_fired += 100; }, dead);
+		dead.reset();
+
+		uint64_t reset_at = 0;
+		uint64_t begin = now_ms();
+		auto later = manager.addTimer(500, [&reset_at]() { reset_at = now_ms(); });
+		later->reset(50, true);
+
+		manager.addTimer(120, [&recurring]() { recurring->cancel(); });
+		run_loop(manager, 1000);
+		RAREVOYAGER_LOG_INFO(g_logger) << "recurring 10ms for 120ms ticks = " << ticks << ", condition fired = "
+				<< cond_fired << " (expect 1), reset 500->50ms fired after " << reset_at - begin << " ms";
+	}
+	return 0;
+}
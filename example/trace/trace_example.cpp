@@ -0,0 +1,77 @@
+#include <include/trace/trace.h>
+#include <include/config/config.h>
+#include <include/thread/thread.h>
+#include <include/logger/logger.h>
+#include <include/util.h>
+
+static volatile uint64_t g_sink = 0;
+
+void work(int n)
+{
+	RAREVOYAGER_TRACE_SCOPE("work");
+	for (int i = 0; i < n; ++i)
+	{
+		g_sink += i;
+	}
+}
+
+void request()
+{
+	RAREVOYAGER_TRACE_SCOPE("request");
+	{
+		RAREVOYAGER_TRACE_SCOPE("parse");
+		work(2000);
+	}
+	{
+		RAREVOYAGER_TRACE_SCOPE("handle");
+		work(10000);
+	}
+}
+
+void func()
+{
+	for (int i = 0; i < 100; ++i)
+	{
+		request();
+	}
+}
+
+/**
+ * @brief: 测量单个空作用域的开销
+ */
+double scope_cost_ns()
+{
+	const int n = 1000000;
+	uint64_t begin = RareVoyager::GetMonotonicNS();
+	for (int i = 0; i < n; ++i)
+	{
+		RAREVOYAGER_TRACE_SCOPE("empty");
+		g_sink = g_sink + 1;
+	}
+	return double(RareVoyager::GetMonotonicNS() - begin) / n;
+}
+
+int main()
+{
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "disabled scope cost: " << scope_cost_ns() << " ns";
+
+	// 通过配置打开追踪
+	RareVoyager::Config::LoadFromYaml(YAML::Load("trace:\n  enable: true\n"));
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "enabled scope cost: " << scope_cost_ns() << " ns";
+	RareVoyager::Tracer::Clear();
+
+	std::vector<RareVoyager::Thread::ptr> threads;
+	for (int i = 0; i < 4; ++i)
+	{
+		threads.emplace_back(new RareVoyager::Thread(&func, "worker_" + std::to_string(i)));
+	}
+	for (auto& i: threads)
+	{
+		i->join();
+	}
+
+	// 设置 trace.dump 触发导出，用 https://ui.perfetto.dev 打开
+	RareVoyager::Config::LoadFromYaml(YAML::Load("trace:\n  dump: trace.json\n"));
+	RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "trace written to trace.json";
+	return 0;
+}
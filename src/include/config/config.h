@@ -4,7 +4,8 @@
  * File：config.h
  * Author：Cipher
  * Date：2026/1/3-17:30
- * Update：
+ * Update：2026/10/19 ConfigVar 增加值存储策略，平凡可复制的类型使用顺序锁；Config 改用分片读写锁
+ *         2026/10/19 Config 注册表改用 ConcurrentHashMap，查找不加锁
  * ************************************************/
 
 #ifndef RAREVOYAGER_CONFIG_H
@@ -13,15 +14,19 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <list>
 #include <unordered_map>
 #include <unordered_set>
+#include <type_traits>
 
 #include <yaml-cpp/yaml.h>
 #include <include/util.h>
 #include <include/logger/logger.h>
+#include <include/thread/seqlock.h>
+#include <include/thread/concurrent_hash_map.h>
 #include <boost/lexical_cast.hpp>
 
 /**
@@ -48,6 +53,24 @@ namespace RareVoyager
 		}
 	};
 
+	/**
+	 * @brief: 特化版本, boost::lexical_cast 只认 "0"/"1"，这里额外支持 YAML 的 true/false/yes/no
+	 */
+	template<>
+	class LexicalCast<std::string, bool>
+	{
+	public:
+		bool operator()(const std::string& v)
+		{
+			bool rt;
+			if (YAML::convert<bool>::decode(YAML::Node(v), rt))
+			{
+				return rt;
+			}
+			return boost::lexical_cast<bool>(v);
+		}
+	};
+
 	///=========== 以下是一些std::string 与 stl容器之间的转换，借助中间件 YAML::Node
 	/**
 	 * @brief: 偏特化版本, 将string 转换为vector
@@ -281,6 +304,79 @@ namespace RareVoyager
 	};
 
 #pragma endregion LexicalCast
+#pragma region ConfigVarStorage
+	/**
+	 * @brief: ConfigVar 值的存储策略，默认用读写锁保护
+	 * 读多写少，使用分片读写锁，多核同时读取不会争抢同一条缓存行
+	 */
+	template<class T>
+	class RWMutexConfigStorage
+	{
+	public:
+		typedef ShardedRWMutex RWMutexType;
+
+		RWMutexConfigStorage(const T& value) : m_val(value)
+		{
+		}
+
+		T load()
+		{
+			RWMutexType::ReadLock lock(&m_mutex);
+			return m_val;
+		}
+
+		void store(const T& value)
+		{
+			RWMutexType::WriteLock lock(&m_mutex);
+			m_val = value;
+		}
+
+	private:
+		T m_val;
+		RWMutexType m_mutex;
+	};
+
+	/**
+	 * @brief: 顺序锁存储，读取不写共享内存，适合被频繁读取的标量配置
+	 */
+	template<class T>
+	class SeqLockConfigStorage
+	{
+	public:
+		SeqLockConfigStorage(const T& value) : m_val(value)
+		{
+		}
+
+		T load()
+		{
+			return m_val.load();
+		}
+
+		void store(const T& value)
+		{
+			m_val.store(value);
+		}
+
+	private:
+		SeqLock<T> m_val;
+	};
+
+	/**
+	 * @brief: 平凡可复制的类型(bool、整数、浮点等)默认使用顺序锁，其它类型使用读写锁
+	 */
+	template<class T, bool = std::is_trivially_copyable<T>::value && std::is_default_constructible<T>::value>
+	struct ConfigStorageSelector
+	{
+		typedef RWMutexConfigStorage<T> type;
+	};
+
+	template<class T>
+	struct ConfigStorageSelector<T, true>
+	{
+		typedef SeqLockConfigStorage<T> type;
+	};
+#pragma endregion ConfigVarStorage
+
 #pragma region ConfigVarBase
 	/**
 	 * @brief: 配置变量的基类
@@ -316,8 +412,10 @@ namespace RareVoyager
 	 * 通过仿函数实现string和T类型之间的相互转化
 	 * @tparam T
 	 * 需要类 或 结构体提供
+	 * @tparam Storage 值的存储策略，见 ConfigStorageSelector
 	 */
-	template<typename T, typename FromStr = LexicalCast<std::string, T>, typename ToStr = LexicalCast<T, std::string> >
+	template<typename T, typename FromStr = LexicalCast<std::string, T>, typename ToStr = LexicalCast<T, std::string>,
+		typename Storage = typename ConfigStorageSelector<T>::type>
 	class ConfigVar : public ConfigVarBase
 	{
 	public:
@@ -335,13 +433,12 @@ namespace RareVoyager
 		{
 			try
 			{
-				RWMutexType::ReadLock lock(&m_mutex);
-				return ToStr()(m_val);
+				return ToStr()(m_val.load());
 			}
 			catch (std::exception& e)
 			{
 				RAREVOYAGER_LOG_ERROR(RAREVOYAGER_LOG_ROOT()) << "ConfigVar::toString() exception"
-				 << e.what() << "convert:" << typeid(m_val).name() << "to string";
+				 << e.what() << "convert:" << typeid(T).name() << "to string";
 			}
 			return "";
 		}
@@ -356,7 +453,7 @@ namespace RareVoyager
 			catch (std::exception& e)
 			{
 				RAREVOYAGER_LOG_ERROR(RAREVOYAGER_LOG_ROOT()) << "ConfigVar::toString() exception"
-				<< e.what() << "convert: to string" << typeid(m_val).name();
+				<< e.what() << "convert: to string" << typeid(T).name();
 			}
 			return false;
 		}
@@ -367,19 +464,20 @@ namespace RareVoyager
 		 */
 		void setValue(const T& val)
 		{
-			RWMutexType::ReadLock lock(&m_mutex);
-			if (m_val == val)
 			{
-				return;
-			}
-			for (auto& [_,_value]: m_cbs)
-			{
-				// 执行 所有的回调函数
-				_value(m_val, val);
+				T old_value = m_val.load();
+				if (old_value == val)
+				{
+					return;
+				}
+				RWMutexType::ReadLock lock(&m_mutex);
+				for (auto& [_,_value]: m_cbs)
+				{
+					// 执行 所有的回调函数
+					_value(old_value, val);
+				}
 			}
-			// 通知变化
-			RWMutexType::WriteLock write(&m_mutex);
-			m_val = val;
+			m_val.store(val);
 		}
 
 		/**
@@ -388,8 +486,7 @@ namespace RareVoyager
 		 */
 		const T getValue()
 		{
-			RWMutexType::ReadLock lock(&m_mutex);
-			return m_val;
+			return m_val.load();
 		}
 
 		std::string getTypeName() const override
@@ -426,11 +523,12 @@ namespace RareVoyager
 		}
 
 	private:
-		T m_val;
+		Storage m_val;
 		/**
 		 * 回调函数组，根据hash值区分
 		 */
 		std::map<uint64_t, on_change_cb> m_cbs;
+		// 只保护 m_cbs，值的并发由 Storage 负责
 		RWMutexType m_mutex;
 	};
 
@@ -444,8 +542,8 @@ namespace RareVoyager
 	class Config
 	{
 	public:
-		typedef RWMutex RWMutexType;
-		typedef std::map<std::string, ConfigVarBase::ptr> ConfigVarMap;
+		// 查找远多于注册，查找在 RCU 读临界区里进行，不加锁
+		typedef ConcurrentHashMap<std::string, ConfigVarBase::ptr> ConfigVarMap;
 
 		/**
 		 * @brief: 有返回没有创建
@@ -458,30 +556,27 @@ namespace RareVoyager
 		template<class T>
 		static typename ConfigVar<T>::ptr Lookup(const std::string& name, const T& default_value, const std::string& description = "")
 		{
-			RWMutexType::WriteLock lock(&GetMutex());
-			auto it = GetDatas().find(name);
-			if (it != GetDatas().end())
+			ConfigVarBase::ptr base;
+			if (!GetDatas().find(name, base))
 			{
-				auto tmp = std::dynamic_pointer_cast<ConfigVar<T> >(it->second);
-				if (!tmp)
+				if (name.find_first_not_of(regex_str) != std::string::npos)
 				{
-					RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "Lookup name " << name << "exists but type not"
-<< typeid(T).name() << "real_type" << it->second->getTypeName();
-					return nullptr;
+					RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "Lookup name invalid " << name << "exists";
+					throw std::invalid_argument(name);
 				}
-				RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "Lookup name " << name << "exists";
-				return tmp;
+				// 并发注册同一个名字时只有一个会被插入，其它线程拿到已插入的那个
+				base = GetDatas().getOrInsert(name, [&]() {
+					return ConfigVarBase::ptr(new ConfigVar<T>(name, default_value, description));
+				});
 			}
-
-			if (name.find_first_not_of(regex_str) != std::string::npos)
+			auto tmp = std::dynamic_pointer_cast<ConfigVar<T> >(base);
+			if (!tmp)
 			{
-				RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "Lookup name invalid " << name << "exists";
-				throw std::invalid_argument(name);
+				RAREVOYAGER_LOG_INFO(RAREVOYAGER_LOG_ROOT()) << "Lookup name " << name << "exists but type not"
+<< typeid(T).name() << "real_type" << base->getTypeName();
+				return nullptr;
 			}
-
-			typename ConfigVar<T>::ptr v(new ConfigVar<T>(name, default_value, description));
-			GetDatas()[name] = v;
-			return v;
+			return tmp;
 		}
 
 		/**
@@ -491,17 +586,20 @@ namespace RareVoyager
 		 * @return
 		 */
 		template<class T>
-		static typename ConfigVar<T>::ptr Lookup(const std::string& name)
+		static typename ConfigVar<T>::ptr Lookup(std::string_view name)
 		{
-			RWMutexType::WriteLock lock(&GetMutex());
-			auto it = GetDatas().find(name);
-			// return it == s_datas.end() ? nullptr : it->second;
-			return it == GetDatas().end() ? nullptr : std::dynamic_pointer_cast<ConfigVar<T> >(it->second);
+			ConfigVarBase::ptr base;
+			return GetDatas().find(name, base) ? std::dynamic_pointer_cast<ConfigVar<T> >(base) : nullptr;
 		}
 
 		static void LoadFromYaml(const YAML::Node& node);
 
-		static ConfigVarBase::ptr LookupBase(const std::string& name);
+		static ConfigVarBase::ptr LookupBase(std::string_view name);
+
+		/**
+		 * @brief: 遍历所有配置项，cb(name, var)
+		 */
+		static void Visit(std::function<void(const std::string&, const ConfigVarBase::ptr&)> cb);
 
 	private:
 		static ConfigVarMap& GetDatas()
@@ -509,10 +607,6 @@ namespace RareVoyager
 			static ConfigVarMap s_datas;
 			return s_datas;
 		}
-		static RWMutexType& GetMutex() {
-			static RWMutexType s_mutex;
-			return s_mutex;
-		}
 	};
 #pragma endregion Config
 
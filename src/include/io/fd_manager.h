@@ -0,0 +1,112 @@
+/*************************************************
+ * 描述：fd 管理。记录 hook 接管的 fd 是否是 socket、
+ * 用户与系统层面的非阻塞状态以及读写超时
+ *
+ * File：fd_manager.h
+ * Author：Cipher
+ * Date：2026/10/20-22:00
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_FD_MANAGER_H
+#define RAREVOYAGER_FD_MANAGER_H
+
+#include <atomic>
+#include <cstdint>
+
+#include <include/singleton.h>
+#include <include/thread/mutex.h>
+
+namespace RareVoyager
+{
+#pragma region FdCtx
+	/**
+	 * @brief: 一个 fd 的状态
+	 * 1. socket 在初始化时被设为系统层面非阻塞，hook 在 EAGAIN 时挂起协程等待事件
+	 * 2. 用户自己设置的非阻塞单独记录，用户要求非阻塞时 hook 不等待，直接返回 EAGAIN
+	 */
+	class FdCtx
+	{
+	public:
+		/**
+		 * @brief: 按 fd 当前的状态初始化，初始化前已有 O_NONBLOCK 的视为用户设置的
+		 */
+		void init(int fd);
+
+		/**
+		 * @brief: fd 关闭后清空，同一个 fd 号再次使用时重新初始化
+		 */
+		void reset();
+
+		bool isInit() const { return m_isInit.load(std::memory_order_acquire); }
+
+		bool isSocket() const { return m_isSocket; }
+
+		bool isClose() const { return m_isClosed; }
+
+		void setUserNonblock(bool v) { m_userNonblock = v; }
+
+		bool getUserNonblock() const { return m_userNonblock; }
+
+		void setSysNonblock(bool v) { m_sysNonblock = v; }
+
+		bool getSysNonblock() const { return m_sysNonblock; }
+
+		/**
+		 * @param type SO_RCVTIMEO 或 SO_SNDTIMEO
+		 * @param ms 毫秒，UINT64_MAX 表示不超时
+		 */
+		void setTimeout(int type, uint64_t ms);
+
+		uint64_t getTimeout(int type) const;
+
+	private:
+		std::atomic<bool> m_isInit{false};
+		bool m_isSocket = false;
+		bool m_sysNonblock = false;
+		bool m_userNonblock = false;
+		bool m_isClosed = false;
+		int m_fd = -1;
+		uint64_t m_recvTimeout = UINT64_MAX;
+		uint64_t m_sendTimeout = UINT64_MAX;
+	};
+#pragma endregion FdCtx
+
+#pragma region FdManager
+	/**
+	 * @brief: 按 fd 下标的两级数组，与 IOManager 的 fd 上下文相同:
+	 * 块按需分配、不释放，查找不加锁，hook 的每次读写只多两次内存读
+	 */
+	class FdManager
+	{
+	public:
+		typedef Mutex MutexType;
+
+		FdManager();
+
+		/**
+		 * @param auto_create 还没初始化时是否初始化
+		 * @return 没初始化或 fd 超出范围时返回 nullptr
+		 */
+		FdCtx* get(int fd, bool auto_create = false);
+
+		/**
+		 * @brief: fd 关闭时调用
+		 */
+		void del(int fd);
+
+	private:
+		static const size_t s_chunkBits = 10;
+		static const size_t s_chunkSize = 1u << s_chunkBits;
+
+		MutexType m_mutex;
+		size_t m_chunkCount = 0;
+		// 不释放: 静态析构之后仍可能有 close 调用进来
+		std::atomic<FdCtx*>* m_chunks = nullptr;
+	};
+
+	typedef Singleton<FdManager> FdMgr;
+#pragma endregion FdManager
+}
+
+#endif //RAREVOYAGER_FD_MANAGER_H
@@ -0,0 +1,107 @@
+/*************************************************
+ * 描述：系统调用 hook。在开启 hook 的线程里，协程中的阻塞调用
+ * (sleep、socket 读写、connect、accept)挂起协程交给 IOManager，不阻塞线程
+ *
+ * File：hook.h
+ * Author：Cipher
+ * Date：2026/10/20-22:00
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_HOOK_H
+#define RAREVOYAGER_HOOK_H
+
+#include <cstdint>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace RareVoyager
+{
+	/**
+	 * @brief: 当前线程是否开启了 hook。IOManager 的工作线程在调度循环里开启
+	 */
+	bool IsHookEnable();
+
+	/**
+	 * @brief: 开关当前线程的 hook
+	 * 1. 关闭时被 hook 的函数只多一次线程局部变量的判断，直接调用原函数
+	 * 2. 开启时只有在 IOManager 的协程里、对 hook 接管的阻塞 socket 才会挂起，其余情况仍调用原函数
+	 */
+	void SetHookEnable(bool flag);
+}
+
+extern "C" {
+#pragma region 原函数
+// 由 dlsym(RTLD_NEXT) 取得的原函数，绕过 hook 时直接调用
+
+// sleep
+typedef unsigned int (*sleep_fun)(unsigned int seconds);
+extern sleep_fun sleep_f;
+
+typedef int (*usleep_fun)(useconds_t usec);
+extern usleep_fun usleep_f;
+
+typedef int (*nanosleep_fun)(const struct timespec* req, struct timespec* rem);
+extern nanosleep_fun nanosleep_f;
+
+// socket
+typedef int (*socket_fun)(int domain, int type, int protocol);
+extern socket_fun socket_f;
+
+typedef int (*connect_fun)(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
+extern connect_fun connect_f;
+
+typedef int (*accept_fun)(int s, struct sockaddr* addr, socklen_t* addrlen);
+extern accept_fun accept_f;
+
+// read
+typedef ssize_t (*read_fun)(int fd, void* buf, size_t count);
+extern read_fun read_f;
+
+typedef ssize_t (*readv_fun)(int fd, const struct iovec* iov, int iovcnt);
+extern readv_fun readv_f;
+
+typedef ssize_t (*recv_fun)(int sockfd, void* buf, size_t len, int flags);
+extern recv_fun recv_f;
+
+typedef ssize_t (*recvfrom_fun)(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr,
+								socklen_t* addrlen);
+extern recvfrom_fun recvfrom_f;
+
+// write
+typedef ssize_t (*write_fun)(int fd, const void* buf, size_t count);
+extern write_fun write_f;
+
+typedef ssize_t (*writev_fun)(int fd, const struct iovec* iov, int iovcnt);
+extern writev_fun writev_f;
+
+typedef ssize_t (*send_fun)(int s, const void* msg, size_t len, int flags);
+extern send_fun send_f;
+
+typedef ssize_t (*sendto_fun)(int s, const void* msg, size_t len, int flags, const struct sockaddr* to,
+							socklen_t tolen);
+extern sendto_fun sendto_f;
+
+// fd
+typedef int (*close_fun)(int fd);
+extern close_fun close_f;
+
+typedef int (*fcntl_fun)(int fd, int cmd, ...);
+extern fcntl_fun fcntl_f;
+
+typedef int (*setsockopt_fun)(int sockfd, int level, int optname, const void* optval, socklen_t optlen);
+extern setsockopt_fun setsockopt_f;
+#pragma endregion 原函数
+
+/**
+ * @brief: 带超时的 connect，timeout_ms 为 UINT64_MAX 时不超时。hook 的 connect 用配置 tcp.connect.timeout
+ */
+extern int connect_with_timeout(int fd, const struct sockaddr* addr, socklen_t addrlen, uint64_t timeout_ms);
+}
+
+#endif //RAREVOYAGER_HOOK_H
@@ -0,0 +1,303 @@
+/*************************************************
+ * 描述：IO 协程调度器。在 Scheduler 上加 epoll 与定时器，
+ * 协程等待 fd 可读写时挂起，事件到达后重新调度
+ *
+ * File：io_manager.h
+ * Author：Cipher
+ * Date：2026/10/20-18:00
+ * Update：2026/10/20-20:00 加 io_uring 后端与协程内的异步 IO 接口
+ * ************************************************/
+
+#ifndef RAREVOYAGER_IO_MANAGER_H
+#define RAREVOYAGER_IO_MANAGER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <include/io/io_uring.h>
+#include <include/thread/scheduler.h>
+#include <include/thread/mutex.h>
+#include <include/timer/timer.h>
+
+namespace RareVoyager
+{
+#pragma region IOManager
+	/**
+	 * @brief: 基于 epoll 的 IO 调度器
+	 * 1. fd 以边缘触发注册，每个事件是一次性的: 触发后从 epoll 中去掉，回调或协程被调度一次
+	 * 2. fd 上下文放在按 fd 下标的两级数组里(每块 1024 个，按需分配、不释放)，查找不加锁、不查 map
+	 * 3. 同一时刻只有一个空闲的工作线程阻塞在 epoll_wait 上(轮流当 poller)，其余空闲线程睡在 futex 上；
+	 *    tickle 到 poller 时写 eventfd 把它从 epoll_wait 里叫醒
+	 * 4. epoll_wait 的超时取 getNextTimer，醒来后把到期的定时器回调一起调度
+	 * 5. 配置 io.backend 为 io_uring 时改用 io_uring(内核不支持时退回 epoll):
+	 *    addEvent 变成 POLL_ADD，async* 接口直接提交读写、accept、connect、超时的 SQE；
+	 *    SQE 先放在环里，工作线程进入 idle 时一次 io_uring_enter 批量提交，poller 提交的同时等待完成
+	 */
+	class IOManager : public Scheduler, public TimerManager
+	{
+	public:
+		typedef std::shared_ptr<IOManager> ptr;
+		typedef Mutex MutexType;
+
+		enum Event
+		{
+			NONE = 0x0,
+			// 与 EPOLLIN 相同
+			READ = 0x1,
+			// 与 EPOLLOUT 相同
+			WRITE = 0x4,
+		};
+
+		enum Backend
+		{
+			EPOLL = 0,
+			IO_URING = 1,
+		};
+
+		explicit IOManager(size_t threads = 1, bool use_caller = true, const std::string& name = "io");
+
+		~IOManager();
+
+		/**
+		 * @brief: 关注 fd 上的一个事件，触发一次后自动取消
+		 * @param cb 事件到达时调度的回调，为空时记录当前协程，调用者随后应当 YieldToHold
+		 * @return 0 成功，-1 失败(fd 超出范围、事件已经注册或 epoll_ctl 失败)
+		 */
+		int addEvent(int fd, Event event, std::function<void()> cb = nullptr);
+
+		/**
+		 * @brief: 取消关注，不触发
+		 */
+		bool delEvent(int fd, Event event);
+
+		/**
+		 * @brief: 取消关注并立即触发一次(用于超时、关闭 fd 时唤醒等待的协程)
+		 */
+		bool cancelEvent(int fd, Event event);
+
+		/**
+		 * @brief: 取消 fd 上的所有事件并触发
+		 */
+		bool cancelAll(int fd);
+
+		/**
+		 * @brief: 已注册还没触发的事件数(io_uring 后端包括还没完成的 async* 操作)
+		 */
+		uint64_t getPendingEventCount() const { return m_pendingEventCount.load(std::memory_order_relaxed); }
+
+		Backend getBackend() const { return m_backend; }
+
+		/**
+		 * @brief: IOManager 自己发出的系统调用次数(epoll_ctl、epoll_wait、io_uring_enter、eventfd 读写与 async* 里的读写)
+		 */
+		uint64_t getSyscallCount() const { return m_syscallCount.load(std::memory_order_relaxed); }
+
+#pragma region 协程内的异步 IO
+		// 只能在协程里调用，返回值与 errno 同对应的系统调用。
+		// epoll 后端先直接调用，EAGAIN 时 addEvent 等待后重试；io_uring 后端提交 SQE 后挂起，完成时恢复，
+		// 非阻塞 fd 返回 EAGAIN 时同样先等待可读写再重试
+
+		ssize_t asyncRead(int fd, void* buf, size_t len);
+
+		ssize_t asyncWrite(int fd, const void* buf, size_t len);
+
+		/**
+		 * @brief: buf 必须落在 registerBuffers 注册的第 buf_index 块缓冲区里，epoll 后端等同 asyncRead
+		 */
+		ssize_t asyncReadFixed(int fd, void* buf, size_t len, int buf_index);
+
+		ssize_t asyncWriteFixed(int fd, const void* buf, size_t len, int buf_index);
+
+		int asyncAccept(int fd, sockaddr* addr, socklen_t* addrlen, int flags = 0);
+
+		int asyncConnect(int fd, const sockaddr* addr, socklen_t addrlen);
+
+		/**
+		 * @brief: 挂起当前协程 ms 毫秒，io_uring 后端用 IORING_OP_TIMEOUT
+		 */
+		int asyncSleep(uint64_t ms);
+
+		/**
+		 * @brief: 注册固定缓冲区，替换之前注册的。应在发起 IO 之前调用，epoll 后端忽略
+		 * @return 0 成功，-1 失败并设置 errno
+		 */
+		int registerBuffers(const std::vector<iovec>& buffers);
+
+		/**
+		 * @brief: 注册固定文件，之后这些 fd 上的 async* 自动带 IOSQE_FIXED_FILE。应在发起 IO 之前调用，
+		 * 注册期间内核持有文件引用，close 之前要先 unregisterFiles。epoll 后端忽略
+		 * @return 0 成功，-1 失败并设置 errno
+		 */
+		int registerFiles(const std::vector<int>& fds);
+
+		int unregisterFiles();
+#pragma endregion 协程内的异步 IO
+
+		/**
+		 * @brief: 当前线程所属的 IOManager
+		 */
+		static IOManager* GetThis();
+
+		/**
+		 * @brief: 在所有存活的 IOManager 上取消 fd 的事件并唤醒等待者。
+		 * fd 关闭时调用，关闭它的线程不一定是登记事件的 IOManager 的工作线程
+		 */
+		static void CancelAllOnClose(int fd);
+
+	protected:
+		void tickle(uint32_t worker) override;
+
+		void idle(uint32_t worker) override;
+
+		bool stopping() override;
+
+		void onTimerInsertedAtFront() override;
+
+		/**
+		 * @brief: 每执行 io.poll_interval 个任务提交一次攒下的 SQE，并在没有 poller 时不阻塞地收一次事件
+		 */
+		void onTaskExecuted(uint32_t worker) override;
+
+	private:
+		struct FdContext;
+
+		/**
+		 * @brief: io_uring 的一次提交，地址作为 user_data
+		 */
+		struct IoOp
+		{
+			// async* 里等待完成的协程
+			Fiber::ptr fiber;
+			int32_t res = 0;
+			// addEvent 的 POLL_ADD: 所属 fd 与事件
+			FdContext* ctx = nullptr;
+			Event event = NONE;
+		};
+
+		struct FdContext
+		{
+			struct EventContext
+			{
+				Scheduler* scheduler = nullptr;
+				Fiber::ptr fiber;
+				std::function<void()> cb;
+				// io_uring 后端里还没完成的 POLL_ADD
+				IoOp* op = nullptr;
+			};
+
+			EventContext& getContext(Event event) { return event == READ ? read : write; }
+
+			/**
+			 * @brief: 调度事件上的回调或协程，并清除该事件，调用者持有 mutex
+			 */
+			void triggerEvent(Event event);
+
+			EventContext read;
+			EventContext write;
+			int fd = -1;
+			// 已经注册到 epoll 的事件
+			Event events = NONE;
+			MutexType mutex;
+		};
+
+		/**
+		 * @param create 所在的块还没分配时是否分配
+		 * @return fd 超出范围或块不存在时返回 nullptr
+		 */
+		FdContext* getFdContext(int fd, bool create);
+
+		/**
+		 * @brief: 从 epoll 或 io_uring 里去掉 fd 上的 events，调用者持有 ctx->mutex
+		 */
+		bool detachEvents(FdContext* ctx, uint32_t events);
+
+		/**
+		 * @brief: 处理 epoll_wait 返回的事件
+		 */
+		void handleEvent(FdContext* ctx, uint32_t revents);
+
+		/**
+		 * @brief: 处理一个 CQE
+		 */
+		void handleCompletion(uint64_t user_data, int32_t res);
+
+		/**
+		 * @brief: 调用者已经成为 poller，收完事件后交出 poller
+		 * @param block 为 false 时不等待，只收已经就绪的
+		 */
+		void idleEpoll(bool block = true);
+
+		void idleUring(bool block = true);
+
+		/**
+		 * @brief: 取一个 SQE 并填好、发布，调用者持有 m_sqMutex。SQ 满时先提交
+		 */
+		void prepareSqe(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t off, uint32_t op_flags,
+						uint16_t buf_index, uint64_t user_data);
+
+		/**
+		 * @brief: 提交已发布的 SQE，不等待
+		 */
+		void flushSqes();
+
+		/**
+		 * @brief: 不在本调度器的工作线程上时没有 idle 替它批量提交，立即提交
+		 */
+		void flushIfExternal();
+
+		/**
+		 * @brief: 在 eventfd 上挂一个读，tickle 写 eventfd 时完成，把 poller 叫醒
+		 */
+		void armWakeup();
+
+		/**
+		 * @brief: 提交一个 SQE，挂起当前协程直到完成
+		 * @return CQE 的 res
+		 */
+		int32_t uringCall(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t off, uint32_t op_flags = 0,
+						uint16_t buf_index = 0);
+
+		/**
+		 * @brief: addEvent 后挂起，失败返回 -1
+		 */
+		int waitEvent(int fd, Event event);
+
+	private:
+		static const size_t s_fdChunkBits = 10;
+		static const size_t s_fdChunkSize = 1u << s_fdChunkBits;
+
+		Backend m_backend = EPOLL;
+		int m_epfd = -1;
+		int m_eventfd = -1;
+		std::atomic<uint64_t> m_pendingEventCount{0};
+		std::atomic<uint64_t> m_syscallCount{0};
+		// 正阻塞在 epoll_wait 上的工作线程，-1 表示没有
+		std::atomic<int> m_poller{-1};
+		// 忙碌的工作线程每执行这么多个任务顺带提交、收割一次
+		uint32_t m_pollInterval = 32;
+		// fd 上下文的两级数组
+		MutexType m_chunkMutex;
+		size_t m_chunkCount = 0;
+		std::unique_ptr<std::atomic<FdContext*>[]> m_chunks;
+
+		// io_uring 后端
+		IoUring m_uring;
+		// 保护 SQ 的生产端、m_sqPending 与 m_fileSlots
+		MutexType m_sqMutex;
+		// 已发布还没提交的 SQE 数
+		uint32_t m_sqPending = 0;
+		// fd 到固定文件下标，-1 表示没注册
+		std::vector<int> m_fileSlots;
+		// eventfd 读的目标
+		uint64_t m_wakeValue = 0;
+	};
+#pragma endregion IOManager
+}
+
+#endif //RAREVOYAGER_IO_MANAGER_H
@@ -0,0 +1,126 @@
+/*************************************************
+ * 描述：io_uring 的薄封装，直接用 io_uring_setup/enter/register 系统调用
+ * 与 mmap 出来的 SQ/CQ 环，不依赖 liburing
+ *
+ * File：io_uring.h
+ * Author：Cipher
+ * Date：2026/10/20-20:00
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_IO_URING_H
+#define RAREVOYAGER_IO_URING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+namespace RareVoyager
+{
+#pragma region IoUring
+	/**
+	 * @brief: 一个 io_uring 实例
+	 * 1. 只负责环的建立、取 SQE、发布、进入内核和收割 CQE，不做任何同步:
+	 *    SQ 的生产方和 CQ 的消费方各自只能有一个，由使用者加锁保证
+	 * 2. getSqe 取到的 SQE 已清零，填好后调用 publish 才对内核可见，
+	 *    enter 时 to_submit 个已发布的 SQE 一次提交
+	 */
+	class IoUring
+	{
+	public:
+		IoUring() = default;
+
+		~IoUring();
+
+		/**
+		 * @param entries SQ 大小，会被内核向上取 2 的幂
+		 * @param cq_entries CQ 大小，0 表示内核默认(SQ 的两倍)
+		 * @return 0 成功，失败返回 -errno
+		 */
+		int init(uint32_t entries, uint32_t cq_entries = 0);
+
+		bool isValid() const { return m_fd >= 0; }
+
+		int getFd() const { return m_fd; }
+
+		/**
+		 * @brief: 内核支持的 IORING_FEAT_* 特性
+		 */
+		uint32_t getFeatures() const { return m_features; }
+
+		uint32_t getSqEntries() const { return m_sqEntries; }
+
+		/**
+		 * @brief: 取一个空闲的 SQE，SQ 满了返回 nullptr
+		 */
+		io_uring_sqe* getSqe();
+
+		/**
+		 * @brief: 发布 getSqe 取到的所有 SQE
+		 */
+		void publish();
+
+		/**
+		 * @brief: io_uring_enter
+		 * @return 提交的 SQE 数，失败返回 -errno
+		 */
+		int enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags, const void* arg = nullptr,
+				size_t arg_size = 0);
+
+		/**
+		 * @brief: 把已完成的 CQE 复制出来并归还给内核
+		 * @return 复制的个数
+		 */
+		size_t reap(io_uring_cqe* cqes, size_t max);
+
+		/**
+		 * @brief: 注册固定缓冲区，之后可以用 READ_FIXED/WRITE_FIXED 按下标引用
+		 * @return 0 成功，失败返回 -errno
+		 */
+		int registerBuffers(const iovec* iovs, unsigned count);
+
+		int unregisterBuffers();
+
+		/**
+		 * @brief: 注册固定文件，之后 SQE 带 IOSQE_FIXED_FILE 时 fd 填下标，-1 表示空位
+		 * @return 0 成功，失败返回 -errno
+		 */
+		int registerFiles(const int* fds, unsigned count);
+
+		int unregisterFiles();
+
+	private:
+		IoUring(const IoUring&) = delete;
+
+		IoUring& operator=(const IoUring&) = delete;
+
+	private:
+		int m_fd = -1;
+		uint32_t m_features = 0;
+
+		void* m_sqRing = nullptr;
+		size_t m_sqRingSize = 0;
+		void* m_cqRing = nullptr;
+		size_t m_cqRingSize = 0;
+		io_uring_sqe* m_sqes = nullptr;
+		size_t m_sqesSize = 0;
+
+		uint32_t* m_sqHead = nullptr;
+		uint32_t* m_sqTail = nullptr;
+		uint32_t m_sqMask = 0;
+		uint32_t* m_sqArray = nullptr;
+		uint32_t m_sqEntries = 0;
+		// 已取出但还没发布的尾部
+		uint32_t m_sqeTail = 0;
+
+		uint32_t* m_cqHead = nullptr;
+		uint32_t* m_cqTail = nullptr;
+		uint32_t m_cqMask = 0;
+		io_uring_cqe* m_cqes = nullptr;
+	};
+#pragma endregion IoUring
+}
+
+#endif //RAREVOYAGER_IO_URING_H
@@ -4,7 +4,7 @@
  * File：logger.h
  * Author：Cipher
  * Date：2025/12/31-10:45
- * Update：
+ * Update：2026/10/19 Appender 集合改为 RCU 发布，写日志不再加锁；LogManager 改用 ConcurrentHashMap
  * ************************************************/
 
 #ifndef RAREVOYAGER_LOGGER_H
@@ -26,6 +26,8 @@
 
 #include <include/singleton.h>
 #include <include/thread/mutex.h>
+#include <include/thread/rcu.h>
+#include <include/thread/concurrent_hash_map.h>
 
 #define RUNKONW RareVoyager::LogLevel::Level::UNKNOW
 #define RDEBUG RareVoyager::LogLevel::Level::DEBUG
@@ -361,7 +363,8 @@ namespace RareVoyager
 	private:
 		std::string m_name;// 日志名称
 		LogLevel::Level m_level;// 日志级别
-		std::list<LogAppender::ptr> m_appenders;// Appender集合
+		// Appender集合，写日志时在 RCU 读临界区里遍历，增删时复制一份再发布
+		RcuPtr<std::vector<LogAppender::ptr> > m_appenders;
 		LogFormatter::ptr m_formatter;
 		ptr m_root;
 
@@ -426,10 +429,10 @@ namespace RareVoyager
 		void init();
 
 	private:
-		std::map<std::string, Logger::ptr> m_loggers;
+		// 按名字查找不加锁，见 ConcurrentHashMap
+		ConcurrentHashMap<std::string, Logger::ptr> m_loggers;
 		// 默认日志器，添加了一个向控制台输出的方法。
 		Logger::ptr m_root;
-		Mutex m_mutex;
 	};
 
 	// 使用模板类实现的单例模式
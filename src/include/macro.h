@@ -4,13 +4,32 @@
  * File：macro.h
  * Author：Cipher
  * Date：2026/1/13-10:51
- * Update：
+ * Update：2026/10/19 增加分支预测、缓存行与自旋等待相关宏
  * ************************************************/
 
 #ifndef RAREVOYAGER_MACRO_H
 #define RAREVOYAGER_MACRO_H
 
+// 分支预测提示，只用在热路径上
+#if defined(__GNUC__) || defined(__llvm__)
+#define RAREVOYAGER_LIKELY(x) __builtin_expect(!!(x), 1)
+#define RAREVOYAGER_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define RAREVOYAGER_LIKELY(x) (x)
+#define RAREVOYAGER_UNLIKELY(x) (x)
+#endif
 
+// 缓存行大小。被多个线程各自写入的数据按缓存行对齐，避免伪共享
+#define RAREVOYAGER_CACHELINE_SIZE 64
 
+// 自旋等待提示。x86 上是 pause 指令，降低自旋对流水线和超线程兄弟核的影响
+#if defined(__x86_64__) || defined(__i386__)
+#define RAREVOYAGER_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define RAREVOYAGER_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define RAREVOYAGER_CPU_RELAX() ((void)0)
+#endif
 
-#endif //RAREVOYAGER_MACRO_H
\ No newline at end of file
+
+#endif //RAREVOYAGER_MACRO_H
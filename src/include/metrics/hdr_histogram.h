@@ -0,0 +1,162 @@
+/*************************************************
+ * 描述：HdrHistogram 风格的对数-线性直方图，用于尾延迟统计
+ *
+ * File：hdr_histogram.h
+ * Author：Cipher
+ * Date：2026/10/19-11:30
+ * Update：2026/10/21 LatencyHistogram 按线程分片
+ * ************************************************/
+
+#ifndef RAREVOYAGER_HDR_HISTOGRAM_H
+#define RAREVOYAGER_HDR_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <include/metrics/metrics.h>
+
+namespace RareVoyager
+{
+#pragma region HdrHistogram
+	/**
+	 * @brief: 固定内存的对数-线性直方图，不保存样本也能回答 p99.9
+	 * 设精度位数为 P，则 [0, 2^P) 的值各占一个桶(精确)，之后每个2的幂区间再均分为 2^(P-1) 个桶，
+	 * 相对误差不超过 2^-(P-1)。P = 8 时约 7400 个桶(58KB)，误差 < 0.8%，覆盖整个 uint64 范围
+	 *
+	 * record() 只做一次 relaxed fetch_add，多线程同时写是 wait-free 的；
+	 * 追求零争用时每个线程各用一个实例，最后 merge 到一起
+	 */
+	class HdrHistogram
+	{
+	public:
+		typedef std::shared_ptr<HdrHistogram> ptr;
+
+		/**
+		 * @param precision_bits 精度位数 P，取值 [2, 16]
+		 */
+		explicit HdrHistogram(uint32_t precision_bits = 8);
+
+		HdrHistogram(const HdrHistogram& oth);
+
+		HdrHistogram& operator=(const HdrHistogram& oth) = delete;
+
+		void record(uint64_t value, uint64_t count = 1)
+		{
+			m_counts[indexOf(value)].fetch_add(count, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief: 把另一个同精度的直方图累加进来。精度不同时返回 false
+		 */
+		bool merge(const HdrHistogram& oth);
+
+		void reset();
+
+		uint32_t getPrecisionBits() const { return m_precisionBits; }
+
+		uint64_t getCount() const;
+
+		/**
+		 * @brief: 最小/最大值，返回所在桶的等价值，误差与精度一致
+		 */
+		uint64_t getMin() const;
+
+		uint64_t getMax() const;
+
+		/**
+		 * @brief: 以桶中点估算的平均值
+		 */
+		double getMean() const;
+
+		/**
+		 * @brief: 百分位数
+		 * @param percentile 取值 [0, 100]，如 99.9
+		 * @return 第一个累计计数达到该百分位的桶的上界
+		 */
+		uint64_t getValueAtPercentile(double percentile) const;
+
+		/**
+		 * @brief: 紧凑序列化。连续的空桶压缩为一个负数游程，所有数字用 zigzag + varint 编码
+		 */
+		std::string serialize() const;
+
+		/**
+		 * @brief: 反序列化，格式错误时返回 nullptr
+		 */
+		static ptr Deserialize(const std::string& data);
+
+		/**
+		 * @brief: 常用百分位的单行摘要，便于日志输出
+		 */
+		std::string toString() const;
+
+	private:
+		size_t indexOf(uint64_t value) const
+		{
+			if (value < m_subBucketCount)
+			{
+				return static_cast<size_t>(value);
+			}
+			uint32_t msb = 63 - __builtin_clzll(value);
+			uint32_t shift = msb - (m_precisionBits - 1);
+			uint64_t half = m_subBucketCount >> 1;
+			return static_cast<size_t>(m_subBucketCount + (shift - 1) * half + ((value >> shift) - half));
+		}
+
+		uint64_t lowestEquivalent(size_t index) const;
+
+		uint64_t highestEquivalent(size_t index) const;
+
+	private:
+		uint32_t m_precisionBits;
+		// 2^P
+		uint64_t m_subBucketCount;
+		size_t m_bucketCount;
+		std::unique_ptr<std::atomic<uint64_t>[]> m_counts;
+	};
+#pragma endregion HdrHistogram
+
+#pragma region LatencyHistogram
+	/**
+	 * @brief: 挂在 Metrics 注册表里的延迟直方图，以 Prometheus summary 的形式导出分位数
+	 * auto h = Metrics::Lookup<LatencyHistogram>("logger.log.latency_ns", "log latency");
+	 * 与 Counter 一样按 GetMetricShardIndex 分片，每个分片一个 HdrHistogram，record 只写本线程的分片，
+	 * 抓取时再合并
+	 */
+	class LatencyHistogram : public MetricBase
+	{
+	public:
+		typedef std::shared_ptr<LatencyHistogram> ptr;
+
+		LatencyHistogram(const std::string& name, const std::string& description = "",
+		                 uint32_t precision_bits = 8);
+
+		void record(uint64_t value) { m_shards[GetMetricShardIndex()]->record(value); }
+
+		/**
+		 * @brief: 合并某个线程私有的直方图
+		 */
+		void merge(const HdrHistogram& oth) { m_shards[GetMetricShardIndex()]->merge(oth); }
+
+		/**
+		 * @brief: 合并所有分片得到的快照
+		 */
+		HdrHistogram getHistogram() const;
+
+		std::string getTypeName() const override { return "summary"; }
+
+		std::string toYamlString() override;
+
+		std::string toPrometheusString() override;
+
+	private:
+		uint32_t m_precisionBits;
+		std::vector<std::unique_ptr<HdrHistogram> > m_shards;
+	};
+#pragma endregion LatencyHistogram
+}
+
+#endif //RAREVOYAGER_HDR_HISTOGRAM_H
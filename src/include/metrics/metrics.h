@@ -0,0 +1,337 @@
+/*************************************************
+ * 描述：指标系统。计数器、仪表盘、直方图及其注册表
+ *
+ * File：metrics.h
+ * Author：Cipher
+ * Date：2026/10/19-10:20
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_METRICS_H
+#define RAREVOYAGER_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <include/macro.h>
+#include <include/util.h>
+#include <include/thread/mutex.h>
+#include <include/logger/logger.h>
+
+/**
+ * 原则: 热路径只写本线程的分片，聚合只在抓取(scrape)时发生
+ */
+namespace RareVoyager
+{
+#pragma region MetricShard
+	/**
+	 * @brief: 分片数量。取CPU核数向上取整的2的幂，最多64个
+	 */
+	uint32_t GetMetricShardCount();
+
+	/**
+	 * @brief: 当前线程使用的分片下标。线程第一次调用时轮询分配，之后缓存在thread_local中
+	 */
+	uint32_t GetMetricShardIndex();
+
+	/**
+	 * @brief: 独占一条缓存行的原子变量，避免不同分片之间的伪共享
+	 */
+	template<typename T>
+	struct alignas(RAREVOYAGER_CACHELINE_SIZE) PaddedAtomic
+	{
+		std::atomic<T> value{0};
+	};
+#pragma endregion MetricShard
+
+#pragma region MetricBase
+	/**
+	 * @brief: 指标基类
+	 */
+	class MetricBase
+	{
+	public:
+		typedef std::shared_ptr<MetricBase> ptr;
+
+		MetricBase(const std::string& name, const std::string& description);
+
+		virtual ~MetricBase() = default;
+
+		const std::string& getName() const { return m_name; }
+
+		const std::string& getDescription() const { return m_description; }
+
+		/**
+		 * @brief: 指标类型 counter / gauge / histogram
+		 */
+		virtual std::string getTypeName() const = 0;
+
+		virtual std::string toYamlString() = 0;
+
+		/**
+		 * @brief: Prometheus 文本格式。指标名中的 '.' 会被替换为 '_'
+		 */
+		virtual std::string toPrometheusString() = 0;
+
+	protected:
+		/**
+		 * @brief: 输出 # HELP 与 # TYPE 两行
+		 */
+		std::string prometheusHeader() const;
+
+		/**
+		 * @brief: Prometheus 格式的指标名
+		 */
+		std::string prometheusName() const;
+
+	private:
+		std::string m_name;// 名字
+		std::string m_description;// 描述
+	};
+#pragma endregion MetricBase
+
+#pragma region Counter
+	/**
+	 * @brief: 只增不减的计数器。inc 只对本线程分片做一次 relaxed fetch_add
+	 */
+	class Counter : public MetricBase
+	{
+	public:
+		typedef std::shared_ptr<Counter> ptr;
+
+		Counter(const std::string& name, const std::string& description = "");
+
+		void inc(uint64_t v = 1)
+		{
+			m_shards[GetMetricShardIndex()].value.fetch_add(v, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief: 汇总所有分片
+		 */
+		uint64_t getValue() const;
+
+		std::string getTypeName() const override { return "counter"; }
+
+		std::string toYamlString() override;
+
+		std::string toPrometheusString() override;
+
+	private:
+		std::unique_ptr<PaddedAtomic<uint64_t>[]> m_shards;
+	};
+#pragma endregion Counter
+
+#pragma region Gauge
+	/**
+	 * @brief: 可增可减的仪表盘。add/sub 走分片，set 直接改基准值
+	 * set 与并发的 add 之间没有原子性保证，适合"偶尔校准，频繁增减"的场景
+	 */
+	class Gauge : public MetricBase
+	{
+	public:
+		typedef std::shared_ptr<Gauge> ptr;
+
+		Gauge(const std::string& name, const std::string& description = "");
+
+		void add(int64_t v)
+		{
+			m_shards[GetMetricShardIndex()].value.fetch_add(v, std::memory_order_relaxed);
+		}
+
+		void sub(int64_t v) { add(-v); }
+
+		void inc() { add(1); }
+
+		void dec() { add(-1); }
+
+		void set(int64_t v);
+
+		int64_t getValue() const;
+
+		std::string getTypeName() const override { return "gauge"; }
+
+		std::string toYamlString() override;
+
+		std::string toPrometheusString() override;
+
+	private:
+		int64_t sumShards() const;
+
+	private:
+		std::atomic<int64_t> m_base{0};
+		std::unique_ptr<PaddedAtomic<int64_t>[]> m_shards;
+	};
+#pragma endregion Gauge
+
+#pragma region Histogram
+	/**
+	 * @brief: 固定桶边界的直方图(Prometheus 语义，桶边界为上界 le)
+	 * 每个分片独占若干缓存行，存放该分片所有桶的计数和总和
+	 */
+	class Histogram : public MetricBase
+	{
+	public:
+		typedef std::shared_ptr<Histogram> ptr;
+
+		/**
+		 * @param bounds 桶上界，需递增。为空时使用默认的延迟桶(单位ms)
+		 */
+		Histogram(const std::string& name, const std::string& description = "",
+		          std::vector<double> bounds = {});
+
+		void observe(double v);
+
+		/**
+		 * @brief: 汇总后的各桶计数(非累计)，最后一个为 +Inf 桶
+		 */
+		std::vector<uint64_t> getBucketCounts() const;
+
+		uint64_t getCount() const;
+
+		double getSum() const;
+
+		const std::vector<double>& getBounds() const { return m_bounds; }
+
+		std::string getTypeName() const override { return "histogram"; }
+
+		std::string toYamlString() override;
+
+		std::string toPrometheusString() override;
+
+	private:
+		struct alignas(RAREVOYAGER_CACHELINE_SIZE) CacheLine
+		{
+			std::atomic<uint64_t> words[RAREVOYAGER_CACHELINE_SIZE / sizeof(uint64_t)];
+		};
+
+		/**
+		 * @brief: 第shard个分片的第i个字。字0存总和(double的位模式)，字1开始是各桶计数
+		 */
+		std::atomic<uint64_t>& word(uint32_t shard, size_t i) const;
+
+	private:
+		std::vector<double> m_bounds;
+		// 每个分片占用的缓存行数
+		size_t m_linesPerShard = 0;
+		std::unique_ptr<CacheLine[]> m_lines;
+	};
+#pragma endregion Histogram
+
+#pragma region Metrics
+	/**
+	 * @brief: 指标注册表，用法与 Config::Lookup 一致
+	 * auto c = Metrics::Lookup<Counter>("net.accept.count", "accepted connections");
+	 */
+	class Metrics
+	{
+	public:
+		typedef RWMutex RWMutexType;
+		typedef std::map<std::string, MetricBase::ptr> MetricMap;
+
+		enum Format
+		{
+			FORMAT_YAML = 0,// YAML 格式
+			FORMAT_PROMETHEUS = 1// Prometheus 文本格式
+		};
+
+		/**
+		 * @brief: 有返回没有创建。已存在但类型不一致时返回 nullptr
+		 * @tparam T Counter / Gauge / Histogram
+		 * @param args 透传给 T 构造函数的额外参数(如直方图的桶边界)
+		 */
+		template<class T, class... Args>
+		static typename T::ptr Lookup(const std::string& name, const std::string& description, Args&&... args)
+		{
+			// Cast 失败会打日志，而 Logger 本身也会查找指标，所以必须在锁外调用
+			MetricBase::ptr exists;
+			{
+				RWMutexType::ReadLock lock(&GetMutex());
+				auto it = GetDatas().find(name);
+				if (it != GetDatas().end())
+				{
+					exists = it->second;
+				}
+			}
+			if (exists)
+			{
+				return Cast<T>(name, exists);
+			}
+
+			if (!IsValidName(name))
+			{
+				RAREVOYAGER_LOG_ERROR(RAREVOYAGER_LOG_ROOT()) << "Metrics::Lookup name invalid " << name;
+				throw std::invalid_argument(name);
+			}
+
+			{
+				RWMutexType::WriteLock lock(&GetMutex());
+				auto it = GetDatas().find(name);
+				if (it == GetDatas().end())
+				{
+					typename T::ptr v(new T(name, description, std::forward<Args>(args)...));
+					GetDatas()[name] = v;
+					return v;
+				}
+				exists = it->second;
+			}
+			return Cast<T>(name, exists);
+		}
+
+		template<class T>
+		static typename T::ptr Lookup(const std::string& name)
+		{
+			return Lookup<T>(name, "");
+		}
+
+		static MetricBase::ptr LookupBase(const std::string& name);
+
+		/**
+		 * @brief: 抓取所有指标的快照
+		 */
+		static std::string Scrape(Format format);
+
+		static std::string ToYamlString() { return Scrape(FORMAT_YAML); }
+
+		static std::string ToPrometheusString() { return Scrape(FORMAT_PROMETHEUS); }
+
+		/**
+		 * @brief: 把快照写入文件。先写临时文件再 rename，读者不会看到写了一半的内容
+		 */
+		static bool DumpToFile(const std::string& filename, Format format);
+
+	private:
+		static bool IsValidName(const std::string& name);
+
+		template<class T>
+		static typename T::ptr Cast(const std::string& name, const MetricBase::ptr& base)
+		{
+			auto tmp = std::dynamic_pointer_cast<T>(base);
+			if (!tmp)
+			{
+				RAREVOYAGER_LOG_ERROR(RAREVOYAGER_LOG_ROOT()) << "Metrics::Lookup name " << name
+						<< " exists but type not " << typeid(T).name() << " real_type " << base->getTypeName();
+			}
+			return tmp;
+		}
+
+		static MetricMap& GetDatas()
+		{
+			static MetricMap s_datas;
+			return s_datas;
+		}
+
+		static RWMutexType& GetMutex()
+		{
+			static RWMutexType s_mutex;
+			return s_mutex;
+		}
+	};
+#pragma endregion Metrics
+}
+
+#endif //RAREVOYAGER_METRICS_H
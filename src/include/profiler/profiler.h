@@ -0,0 +1,81 @@
+/*************************************************
+ * 描述：进程内采样分析器。按线程 CPU 时间定时发送 SIGPROF，
+ * 在信号处理函数里抓取调用栈，离线聚合后输出 flamegraph 使用的折叠栈
+ *
+ * File：profiler.h
+ * Author：Cipher
+ * Date：2026/10/19-15:10
+ * Update：2026/10/21 信号处理函数改为沿帧指针回溯，不再调用非异步信号安全的 backtrace
+ * ************************************************/
+
+#ifndef RAREVOYAGER_PROFILER_H
+#define RAREVOYAGER_PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RareVoyager
+{
+#pragma region Symbolizer
+	/**
+	 * @brief: 把地址翻译成可读的函数名(已 demangle)。找不到符号时输出 "模块名+0x偏移"
+	 * 静态函数需要以 -rdynamic 链接才能解析出名字
+	 */
+	std::string SymbolizeAddress(void* addr);
+#pragma endregion Symbolizer
+
+#pragma region Profiler
+	/**
+	 * @brief: 采样分析器
+	 * 1. 每个注册的线程一个 timer_create(线程 CPU 时钟) 定时器，只有线程真正在跑时才会采样
+	 * 2. 信号处理函数只沿帧指针回溯并写入无锁环形缓冲区，不加锁不分配内存，
+	 *    需要以 -fno-omit-frame-pointer 编译，没有帧指针的代码处回溯会提前结束
+	 * 3. 后台线程定期把缓冲区聚合成 调用栈->次数，符号化推迟到输出时
+	 *
+	 * RareVoyager::Thread 会自动注册，其它线程(如主线程)需要手动调用 RegisterThread
+	 * 配置项:
+	 *   profiler.enable     运行时开关
+	 *   profiler.frequency  每秒采样次数(按线程 CPU 时间)
+	 *   profiler.output     停止时把折叠栈写入该文件
+	 */
+	class Profiler
+	{
+	public:
+		static bool Start();
+
+		static void Stop();
+
+		static bool IsRunning();
+
+		/**
+		 * @brief: 注册当前线程。分析器运行中时立即开始采样
+		 */
+		static void RegisterThread();
+
+		/**
+		 * @brief: 注销当前线程，线程退出前必须调用
+		 */
+		static void UnregisterThread();
+
+		/**
+		 * @brief: 折叠栈文本，每行 "线程名;外层函数;...;内层函数 次数"
+		 */
+		static std::string GetFoldedStacks();
+
+		static bool WriteFoldedStacks(const std::string& filename);
+
+		/**
+		 * @brief: 清空已聚合的样本
+		 */
+		static void Reset();
+
+		/**
+		 * @brief: 缓冲区满时丢弃的样本数
+		 */
+		static uint64_t GetDroppedSamples();
+	};
+#pragma endregion Profiler
+}
+
+#endif //RAREVOYAGER_PROFILER_H
@@ -0,0 +1,112 @@
+/*************************************************
+ * 描述：基于 futex 的 Latch(一次性倒计数)与 Barrier(可重复使用的栅栏)
+ *
+ * File：barrier.h
+ * Author：Cipher
+ * Date：2026/10/20-10:10
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_BARRIER_H
+#define RAREVOYAGER_BARRIER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace RareVoyager
+{
+#pragma region Latch
+	/**
+	 * @brief: 倒计数门闩，计数减到 0 后所有等待者放行，之后不能重置
+	 * 计数不为 0 时 countDown 只是一次原子减，只有最后一次才进内核唤醒
+	 */
+	class Latch
+	{
+	public:
+		explicit Latch(uint32_t count);
+
+		/**
+		 * @brief: 计数减 n，减到 0 时唤醒所有等待者
+		 */
+		void countDown(uint32_t n = 1);
+
+		void wait();
+
+		/**
+		 * @brief: 不阻塞，计数已经为 0 时返回 true
+		 */
+		bool tryWait() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+		/**
+		 * @brief: 最多等待 timeout，超时返回 false
+		 */
+		template<class Rep, class Period>
+		bool waitFor(const std::chrono::duration<Rep, Period>& timeout)
+		{
+			return waitUntil(std::chrono::steady_clock::now() + timeout);
+		}
+
+		bool waitUntil(const std::chrono::steady_clock::time_point& deadline);
+
+		/**
+		 * @brief: countDown(n) 后等待
+		 */
+		void arriveAndWait(uint32_t n = 1);
+
+		uint32_t getCount() const { return m_count.load(std::memory_order_relaxed); }
+
+	private:
+		Latch(const Latch&) = delete;
+
+		Latch& operator=(const Latch&) = delete;
+
+	private:
+		// futex 字
+		std::atomic<uint32_t> m_count;
+	};
+#pragma endregion Latch
+
+#pragma region Barrier
+	/**
+	 * @brief: 可重复使用的栅栏，每凑齐 count 个线程放行一轮
+	 * 等待者在代数(generation)上睡眠，最后到达的线程先执行完成回调，再把代数加一并唤醒其它线程
+	 */
+	class Barrier
+	{
+	public:
+		/**
+		 * @param on_complete 每轮最后到达的线程在放行前调用，可以为空
+		 */
+		explicit Barrier(uint32_t count, std::function<void()> on_complete = nullptr);
+
+		/**
+		 * @brief: 到达并等待本轮所有线程到达
+		 * @return 最后到达(执行了完成回调)的线程返回 true，其余返回 false
+		 */
+		bool arriveAndWait();
+
+		uint32_t getCount() const { return m_count; }
+
+		/**
+		 * @brief: 已经完成的轮数
+		 */
+		uint32_t getGeneration() const { return m_generation.load(std::memory_order_relaxed); }
+
+	private:
+		Barrier(const Barrier&) = delete;
+
+		Barrier& operator=(const Barrier&) = delete;
+
+	private:
+		const uint32_t m_count;
+		std::function<void()> m_onComplete;
+		std::atomic<uint32_t> m_arrived{0};
+		// futex 字
+		std::atomic<uint32_t> m_generation{0};
+	};
+#pragma endregion Barrier
+}
+
+#endif //RAREVOYAGER_BARRIER_H
@@ -0,0 +1,409 @@
+/*************************************************
+ * 描述：并发哈希表。按哈希分片，写者按分片加锁，读者通过 RCU 无锁查找，
+ * 适合日志器、配置项这类读远多于写的注册表
+ *
+ * File：concurrent_hash_map.h
+ * Author：Cipher
+ * Date：2026/10/19-23:20
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_CONCURRENT_HASH_MAP_H
+#define RAREVOYAGER_CONCURRENT_HASH_MAP_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <include/macro.h>
+#include <include/thread/mutex.h>
+#include <include/thread/rcu.h>
+
+namespace RareVoyager
+{
+	/**
+	 * @brief: 字符串哈希，std::string、std::string_view、const char* 结果相同，用于异构查找
+	 */
+	struct StringHash
+	{
+		typedef void is_transparent;
+
+		size_t operator()(std::string_view str) const
+		{
+			return std::hash<std::string_view>()(str);
+		}
+	};
+
+#pragma region ConcurrentHashMap
+	/**
+	 * @brief: 分片并发哈希表
+	 * 1. 键按哈希分到 2 的幂个分片，每个分片一个 Mutex 和一张拉链哈希表，不同分片的写互不影响
+	 * 2. 查找与遍历在 RCU 读临界区里进行，不加锁、不写共享内存；节点插入后不再修改，
+	 *    覆盖值时换一个新节点，被替换、删除的节点和扩容前的旧表都延迟释放
+	 * 3. 查找支持异构键: 键为 std::string 时可以直接用 std::string_view 或字符串字面量查找，不构造临时 string
+	 * 4. 遍历不阻塞写者，看到的是每个分片某一时刻的内容，不是整张表的快照
+	 * 值按拷贝返回，V 通常是 shared_ptr
+	 */
+	template<class K, class V,
+		class Hash = typename std::conditional<std::is_same<K, std::string>::value, StringHash, std::hash<K> >::type,
+		class KeyEqual = std::equal_to<> >
+	class ConcurrentHashMap
+	{
+	public:
+		typedef Mutex MutexType;
+
+		/**
+		 * @param shards 分片数，向上取整到 2 的幂
+		 */
+		explicit ConcurrentHashMap(size_t shards = 16)
+		{
+			size_t n = 1;
+			while (n < shards)
+			{
+				n <<= 1;
+				++m_shardBits;
+			}
+			m_shardMask = n - 1;
+			m_shards = new Shard[n];
+			for (size_t i = 0; i < n; ++i)
+			{
+				m_shards[i].table.store(new Table(s_initialBuckets), std::memory_order_relaxed);
+			}
+		}
+
+		~ConcurrentHashMap()
+		{
+			// 析构时不应该再有读者，节点直接释放
+			for (size_t i = 0; i <= m_shardMask; ++i)
+			{
+				Table* table = m_shards[i].table.load(std::memory_order_relaxed);
+				table->destroyNodes();
+				delete table;
+			}
+			delete[] m_shards;
+		}
+
+		/**
+		 * @brief: 查找，找到时拷贝到 value
+		 */
+		template<class Q>
+		bool find(const Q& key, V& value) const
+		{
+			size_t hash = m_hash(key);
+			RcuReadLock rcu;
+			const Node* node = findNode(shardOf(hash), hash, key);
+			if (!node)
+			{
+				return false;
+			}
+			value = node->value;
+			return true;
+		}
+
+		template<class Q>
+		bool contains(const Q& key) const
+		{
+			size_t hash = m_hash(key);
+			RcuReadLock rcu;
+			return findNode(shardOf(hash), hash, key) != nullptr;
+		}
+
+		/**
+		 * @brief: 不存在时插入
+		 * @return 是否插入
+		 */
+		bool insert(const K& key, const V& value)
+		{
+			bool inserted = false;
+			getOrInsert(key, [&value, &inserted]() {
+				inserted = true;
+				return value;
+			});
+			return inserted;
+		}
+
+		/**
+		 * @brief: 返回已有的值；不存在时在分片锁内调用 make() 创建并插入，同一个键只会创建一次
+		 * make 里不要再访问同一个表的同一个分片
+		 */
+		template<class F>
+		V getOrInsert(const K& key, F make)
+		{
+			size_t hash = m_hash(key);
+			Shard& shard = shardOf(hash);
+			{
+				RcuReadLock rcu;
+				if (const Node* node = findNode(shard, hash, key))
+				{
+					return node->value;
+				}
+			}
+			MutexType::Lock lock(&shard.mutex);
+			if (const Node* node = findNode(shard, hash, key))
+			{
+				return node->value;
+			}
+			V value = make();
+			insertNode(shard, new Node(key, value, hash));
+			return value;
+		}
+
+		/**
+		 * @brief: 插入或覆盖
+		 */
+		void insertOrAssign(const K& key, const V& value)
+		{
+			size_t hash = m_hash(key);
+			Shard& shard = shardOf(hash);
+			MutexType::Lock lock(&shard.mutex);
+			Table* table = shard.table.load(std::memory_order_relaxed);
+			std::atomic<Node*>* link = &table->bucket(hash >> m_shardBits);
+			for (Node* node = link->load(std::memory_order_relaxed); node;
+			     node = node->next.load(std::memory_order_relaxed))
+			{
+				if (node->hash == hash && m_equal(node->key, key))
+				{
+					// 新节点接在旧节点的位置上，旧节点等读者离开后释放
+					Node* replace = new Node(key, value, hash);
+					replace->next.store(node->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					link->store(replace, std::memory_order_release);
+					Rcu::DeferDelete(node);
+					return;
+				}
+				link = &node->next;
+			}
+			insertNode(shard, new Node(key, value, hash));
+		}
+
+		template<class Q>
+		bool erase(const Q& key)
+		{
+			size_t hash = m_hash(key);
+			Shard& shard = shardOf(hash);
+			MutexType::Lock lock(&shard.mutex);
+			Table* table = shard.table.load(std::memory_order_relaxed);
+			std::atomic<Node*>* link = &table->bucket(hash >> m_shardBits);
+			for (Node* node = link->load(std::memory_order_relaxed); node;
+			     node = node->next.load(std::memory_order_relaxed))
+			{
+				if (node->hash == hash && m_equal(node->key, key))
+				{
+					link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+					--table->count;
+					shard.size.fetch_sub(1, std::memory_order_relaxed);
+					Rcu::DeferDelete(node);
+					return true;
+				}
+				link = &node->next;
+			}
+			return false;
+		}
+
+		void clear()
+		{
+			for (size_t i = 0; i <= m_shardMask; ++i)
+			{
+				Shard& shard = m_shards[i];
+				MutexType::Lock lock(&shard.mutex);
+				Table* old = shard.table.exchange(new Table(s_initialBuckets), std::memory_order_acq_rel);
+				shard.size.store(0, std::memory_order_relaxed);
+				Rcu::DeferFree([old]() {
+					old->destroyNodes();
+					delete old;
+				});
+			}
+		}
+
+		/**
+		 * @brief: 对每个元素调用 cb(key, value)，期间可以并发读写
+		 * cb 在 RCU 读临界区里执行，不能调用 Rcu::Synchronize
+		 */
+		template<class F>
+		void forEach(F cb) const
+		{
+			for (size_t i = 0; i <= m_shardMask; ++i)
+			{
+				RcuReadLock rcu;
+				const Table* table = m_shards[i].table.load(std::memory_order_acquire);
+				for (size_t b = 0; b <= table->mask; ++b)
+				{
+					for (const Node* node = table->buckets[b].load(std::memory_order_acquire); node;
+					     node = node->next.load(std::memory_order_acquire))
+					{
+						cb(node->key, node->value);
+					}
+				}
+			}
+		}
+
+		/**
+		 * @brief: 拷贝出全部元素
+		 */
+		std::vector<std::pair<K, V> > snapshot() const
+		{
+			std::vector<std::pair<K, V> > items;
+			items.reserve(size());
+			forEach([&items](const K& key, const V& value) { items.emplace_back(key, value); });
+			return items;
+		}
+
+		/**
+		 * @brief: 近似的元素个数
+		 */
+		size_t size() const
+		{
+			size_t n = 0;
+			for (size_t i = 0; i <= m_shardMask; ++i)
+			{
+				n += m_shards[i].size.load(std::memory_order_relaxed);
+			}
+			return n;
+		}
+
+		bool empty() const { return size() == 0; }
+
+		size_t getShardCount() const { return m_shardMask + 1; }
+
+	private:
+		struct Node
+		{
+			Node(const K& k, const V& v, size_t h) : key(k), value(v), hash(h)
+			{
+			}
+
+			const K key;
+			const V value;
+			const size_t hash;
+			std::atomic<Node*> next{nullptr};
+		};
+
+		struct Table
+		{
+			explicit Table(size_t n) : mask(n - 1), buckets(new std::atomic<Node*>[n])
+			{
+				for (size_t i = 0; i < n; ++i)
+				{
+					buckets[i].store(nullptr, std::memory_order_relaxed);
+				}
+			}
+
+			~Table()
+			{
+				delete[] buckets;
+			}
+
+			std::atomic<Node*>& bucket(size_t h) { return buckets[h & mask]; }
+
+			const std::atomic<Node*>& bucket(size_t h) const { return buckets[h & mask]; }
+
+			void destroyNodes()
+			{
+				for (size_t i = 0; i <= mask; ++i)
+				{
+					Node* node = buckets[i].load(std::memory_order_relaxed);
+					while (node)
+					{
+						Node* next = node->next.load(std::memory_order_relaxed);
+						delete node;
+						node = next;
+					}
+				}
+			}
+
+			const size_t mask;
+			std::atomic<Node*>* const buckets;
+			// 只在分片锁内读写
+			size_t count = 0;
+		};
+
+		struct alignas(RAREVOYAGER_CACHELINE_SIZE) Shard
+		{
+			MutexType mutex;
+			std::atomic<Table*> table{nullptr};
+			std::atomic<size_t> size{0};
+		};
+
+		ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+
+		ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+		Shard& shardOf(size_t hash) const { return m_shards[hash & m_shardMask]; }
+
+		/**
+		 * @brief: 读临界区或分片锁内调用
+		 */
+		template<class Q>
+		const Node* findNode(const Shard& shard, size_t hash, const Q& key) const
+		{
+			const Table* table = shard.table.load(std::memory_order_acquire);
+			for (const Node* node = table->bucket(hash >> m_shardBits).load(std::memory_order_acquire); node;
+			     node = node->next.load(std::memory_order_acquire))
+			{
+				if (node->hash == hash && m_equal(node->key, key))
+				{
+					return node;
+				}
+			}
+			return nullptr;
+		}
+
+		/**
+		 * @brief: 插到桶头，调用者持有分片锁且确认键不存在
+		 */
+		void insertNode(Shard& shard, Node* node)
+		{
+			Table* table = shard.table.load(std::memory_order_relaxed);
+			if (table->count >= table->mask + 1)
+			{
+				table = grow(shard, table);
+			}
+			std::atomic<Node*>& head = table->bucket(node->hash >> m_shardBits);
+			node->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			head.store(node, std::memory_order_release);
+			++table->count;
+			shard.size.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief: 桶数翻倍。读者可能还在遍历旧表的链，所以复制全部节点到新表，旧表连同旧节点延迟释放
+		 */
+		Table* grow(Shard& shard, Table* old)
+		{
+			Table* table = new Table((old->mask + 1) * 2);
+			for (size_t i = 0; i <= old->mask; ++i)
+			{
+				for (Node* node = old->buckets[i].load(std::memory_order_relaxed); node;
+				     node = node->next.load(std::memory_order_relaxed))
+				{
+					Node* copy = new Node(node->key, node->value, node->hash);
+					std::atomic<Node*>& head = table->bucket(node->hash >> m_shardBits);
+					copy->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					head.store(copy, std::memory_order_relaxed);
+				}
+			}
+			table->count = old->count;
+			shard.table.store(table, std::memory_order_release);
+			Rcu::DeferFree([old]() {
+				old->destroyNodes();
+				delete old;
+			});
+			return table;
+		}
+
+	private:
+		static const size_t s_initialBuckets = 8;
+
+		Shard* m_shards = nullptr;
+		size_t m_shardMask = 0;
+		size_t m_shardBits = 0;
+		Hash m_hash;
+		KeyEqual m_equal;
+	};
+#pragma endregion ConcurrentHashMap
+}
+
+#endif //RAREVOYAGER_CONCURRENT_HASH_MAP_H
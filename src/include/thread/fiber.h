@@ -1,17 +1,156 @@
 /*************************************************
- * 描述：
+ * 描述：协程。基于 boost::context::fiber 做上下文切换，栈由协程对象持有，reset 后可以复用
  *
  * File：fiber.h
  * Author：Cipher
  * Date：2026/1/13-11:09
- * Update：
+ * Update：2026/10/20 实现 Fiber: resume/yield、状态、每线程的当前协程与主协程、协程 id
+ *         2026/10/20 栈改由 StackAllocator 分配(mmap、保护页、每线程缓存)
+ *         2026/10/20 resume 等待协程从上一个线程切出，调度器可以跨线程唤醒协程
+ *         2026/10/21 增加 GetStackRange，采样分析器在信号处理函数里按帧指针回溯时用来限定范围
  * ************************************************/
 
 #ifndef RAREVOYAGER_FIBER_H
 #define RAREVOYAGER_FIBER_H
-#include <include/boost/context/fiber.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
 
+#include <boost/context/fiber.hpp>
 
+namespace RareVoyager
+{
+#pragma region Fiber
+	/**
+	 * @brief: 非对称协程
+	 * resume 从当前协程切换到本协程，yield 切回调用 resume 的协程，可以嵌套
+	 * 每个线程第一次调用 GetThis 时把线程本身包装成主协程，主协程没有独立的栈
+	 * 回调执行完后状态变为 TERM，栈保留在对象里，reset 换一个回调即可复用，不用重新分配
+	 */
+	class Fiber : public std::enable_shared_from_this<Fiber>
+	{
+	public:
+		typedef std::shared_ptr<Fiber> ptr;
 
+		enum State
+		{
+			// 刚创建或 reset，还没运行过
+			INIT,
+			// 让出执行权，等待再次调度
+			READY,
+			RUNNING,
+			// 让出执行权，等待外部事件唤醒
+			HOLD,
+			// 回调正常结束
+			TERM,
+			// 回调抛出异常
+			EXCEPT
+		};
 
-#endif //RAREVOYAGER_FIBER_H
\ No newline at end of file
+		/**
+		 * @param stack_size 栈大小，0 使用配置 fiber.stack_size
+		 */
+		explicit Fiber(std::function<void()> cb, size_t stack_size = 0);
+
+		~Fiber();
+
+		/**
+		 * @brief: 换一个回调，复用原来的栈，只能在 INIT、TERM、EXCEPT 状态调用
+		 */
+		void reset(std::function<void()> cb);
+
+		/**
+		 * @brief: 切换到本协程执行，直到它 yield 或结束
+		 * 协程刚 yield 还没切出另一个线程时，会短暂自旋等待，所以可以在任意线程 resume
+		 * @return 切回来时协程的状态。返回后协程可能已经被别的线程唤醒，调度器应当以返回值为准
+		 */
+		State resume();
+
+		/**
+		 * @brief: 切回调用 resume 的协程，只能由本协程自己调用
+		 * 状态仍为 RUNNING 时改为 HOLD；调用前设置成 READY 则保持 READY
+		 */
+		void yield();
+
+		uint64_t getId() const { return m_id; }
+
+		State getState() const { return m_state; }
+
+		void setState(State state) { m_state = state; }
+
+		size_t getStackSize() const { return m_stackSize; }
+
+		/**
+		 * @brief: 当前线程正在执行的协程，线程还没有协程时创建主协程
+		 */
+		static Fiber::ptr GetThis();
+
+		/**
+		 * @brief: 当前协程的栈范围 [lo, hi)。主协程用的是线程栈，返回 false
+		 * 只读线程局部变量，不分配内存，可以在信号处理函数里调用
+		 */
+		static bool GetStackRange(uintptr_t& lo, uintptr_t& hi);
+
+		/**
+		 * @brief: 当前线程的主协程，没有返回 nullptr
+		 */
+		static Fiber* GetMainFiber();
+
+		/**
+		 * @brief: 当前协程让出执行权并设为 READY
+		 */
+		static void YieldToReady();
+
+		/**
+		 * @brief: 当前协程让出执行权并设为 HOLD
+		 */
+		static void YieldToHold();
+
+		/**
+		 * @brief: 存活的协程数，不含主协程
+		 */
+		static uint64_t TotalFibers();
+
+		/**
+		 * @brief: 当前协程 id，线程还没有使用协程时返回 0
+		 */
+		static uint64_t GetFiberId();
+
+	private:
+		/**
+		 * @brief: 主协程
+		 */
+		Fiber();
+
+		Fiber(const Fiber&) = delete;
+
+		Fiber& operator=(const Fiber&) = delete;
+
+		/**
+		 * @brief: 在 m_stack 上创建新的上下文
+		 */
+		void makeContext();
+
+		/**
+		 * @brief: 协程入口，参数是调用 resume 的上下文
+		 */
+		boost::context::fiber run(boost::context::fiber&& caller);
+
+	private:
+		uint64_t m_id = 0;
+		State m_state = INIT;
+		std::function<void()> m_cb;
+		// 本协程挂起时的上下文
+		boost::context::fiber m_ctx;
+		// 调用 resume 的上下文，yield 时切回这里
+		boost::context::fiber m_caller;
+		void* m_stack = nullptr;
+		size_t m_stackSize = 0;
+		// 从 resume 开始到切回 resume 的调用者为止为 true，防止两个线程同时切入
+		std::atomic<bool> m_switching{false};
+	};
+#pragma endregion Fiber
+}
+
+#endif //RAREVOYAGER_FIBER_H
@@ -0,0 +1,33 @@
+/*************************************************
+ * 描述：futex 系统调用的简单封装，给需要自己实现阻塞等待的同步原语使用
+ *
+ * File：futex.h
+ * Author：Cipher
+ * Date：2026/10/19-17:05
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_FUTEX_H
+#define RAREVOYAGER_FUTEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+namespace RareVoyager
+{
+	/**
+	 * @brief: 如果 *addr == expected 就睡眠，直到被 FutexWake 唤醒、超时或被信号打断
+	 * @param timeout 相对超时时间，nullptr 表示一直等
+	 * @return 被唤醒或值已经不等于 expected 时返回 true，超时返回 false
+	 * 注意可能发生虚假唤醒，调用方需要循环检查条件
+	 */
+	bool FutexWait(std::atomic<uint32_t>* addr, uint32_t expected, const timespec* timeout = nullptr);
+
+	/**
+	 * @brief: 唤醒最多 count 个在 addr 上等待的线程，返回实际唤醒的个数
+	 */
+	int FutexWake(std::atomic<uint32_t>* addr, int count);
+}
+
+#endif //RAREVOYAGER_FUTEX_H
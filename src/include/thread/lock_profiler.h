@@ -0,0 +1,270 @@
+/*************************************************
+ * 描述：锁竞争分析。具名锁在加锁时统计获取次数、竞争次数、等待时间与持有时间，
+ * 并抽样记录等待者的调用栈，用来找出最热的锁
+ *
+ * File：lock_profiler.h
+ * Author：Cipher
+ * Date：2026/10/19-16:20
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_LOCK_PROFILER_H
+#define RAREVOYAGER_LOCK_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <include/thread/mutex.h>
+#include <include/util.h>
+
+namespace RareVoyager
+{
+#pragma region LockStats
+	/**
+	 * @brief: 一把(或同名的多把)锁的统计数据
+	 */
+	class LockStats
+	{
+	public:
+		typedef std::shared_ptr<LockStats> ptr;
+
+		/**
+		 * @brief: 抽样到的等待者调用栈
+		 */
+		struct WaiterStack
+		{
+			std::vector<void*> frames;
+			uint64_t count = 0;
+			uint64_t waitNS = 0;
+		};
+
+		explicit LockStats(const std::string& name);
+
+		const std::string& getName() const { return m_name; }
+
+		/**
+		 * @brief: 拿到锁之后调用。contended 表示第一次 try 失败、发生了等待
+		 */
+		void onAcquire(uint64_t wait_ns, bool contended)
+		{
+			m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+			if (contended)
+			{
+				onContended(wait_ns);
+			}
+		}
+
+		/**
+		 * @brief: 释放独占锁之前调用
+		 */
+		void onRelease(uint64_t hold_ns)
+		{
+			m_holdTotalNS.fetch_add(hold_ns, std::memory_order_relaxed);
+			UpdateMax(m_holdMaxNS, hold_ns);
+		}
+
+		uint64_t getAcquisitions() const { return m_acquisitions.load(std::memory_order_relaxed); }
+
+		uint64_t getContended() const { return m_contended.load(std::memory_order_relaxed); }
+
+		uint64_t getWaitTotalNS() const { return m_waitTotalNS.load(std::memory_order_relaxed); }
+
+		uint64_t getWaitMaxNS() const { return m_waitMaxNS.load(std::memory_order_relaxed); }
+
+		uint64_t getHoldTotalNS() const { return m_holdTotalNS.load(std::memory_order_relaxed); }
+
+		uint64_t getHoldMaxNS() const { return m_holdMaxNS.load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief: 按累计等待时间从大到小排好的等待者调用栈
+		 */
+		std::vector<WaiterStack> getWaiterStacks() const;
+
+		void reset();
+
+	private:
+		void onContended(uint64_t wait_ns);
+
+		static void UpdateMax(std::atomic<uint64_t>& max, uint64_t v)
+		{
+			uint64_t cur = max.load(std::memory_order_relaxed);
+			while (cur < v && !max.compare_exchange_weak(cur, v, std::memory_order_relaxed))
+			{
+			}
+		}
+
+	private:
+		std::string m_name;
+		std::atomic<uint64_t> m_acquisitions{0};
+		std::atomic<uint64_t> m_contended{0};
+		std::atomic<uint64_t> m_waitTotalNS{0};
+		std::atomic<uint64_t> m_waitMaxNS{0};
+		std::atomic<uint64_t> m_holdTotalNS{0};
+		std::atomic<uint64_t> m_holdMaxNS{0};
+		// 只在抽样时才加锁
+		mutable Mutex m_stackMutex;
+		std::vector<WaiterStack> m_stacks;
+	};
+#pragma endregion LockStats
+
+#pragma region LockProfiler
+	/**
+	 * @brief: 具名锁的注册表。同名的锁共用一份统计
+	 * 配置项:
+	 *   lock_profiler.stack_sample_rate  每多少次竞争抓一次等待者调用栈，0 表示不抓
+	 */
+	class LockProfiler
+	{
+	public:
+		static LockStats::ptr Register(const std::string& name);
+
+		/**
+		 * @brief: 按累计等待时间排序的前 n 把锁
+		 */
+		static std::vector<LockStats::ptr> GetTopContended(size_t n);
+
+		/**
+		 * @brief: 文本报告，每把锁一行统计，后面跟最多 stacks 个等待者调用栈
+		 */
+		static std::string Report(size_t n = 10, size_t stacks = 3);
+
+		static void Reset();
+
+		static uint32_t GetStackSampleRate()
+		{
+			return s_stackSampleRate.load(std::memory_order_relaxed);
+		}
+
+		static void SetStackSampleRate(uint32_t v);
+
+	private:
+		static std::atomic<uint32_t> s_stackSampleRate;
+	};
+#pragma endregion LockProfiler
+
+#pragma region ContentionLockPolicy
+	/**
+	 * @brief: 统计竞争的加锁策略，配合 NamedLock 使用
+	 * 先 try 一次，失败才计时并阻塞等待，所以无竞争时不读时钟等待时间
+	 */
+	struct ContentionLockPolicy
+	{
+		template<typename _ClassT>
+		static void lock(_ClassT* mutex)
+		{
+			if (mutex->tryLock())
+			{
+				mutex->onLocked(0, false);
+				return;
+			}
+			uint64_t begin = GetMonotonicNS();
+			mutex->lock();
+			mutex->onLocked(GetMonotonicNS() - begin, true);
+		}
+
+		template<typename _ClassT>
+		static void unlock(_ClassT* mutex)
+		{
+			mutex->onUnlocking();
+			mutex->unlock();
+		}
+
+		template<typename _ClassT>
+		static uint32_t rdlock(_ClassT* mutex)
+		{
+			uint32_t slot = 0;
+			if (ReadSlotOps::tryRdlock(mutex, &slot))
+			{
+				mutex->onShared(0, false);
+				return slot;
+			}
+			uint64_t begin = GetMonotonicNS();
+			slot = ReadSlotOps::rdlock(mutex);
+			mutex->onShared(GetMonotonicNS() - begin, true);
+			return slot;
+		}
+
+		template<typename _ClassT>
+		static void rdunlock(_ClassT* mutex, uint32_t slot)
+		{
+			ReadSlotOps::rdunlock(mutex, slot);
+		}
+
+		template<typename _ClassT>
+		static void wrlock(_ClassT* mutex)
+		{
+			if (mutex->tryWrlock())
+			{
+				mutex->onLocked(0, false);
+				return;
+			}
+			uint64_t begin = GetMonotonicNS();
+			mutex->wrlock();
+			mutex->onLocked(GetMonotonicNS() - begin, true);
+		}
+
+		template<typename _ClassT>
+		static void wrunlock(_ClassT* mutex)
+		{
+			mutex->onUnlocking();
+			mutex->wrunlock();
+		}
+	};
+#pragma endregion ContentionLockPolicy
+
+#pragma region NamedLock
+	/**
+	 * @brief: 具名锁。用法与原来的锁一致，只是构造时给个名字:
+	 *   NamedMutex m_mutex{"logger.appenders"};
+	 *   NamedMutex::Lock lock(&m_mutex);
+	 * 只有通过 Lock/ReadLock/WriteLock 加的锁才会被统计；读锁只统计等待，不统计持有时间
+	 */
+	template<typename _LockT>
+	class NamedLock : public _LockT
+	{
+	public:
+		typedef ScopedLockImpl<NamedLock, ContentionLockPolicy> Lock;
+		typedef ReadScopedLockImpl<NamedLock, ContentionLockPolicy> ReadLock;
+		typedef WriteScopedLockImpl<NamedLock, ContentionLockPolicy> WriteLock;
+
+		explicit NamedLock(const std::string& name)
+			: m_stats(LockProfiler::Register(name))
+		{
+		}
+
+		const LockStats::ptr& getStats() const { return m_stats; }
+
+		void onLocked(uint64_t wait_ns, bool contended)
+		{
+			m_stats->onAcquire(wait_ns, contended);
+			m_holdBegin = GetMonotonicNS();
+		}
+
+		void onShared(uint64_t wait_ns, bool contended)
+		{
+			m_stats->onAcquire(wait_ns, contended);
+		}
+
+		void onUnlocking()
+		{
+			m_stats->onRelease(GetMonotonicNS() - m_holdBegin);
+		}
+
+	private:
+		LockStats::ptr m_stats;
+		// 只在持有独占锁期间读写
+		uint64_t m_holdBegin = 0;
+	};
+
+	typedef NamedLock<Mutex> NamedMutex;
+	typedef NamedLock<RWMutex> NamedRWMutex;
+	typedef NamedLock<ShardedRWMutex> NamedShardedRWMutex;
+	typedef NamedLock<Spinlock> NamedSpinlock;
+	typedef NamedLock<CASLock> NamedCASLock;
+#pragma endregion NamedLock
+}
+
+#endif //RAREVOYAGER_LOCK_PROFILER_H
@@ -0,0 +1,571 @@
+/*************************************************
+ * 描述：无锁有界队列。多生产者多消费者(MPMC)与单生产者单消费者(SPSC)环形队列，
+ * 以及基于 futex 信号量的阻塞包装
+ *
+ * File：lockfree_queue.h
+ * Author：Cipher
+ * Date：2026/10/19-22:00
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_LOCKFREE_QUEUE_H
+#define RAREVOYAGER_LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <include/macro.h>
+#include <include/thread/thread.h>
+
+namespace RareVoyager
+{
+	/**
+	 * @brief: 向上取整到 2 的幂，至少为 2
+	 */
+	inline size_t QueueCapacityRoundUp(size_t n)
+	{
+		size_t cap = 2;
+		while (cap < n)
+		{
+			cap <<= 1;
+		}
+		return cap;
+	}
+
+#pragma region MPMCQueue
+	/**
+	 * @brief: Vyukov 有界 MPMC 队列
+	 * 每个槽有一个序号: 等于位置 pos 时可写，等于 pos + 1 时可读；生产者、消费者各自 CAS 一个位置计数，
+	 * 不同槽上的读写互不干扰，只在抢同一个位置时冲突
+	 * 队列满或空时 tryPush/tryPop 立即返回 false
+	 */
+	template<class T>
+	class MPMCQueue
+	{
+	public:
+		typedef T value_type;
+
+		explicit MPMCQueue(size_t capacity)
+			: m_capacity(QueueCapacityRoundUp(capacity))
+			  , m_mask(m_capacity - 1)
+			  , m_cells(new Cell[m_capacity])
+		{
+			for (size_t i = 0; i < m_capacity; ++i)
+			{
+				m_cells[i].seq.store(i, std::memory_order_relaxed);
+			}
+			m_enqueuePos.store(0, std::memory_order_relaxed);
+			m_dequeuePos.store(0, std::memory_order_relaxed);
+		}
+
+		~MPMCQueue()
+		{
+			size_t head = m_dequeuePos.load(std::memory_order_relaxed);
+			size_t tail = m_enqueuePos.load(std::memory_order_relaxed);
+			for (; head != tail; ++head)
+			{
+				m_cells[head & m_mask].ptr()->~T();
+			}
+			delete[] m_cells;
+		}
+
+		template<class U>
+		bool tryPush(U&& item)
+		{
+			size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true)
+			{
+				cell = &m_cells[pos & m_mask];
+				size_t seq = cell->seq.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (diff == 0)
+				{
+					if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (diff < 0)
+				{
+					// 这个槽上一轮的数据还没被取走，队列满
+					return false;
+				}
+				else
+				{
+					pos = m_enqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+			new(cell->ptr()) T(std::forward<U>(item));
+			cell->seq.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool tryPop(T& item)
+		{
+			size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true)
+			{
+				cell = &m_cells[pos & m_mask];
+				size_t seq = cell->seq.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+				if (diff == 0)
+				{
+					if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = m_dequeuePos.load(std::memory_order_relaxed);
+				}
+			}
+			release(cell, pos, item);
+			return true;
+		}
+
+		/**
+		 * @brief: 批量入队，一次 CAS 占下连续的多个槽
+		 * 槽的序号等于位置后，在被某个生产者占用之前不会再变，所以先检查再 CAS 是安全的
+		 * @return 实际入队的个数，从 items[0] 开始，队列满时可能少于 n
+		 */
+		size_t tryPushN(T* items, size_t n)
+		{
+			size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+			size_t k;
+			while (true)
+			{
+				k = 0;
+				while (k < n && m_cells[(pos + k) & m_mask].seq.load(std::memory_order_acquire) == pos + k)
+				{
+					++k;
+				}
+				if (!k)
+				{
+					size_t now = m_enqueuePos.load(std::memory_order_relaxed);
+					if (now == pos)
+					{
+						return 0;
+					}
+					pos = now;
+					continue;
+				}
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			for (size_t i = 0; i < k; ++i)
+			{
+				Cell* cell = &m_cells[(pos + i) & m_mask];
+				new(cell->ptr()) T(std::move(items[i]));
+				cell->seq.store(pos + i + 1, std::memory_order_release);
+			}
+			return k;
+		}
+
+		/**
+		 * @brief: 批量出队
+		 * @return 实际取出的个数，队列空时为 0
+		 */
+		size_t tryPopN(T* items, size_t n)
+		{
+			size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+			size_t k;
+			while (true)
+			{
+				k = 0;
+				while (k < n && m_cells[(pos + k) & m_mask].seq.load(std::memory_order_acquire) == pos + k + 1)
+				{
+					++k;
+				}
+				if (!k)
+				{
+					size_t now = m_dequeuePos.load(std::memory_order_relaxed);
+					if (now == pos)
+					{
+						return 0;
+					}
+					pos = now;
+					continue;
+				}
+				if (m_dequeuePos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			for (size_t i = 0; i < k; ++i)
+			{
+				release(&m_cells[(pos + i) & m_mask], pos + i, items[i]);
+			}
+			return k;
+		}
+
+		size_t capacity() const { return m_capacity; }
+
+		/**
+		 * @brief: 近似的元素个数
+		 */
+		size_t size() const
+		{
+			size_t tail = m_enqueuePos.load(std::memory_order_relaxed);
+			size_t head = m_dequeuePos.load(std::memory_order_relaxed);
+			return tail > head ? tail - head : 0;
+		}
+
+		bool empty() const { return size() == 0; }
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> seq;
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+			T* ptr() { return reinterpret_cast<T*>(&storage); }
+		};
+
+		MPMCQueue(const MPMCQueue&) = delete;
+
+		MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+		void release(Cell* cell, size_t pos, T& item)
+		{
+			T* p = cell->ptr();
+			item = std::move(*p);
+			p->~T();
+			// 下一轮同一个槽的位置是 pos + capacity
+			cell->seq.store(pos + m_capacity, std::memory_order_release);
+		}
+
+	private:
+		const size_t m_capacity;
+		const size_t m_mask;
+		Cell* const m_cells;
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<size_t> m_enqueuePos;
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<size_t> m_dequeuePos;
+		char m_pad[RAREVOYAGER_CACHELINE_SIZE - sizeof(std::atomic<size_t>)];
+	};
+#pragma endregion MPMCQueue
+
+#pragma region SPSCQueue
+	/**
+	 * @brief: 有界 SPSC 队列
+	 * 头、尾各占一个缓存行；生产者缓存一份头、消费者缓存一份尾，
+	 * 只有缓存的值显示满(空)时才去读对方的缓存行，稳态下两边几乎不互相失效
+	 * 只能有一个线程 push、一个线程 pop
+	 */
+	template<class T>
+	class SPSCQueue
+	{
+	public:
+		typedef T value_type;
+
+		explicit SPSCQueue(size_t capacity)
+			: m_capacity(QueueCapacityRoundUp(capacity))
+			  , m_mask(m_capacity - 1)
+			  , m_slots(static_cast<Slot*>(::operator new(sizeof(Slot) * m_capacity)))
+		{
+		}
+
+		~SPSCQueue()
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			for (; head != tail; ++head)
+			{
+				m_slots[head & m_mask].ptr()->~T();
+			}
+			::operator delete(m_slots);
+		}
+
+		template<class U>
+		bool tryPush(U&& item)
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_cachedHead == m_capacity)
+			{
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+				if (tail - m_cachedHead == m_capacity)
+				{
+					return false;
+				}
+			}
+			new(m_slots[tail & m_mask].ptr()) T(std::forward<U>(item));
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool tryPop(T& item)
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_cachedTail)
+			{
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+				if (head == m_cachedTail)
+				{
+					return false;
+				}
+			}
+			T* p = m_slots[head & m_mask].ptr();
+			item = std::move(*p);
+			p->~T();
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief: 批量入队，只发布一次尾
+		 */
+		size_t tryPushN(T* items, size_t n)
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			size_t free = m_capacity - (tail - m_cachedHead);
+			if (free < n)
+			{
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+				free = m_capacity - (tail - m_cachedHead);
+			}
+			size_t k = n < free ? n : free;
+			for (size_t i = 0; i < k; ++i)
+			{
+				new(m_slots[(tail + i) & m_mask].ptr()) T(std::move(items[i]));
+			}
+			if (k)
+			{
+				m_tail.store(tail + k, std::memory_order_release);
+			}
+			return k;
+		}
+
+		/**
+		 * @brief: 批量出队，只发布一次头
+		 */
+		size_t tryPopN(T* items, size_t n)
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			size_t avail = m_cachedTail - head;
+			if (avail < n)
+			{
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+				avail = m_cachedTail - head;
+			}
+			size_t k = n < avail ? n : avail;
+			for (size_t i = 0; i < k; ++i)
+			{
+				T* p = m_slots[(head + i) & m_mask].ptr();
+				items[i] = std::move(*p);
+				p->~T();
+			}
+			if (k)
+			{
+				m_head.store(head + k, std::memory_order_release);
+			}
+			return k;
+		}
+
+		size_t capacity() const { return m_capacity; }
+
+		size_t size() const
+		{
+			return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_relaxed);
+		}
+
+		bool empty() const { return size() == 0; }
+
+	private:
+		struct Slot
+		{
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+			T* ptr() { return reinterpret_cast<T*>(&storage); }
+		};
+
+		SPSCQueue(const SPSCQueue&) = delete;
+
+		SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+	private:
+		const size_t m_capacity;
+		const size_t m_mask;
+		Slot* const m_slots;
+		// 消费者写，生产者偶尔读
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<size_t> m_head{0};
+		// 消费者私有
+		size_t m_cachedTail = 0;
+		// 生产者写，消费者偶尔读
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<size_t> m_tail{0};
+		// 生产者私有
+		size_t m_cachedHead = 0;
+		char m_pad[RAREVOYAGER_CACHELINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+	};
+#pragma endregion SPSCQueue
+
+#pragma region BlockingQueue
+	/**
+	 * @brief: 给 MPMCQueue/SPSCQueue 加上阻塞语义
+	 * 两个信号量分别计数空槽和元素，队列不空不满时 push/pop 都不进内核
+	 * 拿到信号量后底层队列最多短暂失败(别的线程占了位置还没写完)，自旋重试即可
+	 */
+	template<class QueueT>
+	class BlockingQueue
+	{
+	public:
+		typedef typename QueueT::value_type value_type;
+
+		explicit BlockingQueue(size_t capacity)
+			: m_queue(capacity)
+			  , m_slots(static_cast<uint32_t>(m_queue.capacity()))
+			  , m_items(0)
+		{
+		}
+
+		template<class U>
+		void push(U&& item)
+		{
+			m_slots.wait();
+			while (!m_queue.tryPush(std::forward<U>(item)))
+			{
+				RAREVOYAGER_CPU_RELAX();
+			}
+			m_items.notify();
+		}
+
+		template<class U>
+		bool tryPush(U&& item)
+		{
+			if (!m_slots.tryWait())
+			{
+				return false;
+			}
+			while (!m_queue.tryPush(std::forward<U>(item)))
+			{
+				RAREVOYAGER_CPU_RELAX();
+			}
+			m_items.notify();
+			return true;
+		}
+
+		value_type pop()
+		{
+			m_items.wait();
+			value_type item;
+			take(item);
+			return item;
+		}
+
+		bool tryPop(value_type& item)
+		{
+			if (!m_items.tryWait())
+			{
+				return false;
+			}
+			take(item);
+			return true;
+		}
+
+		/**
+		 * @brief: 最多等待 timeout，超时返回 false
+		 */
+		template<class Rep, class Period>
+		bool popFor(value_type& item, const std::chrono::duration<Rep, Period>& timeout)
+		{
+			if (!m_items.waitFor(timeout))
+			{
+				return false;
+			}
+			take(item);
+			return true;
+		}
+
+		/**
+		 * @brief: 批量入队，阻塞到全部放入；每批只唤醒一次
+		 */
+		void pushN(value_type* items, size_t n)
+		{
+			while (n)
+			{
+				m_slots.wait();
+				// 已经拿到一个空槽，再尽量多拿一些
+				size_t k = 1;
+				while (k < n && m_slots.tryWait())
+				{
+					++k;
+				}
+				size_t done = 0;
+				while (done < k)
+				{
+					size_t m = m_queue.tryPushN(items + done, k - done);
+					if (!m)
+					{
+						RAREVOYAGER_CPU_RELAX();
+					}
+					done += m;
+				}
+				m_items.notify(static_cast<uint32_t>(k));
+				items += k;
+				n -= k;
+			}
+		}
+
+		/**
+		 * @brief: 阻塞到至少有一个元素，最多取 n 个
+		 */
+		size_t popN(value_type* items, size_t n)
+		{
+			if (!n)
+			{
+				return 0;
+			}
+			m_items.wait();
+			size_t k = 1;
+			while (k < n && m_items.tryWait())
+			{
+				++k;
+			}
+			size_t done = 0;
+			while (done < k)
+			{
+				size_t m = m_queue.tryPopN(items + done, k - done);
+				if (!m)
+				{
+					RAREVOYAGER_CPU_RELAX();
+				}
+				done += m;
+			}
+			m_slots.notify(static_cast<uint32_t>(k));
+			return k;
+		}
+
+		size_t size() const { return m_queue.size(); }
+
+		size_t capacity() const { return m_queue.capacity(); }
+
+	private:
+		void take(value_type& item)
+		{
+			while (!m_queue.tryPop(item))
+			{
+				RAREVOYAGER_CPU_RELAX();
+			}
+			m_slots.notify();
+		}
+
+	private:
+		QueueT m_queue;
+		Semaphore m_slots;
+		Semaphore m_items;
+	};
+#pragma endregion BlockingQueue
+}
+
+#endif //RAREVOYAGER_LOCKFREE_QUEUE_H
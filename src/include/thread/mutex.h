@@ -4,23 +4,107 @@
  * File：mutex.h
  * Author：Cipher
  * Date：2026/1/8-18:57
- * Update：
+ * Update：2026/10/19 ScopedLockImpl 增加加锁策略模板参数，各锁增加 tryLock；CASLock 改为自适应自旋+futex；增加 TicketLock、MCSLock
+ * Update：2026/10/21 读锁记住 ShardedRWMutex 的槽位，解锁不依赖当前线程
  * ************************************************/
 
 #ifndef RAREVOYAGER_MUTEX_H
 #define RAREVOYAGER_MUTEX_H
 #include <atomic>
+#include <cstdint>
 #include <pthread.h>
+#include <type_traits>
+
+#include <include/macro.h>
 
 namespace RareVoyager
 {
-	template<typename _ClassT>
+	class ShardedRWMutex;
+
+#pragma region ReadSlotOps
+	/**
+	 * @brief: 读锁的槽位。ShardedRWMutex 的读者计数记在加锁线程的槽位上，协程持有读锁时可能被换到别的
+	 * 工作线程，解锁必须落在加锁时的槽位；其它读写锁没有槽位，取 0，解锁时忽略
+	 */
+	struct ReadSlotOps
+	{
+		template<typename _ClassT>
+		static uint32_t rdlock(_ClassT* mutex)
+		{
+			if constexpr (std::is_base_of<ShardedRWMutex, _ClassT>::value)
+			{
+				return mutex->rdlock();
+			}
+			else
+			{
+				mutex->rdlock();
+				return 0;
+			}
+		}
+
+		template<typename _ClassT>
+		static bool tryRdlock(_ClassT* mutex, uint32_t* slot)
+		{
+			if constexpr (std::is_base_of<ShardedRWMutex, _ClassT>::value)
+			{
+				return mutex->tryRdlock(slot);
+			}
+			else
+			{
+				*slot = 0;
+				return mutex->tryRdlock();
+			}
+		}
+
+		template<typename _ClassT>
+		static void rdunlock(_ClassT* mutex, uint32_t slot)
+		{
+			if constexpr (std::is_base_of<ShardedRWMutex, _ClassT>::value)
+			{
+				mutex->rdunlock(slot);
+			}
+			else
+			{
+				mutex->rdunlock();
+			}
+		}
+	};
+#pragma endregion ReadSlotOps
+
+#pragma region LockPolicy
+	/**
+	 * @brief: 默认的加锁策略，直接转发给锁本身。全部内联，没有任何额外开销
+	 * 需要统计锁竞争时换成 ContentionLockPolicy (见 lock_profiler.h)
+	 */
+	struct NullLockPolicy
+	{
+		template<typename _ClassT>
+		static void lock(_ClassT* mutex) { mutex->lock(); }
+
+		template<typename _ClassT>
+		static void unlock(_ClassT* mutex) { mutex->unlock(); }
+
+		template<typename _ClassT>
+		static uint32_t rdlock(_ClassT* mutex) { return ReadSlotOps::rdlock(mutex); }
+
+		template<typename _ClassT>
+		static void rdunlock(_ClassT* mutex, uint32_t slot) { ReadSlotOps::rdunlock(mutex, slot); }
+
+		template<typename _ClassT>
+		static void wrlock(_ClassT* mutex) { mutex->wrlock(); }
+
+		template<typename _ClassT>
+		static void wrunlock(_ClassT* mutex) { mutex->wrunlock(); }
+	};
+#pragma endregion LockPolicy
+
+	template<typename _ClassT, typename _Policy = NullLockPolicy>
 	struct ScopedLockImpl
 	{
 	public:
 		ScopedLockImpl(_ClassT* mutex) : m_mutex(mutex)
 		{
-			m_mutex->lock();
+			_Policy::lock(m_mutex);
 			m_locked = true;
 		}
 
@@ -33,7 +117,7 @@ namespace RareVoyager
 		{
 			if (!m_locked)
 			{
-				m_mutex->lock();
+				_Policy::lock(m_mutex);
 				m_locked = true;
 			}
 		}
@@ -42,7 +126,7 @@ namespace RareVoyager
 		{
 			if (m_locked)
 			{
-				m_mutex->unlock();
+				_Policy::unlock(m_mutex);
 				m_locked = false;
 			}
 		}
@@ -52,13 +136,13 @@ namespace RareVoyager
 		bool m_locked;
 	};
 
-	template<typename _ClassT>
+	template<typename _ClassT, typename _Policy = NullLockPolicy>
 	struct ReadScopedLockImpl
 	{
 	public:
 		ReadScopedLockImpl(_ClassT* mutex) : m_rdmutex(mutex)
 		{
-			m_rdmutex->rdlock();
+			m_slot = _Policy::rdlock(m_rdmutex);
 			m_locked = true;
 		}
 
@@ -71,7 +155,7 @@ namespace RareVoyager
 		{
 			if (!m_locked)
 			{
-				m_rdmutex->unlock();
+				m_slot = _Policy::rdlock(m_rdmutex);
 				m_locked = true;
 			}
 		}
@@ -80,23 +164,25 @@ namespace RareVoyager
 		{
 			if (m_locked)
 			{
-				m_rdmutex->unlock();
+				_Policy::rdunlock(m_rdmutex, m_slot);
 				m_locked = false;
 			}
 		}
 
 	private:
 		_ClassT* m_rdmutex;
+		// 加锁时的读者槽位，见 ReadSlotOps
+		uint32_t m_slot = 0;
 		bool m_locked;
 	};
 
-	template<typename _ClassT>
+	template<typename _ClassT, typename _Policy = NullLockPolicy>
 	struct WriteScopedLockImpl
 	{
 	public:
 		WriteScopedLockImpl(_ClassT* mutex) : m_wrmutex(mutex)
 		{
-			m_wrmutex->wrlock();
+			_Policy::wrlock(m_wrmutex);
 			m_locked = true;
 		}
 
@@ -109,7 +195,7 @@ namespace RareVoyager
 		{
 			if (!m_locked)
 			{
-				m_wrmutex->lock();
+				_Policy::wrlock(m_wrmutex);
 				m_locked = true;
 			}
 		}
@@ -118,7 +204,7 @@ namespace RareVoyager
 		{
 			if (m_locked)
 			{
-				m_wrmutex->unlock();
+				_Policy::wrunlock(m_wrmutex);
 				m_locked = false;
 			}
 		}
@@ -139,6 +225,11 @@ namespace RareVoyager
 
 		void lock();
 
+		/**
+		 * @brief: 不阻塞地尝试加锁，成功返回 true
+		 */
+		bool tryLock();
+
 		void unlock();
 
 	private:
@@ -161,12 +252,88 @@ namespace RareVoyager
 
 		void wrlock();
 
+		bool tryRdlock();
+
+		bool tryWrlock();
+
 		void unlock();
 
+		void rdunlock() { unlock(); }
+
+		void wrunlock() { unlock(); }
+
 	private:
 		pthread_rwlock_t m_rwlock;
 	};
 
+#pragma region ShardedRWMutex
+	/**
+	 * @brief: 分片读写锁(big-reader lock)。每个线程固定落在一个读者槽位上，槽位各占一条缓存行，
+	 * 读锁只修改自己槽位的计数，多核同时读不会争抢同一条缓存行
+	 * 写锁先置写标志再等所有槽位清零，代价与槽位数成正比，只适合极少写的场景
+	 * 接口与 RWMutex 相同，可以直接替换；不支持同一线程重复加读锁(中间有写者时会死锁)
+	 * ReadLock 记住加锁时的槽位，协程持有读锁时被换到别的工作线程也能解在原槽位上
+	 */
+	class ShardedRWMutex
+	{
+	public:
+		typedef ReadScopedLockImpl<ShardedRWMutex> ReadLock;
+		typedef WriteScopedLockImpl<ShardedRWMutex> WriteLock;
+
+		ShardedRWMutex();
+
+		~ShardedRWMutex();
+
+		/**
+		 * @return 读者计数所在的槽位，解锁时传给 rdunlock。协程持锁期间可能换线程，不能按当前线程重新取
+		 */
+		uint32_t rdlock();
+
+		void wrlock();
+
+		/**
+		 * @param slot 成功时写入槽位，可以为空
+		 */
+		bool tryRdlock(uint32_t* slot = nullptr);
+
+		bool tryWrlock();
+
+		void rdunlock(uint32_t slot);
+
+		/**
+		 * @brief: 按当前线程的槽位解锁，只能在加锁的线程上调用
+		 */
+		void rdunlock();
+
+		void wrunlock();
+
+	private:
+		enum WriterState : uint32_t
+		{
+			NO_WRITER = 0,
+			WRITER = 1,
+			// 有读者睡在 m_writer 上，写者解锁时需要唤醒
+			WRITER_WITH_WAITERS = 2
+		};
+
+		struct alignas(RAREVOYAGER_CACHELINE_SIZE) Slot
+		{
+			std::atomic<uint32_t> readers{0};
+		};
+
+		uint32_t getSlot();
+
+		void waitReaders();
+
+	private:
+		Slot* m_slots;
+		uint32_t m_slotMask;
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<uint32_t> m_writer;
+		// 写者之间互斥
+		Mutex m_writeMutex;
+	};
+#pragma endregion ShardedRWMutex
+
 #pragma region Spinlock
 	class Spinlock
 	{
@@ -179,6 +346,8 @@ namespace RareVoyager
 
 		void lock();
 
+		bool tryLock();
+
 		void unlock();
 
 	private:
@@ -187,19 +356,174 @@ namespace RareVoyager
 #pragma endregion Spinlock
 
 #pragma region CASLock
+	/**
+	 * @brief: 自适应锁。先 test-and-test-and-set 自旋(带 pause 和指数退避)，
+	 * 自旋预算用完后在 futex 上睡眠，避免超额订阅时把整个时间片浪费在自旋上
+	 * 自旋预算按最近的加锁情况动态调整(与 glibc 的 PTHREAD_MUTEX_ADAPTIVE_NP 类似)
+	 */
 	class CASLock
 	{
 	public:
 		typedef ScopedLockImpl<CASLock> Lock;
 		CASLock();
 		~CASLock();
+		void lock()
+		{
+			uint32_t expected = UNLOCKED;
+			if (RAREVOYAGER_LIKELY(m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+			                                                       std::memory_order_relaxed)))
+			{
+				return;
+			}
+			lockSlow();
+		}
+
+		bool tryLock()
+		{
+			uint32_t expected = UNLOCKED;
+			return m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+			                                       std::memory_order_relaxed);
+		}
+
+		void unlock()
+		{
+			if (RAREVOYAGER_UNLIKELY(m_state.exchange(UNLOCKED, std::memory_order_release) == PARKED))
+			{
+				wake();
+			}
+		}
+
+	private:
+		enum State : uint32_t
+		{
+			UNLOCKED = 0,
+			LOCKED = 1,
+			// 已加锁且可能有线程睡在 futex 上，解锁时需要唤醒
+			PARKED = 2
+		};
+
+		void lockSlow();
+
+		void wake();
+
+	private:
+		std::atomic<uint32_t> m_state;
+		// 自旋次数的滑动估计，只是启发值，不需要精确
+		std::atomic<uint32_t> m_spins;
+	};
+#pragma endregion CASLock
+
+#pragma region TicketLock
+	/**
+	 * @brief: 排队锁。按取号顺序加锁，严格先来先服务
+	 * 等待时按前面排队的人数做比例退避；超过自旋预算后让出 CPU，
+	 * 因为持锁者或排在前面的线程被调度走时，后面的人怎么自旋都没用
+	 */
+	class TicketLock
+	{
+	public:
+		typedef ScopedLockImpl<TicketLock> Lock;
+
+		TicketLock();
+
 		void lock();
 
+		bool tryLock();
+
+		void unlock()
+		{
+			// 只有持锁者会修改 m_serving
+			m_serving.store(m_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+	private:
+		// 取号与叫号放在不同的缓存行，取号不会打扰正在等叫号的线程
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<uint32_t> m_next;
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<uint32_t> m_serving;
+	};
+#pragma endregion TicketLock
+
+#pragma region MCSLock
+	/**
+	 * @brief: MCS 队列锁。每个等待者在自己的节点上自旋，解锁时只通知下一个节点，
+	 * 缓存行不会在所有等待者之间来回传递；同样是先来先服务
+	 * 自旋预算用完后在自己节点的 futex 上睡眠，由前一个持锁者精确唤醒
+	 *
+	 * 两种用法:
+	 * 1. 显式节点，节点通常放在栈上:
+	 *      MCSLock::NodeLock lock(&mcs);
+	 * 2. 和其它锁一样的 lock()/unlock() (MCSLock::Lock)，节点从线程私有的节点池里取，
+	 *    要求由加锁的线程解锁
+	 */
+	class MCSLock
+	{
+	public:
+		struct alignas(RAREVOYAGER_CACHELINE_SIZE) Node
+		{
+			std::atomic<Node*> next{nullptr};
+			// 见 MCSLock::NodeState
+			std::atomic<uint32_t> state{0};
+		};
+
+		/**
+		 * @brief: 使用栈上节点的 RAII 锁
+		 */
+		class NodeLock
+		{
+		public:
+			explicit NodeLock(MCSLock* mutex) : m_mutex(mutex)
+			{
+				m_mutex->lock(&m_node);
+			}
+
+			~NodeLock()
+			{
+				m_mutex->unlock(&m_node);
+			}
+
+		private:
+			NodeLock(const NodeLock&) = delete;
+
+			NodeLock& operator=(const NodeLock&) = delete;
+
+		private:
+			MCSLock* m_mutex;
+			Node m_node;
+		};
+
+		typedef ScopedLockImpl<MCSLock> Lock;
+
+		MCSLock();
+
+		void lock(Node* node);
+
+		bool tryLock(Node* node);
+
+		void unlock(Node* node);
+
+		void lock();
+
+		bool tryLock();
+
 		void unlock();
+
 	private:
-		volatile std::atomic_flag m_locked;
+		enum NodeState : uint32_t
+		{
+			WAITING = 0,
+			GRANTED = 1,
+			// 等待者已经睡在 futex 上，交接时需要唤醒
+			PARKED = 2
+		};
+
+		static void Grant(Node* node);
+
+	private:
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<Node*> m_tail;
+		// lock()/unlock() 用的节点，只在持锁期间读写
+		Node* m_owner;
 	};
-#pragma endregion CASLock
+#pragma endregion MCSLock
 }
 
 #endif //RAREVOYAGER_MUTEX_H
\ No newline at end of file
@@ -0,0 +1,244 @@
+/*************************************************
+ * 描述：基于 epoch 的内存回收(EBR)与 RCU 风格的指针发布
+ * 读者进出临界区只写自己线程的记录，写者替换指针后延迟释放旧对象，
+ * 等所有可能看到旧对象的读者离开临界区后再真正释放
+ *
+ * File：rcu.h
+ * Author：Cipher
+ * Date：2026/10/19-22:40
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_RCU_H
+#define RAREVOYAGER_RCU_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include <include/macro.h>
+#include <include/thread/mutex.h>
+
+namespace RareVoyager
+{
+#pragma region Rcu
+	/**
+	 * @brief: 全局 epoch 与读者登记
+	 * 1. 读者进入临界区时把当前全局 epoch 记到自己线程的记录里，离开时清零，嵌套只记最外层
+	 * 2. 写者把对象从共享结构里摘下后调用 DeferFree，对象带上摘下时的 epoch 进入待释放表；
+	 *    所有正在临界区里的读者 epoch 都比它新时才释放
+	 * 3. 系统支持 membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) 时，内存屏障由写者替所有读者线程执行，
+	 *    读者路径上只有一次线程局部的写；不支持时读者进入临界区多一个 seq_cst 屏障
+	 * RareVoyager::Thread 启动时自动登记，其它线程第一次进入临界区时登记，线程退出时注销
+	 * 读临界区里不能调用 Synchronize/Barrier(会等自己)，也不要阻塞太久(会推迟释放)
+	 */
+	class Rcu
+	{
+	public:
+		struct alignas(RAREVOYAGER_CACHELINE_SIZE) Record
+		{
+			// 0 表示不在临界区
+			std::atomic<uint64_t> epoch{0};
+			uint32_t nest = 0;
+		};
+
+		/**
+		 * @brief: 进入读临界区，可以嵌套
+		 */
+		static void ReadLock()
+		{
+			Record* r = t_record;
+			if (RAREVOYAGER_UNLIKELY(!r))
+			{
+				r = RegisterThread();
+			}
+			if (r->nest++ == 0)
+			{
+				r->epoch.store(s_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				if (RAREVOYAGER_LIKELY(s_membarrier.load(std::memory_order_relaxed)))
+				{
+					std::atomic_signal_fence(std::memory_order_seq_cst);
+				}
+				else
+				{
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+				}
+			}
+		}
+
+		static void ReadUnlock()
+		{
+			Record* r = t_record;
+			if (--r->nest == 0)
+			{
+				r->epoch.store(0, std::memory_order_release);
+			}
+		}
+
+		/**
+		 * @brief: 当前线程是否在读临界区里
+		 */
+		static bool InReadSection()
+		{
+			return t_record && t_record->nest;
+		}
+
+		/**
+		 * @brief: 登记当前线程，重复调用返回同一条记录
+		 */
+		static Record* RegisterThread();
+
+		/**
+		 * @brief: 注销当前线程。线程退出时会自动调用
+		 */
+		static void UnregisterThread();
+
+		/**
+		 * @brief: 阻塞到调用之前进入临界区的读者都离开，然后释放已经安全的对象
+		 */
+		static void Synchronize();
+
+		/**
+		 * @brief: 延迟释放，不阻塞。待释放的对象多了会顺带回收一次已经安全的部分
+		 */
+		static void DeferFree(std::function<void()> deleter);
+
+		template<class T>
+		static void DeferDelete(T* p)
+		{
+			if (p)
+			{
+				DeferFree([p]() { delete p; });
+			}
+		}
+
+		/**
+		 * @brief: 等待并释放所有待释放的对象
+		 */
+		static void Barrier();
+
+		/**
+		 * @brief: 回收已经安全的对象，不等待读者
+		 * @return 释放的个数
+		 */
+		static size_t Reclaim();
+
+		static uint64_t GetEpoch() { return s_epoch.load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief: 还没释放的对象个数
+		 */
+		static size_t GetPendingCount();
+
+		/**
+		 * @brief: 是否使用 membarrier 加速读者
+		 */
+		static bool UseMembarrier();
+
+	private:
+		/**
+		 * @brief: 让所有读者线程的 epoch 写入对当前线程可见
+		 */
+		static void Fence();
+
+		/**
+		 * @brief: 正在临界区里的读者中最老的 epoch，没有读者时返回 UINT64_MAX
+		 */
+		static uint64_t MinActiveEpoch();
+
+	private:
+		static inline thread_local Record* t_record = nullptr;
+		// 从 1 开始，0 留给"不在临界区"
+		alignas(RAREVOYAGER_CACHELINE_SIZE) static inline std::atomic<uint64_t> s_epoch{1};
+		static inline std::atomic<bool> s_membarrier{false};
+	};
+
+	/**
+	 * @brief: 读临界区的 RAII 守卫
+	 */
+	class RcuReadLock
+	{
+	public:
+		RcuReadLock()
+		{
+			Rcu::ReadLock();
+		}
+
+		~RcuReadLock()
+		{
+			Rcu::ReadUnlock();
+		}
+
+	private:
+		RcuReadLock(const RcuReadLock&) = delete;
+
+		RcuReadLock& operator=(const RcuReadLock&) = delete;
+	};
+#pragma endregion Rcu
+
+#pragma region RcuPtr
+	/**
+	 * @brief: RCU 发布的指针
+	 * 读者在 RcuReadLock 范围内 load，得到的对象在离开临界区之前一直有效，对象本身不能修改
+	 * 写者之间用 Mutex 互斥，复制一份修改后发布，旧对象延迟释放
+	 */
+	template<class T>
+	class RcuPtr
+	{
+	public:
+		typedef Mutex MutexType;
+
+		explicit RcuPtr(T* p = nullptr) : m_ptr(p)
+		{
+		}
+
+		~RcuPtr()
+		{
+			// 析构时不应该再有读者
+			delete m_ptr.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief: 只能在读临界区里调用
+		 */
+		const T* load() const
+		{
+			return m_ptr.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * @brief: 发布新对象，旧对象延迟释放
+		 */
+		void store(T* p)
+		{
+			MutexType::Lock lock(&m_mutex);
+			Rcu::DeferDelete(m_ptr.exchange(p, std::memory_order_acq_rel));
+		}
+
+		/**
+		 * @brief: 复制当前对象，调用 cb 修改后发布；当前为空时从 T() 开始
+		 */
+		template<class F>
+		void update(F cb)
+		{
+			MutexType::Lock lock(&m_mutex);
+			T* old = m_ptr.load(std::memory_order_relaxed);
+			T* p = old ? new T(*old) : new T();
+			cb(*p);
+			m_ptr.store(p, std::memory_order_release);
+			Rcu::DeferDelete(old);
+		}
+
+	private:
+		RcuPtr(const RcuPtr&) = delete;
+
+		RcuPtr& operator=(const RcuPtr&) = delete;
+
+	private:
+		std::atomic<T*> m_ptr;
+		MutexType m_mutex;
+	};
+#pragma endregion RcuPtr
+}
+
+#endif //RAREVOYAGER_RCU_H
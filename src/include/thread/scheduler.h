@@ -0,0 +1,238 @@
+/*************************************************
+ * 描述：N:M 协程调度器。N 个协程跑在 M 个工作线程上，
+ * 每个工作线程有自己的运行队列，空闲时从其它线程窃取
+ *
+ * File：scheduler.h
+ * Author：Cipher
+ * Date：2026/10/20-16:00
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_SCHEDULER_H
+#define RAREVOYAGER_SCHEDULER_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <include/macro.h>
+#include <include/thread/fiber.h>
+#include <include/thread/lockfree_queue.h>
+#include <include/thread/mutex.h>
+#include <include/thread/task_scheduler.h>
+#include <include/thread/thread_group.h>
+
+namespace RareVoyager
+{
+#pragma region Scheduler
+	/**
+	 * @brief: 协程调度器
+	 * 1. 每个工作线程三个队列:
+	 *    local  Chase-Lev 双端队列，本线程调度的任务放这里，本线程和窃取者都从顶部取(先进先出，yield 的协程不会插队)
+	 *    inbox  有界无锁 MPMC 队列，其它线程投递的任务放这里，满了才退到加锁的 overflow
+	 *    pinned 只有本线程访问，指定线程执行的任务从 inbox 转到这里，不会被窃取
+	 *    调度一个就绪的协程只有一次无锁入队，没有全局锁
+	 * 2. 没有任务时依次检查 inbox、pinned、local，再随机窃取，都没有就进入 idle
+	 *    默认的 idle 在 futex 上睡眠，tickle 唤醒；IOManager 改为等待 IO 事件
+	 * 3. 回调在工作线程复用的协程里执行，回调里也可以 yield
+	 * 4. use_caller 时调用者线程是 0 号工作线程，stop 时在调用者线程上跑调度循环，直到任务全部完成
+	 */
+	class Scheduler
+	{
+	public:
+		typedef std::shared_ptr<Scheduler> ptr;
+		typedef Mutex MutexType;
+
+		/**
+		 * @brief: 工作线程的统计
+		 */
+		struct WorkerStats
+		{
+			// 当前排队的任务数
+			size_t queued = 0;
+			// 执行过的任务数
+			uint64_t executed = 0;
+			// 从其它线程窃取的任务数
+			uint64_t steals = 0;
+			// 进入 idle 的次数与总时长
+			uint64_t idleCount = 0;
+			uint64_t idleNS = 0;
+		};
+
+		/**
+		 * @param threads 工作线程数，包括调用者线程
+		 * @param use_caller 调用者线程是否作为 0 号工作线程
+		 */
+		explicit Scheduler(size_t threads = 1, bool use_caller = true, const std::string& name = "scheduler");
+
+		virtual ~Scheduler();
+
+		/**
+		 * @brief: 启动工作线程
+		 */
+		void start();
+
+		/**
+		 * @brief: 等所有任务完成后停止。use_caller 时必须在调用者线程上、协程之外调用
+		 */
+		void stop();
+
+		/**
+		 * @param thread 指定执行的工作线程下标，-1 表示任意
+		 */
+		void schedule(Fiber::ptr fiber, int thread = -1);
+
+		void schedule(std::function<void()> cb, int thread = -1);
+
+		const std::string& getName() const { return m_name; }
+
+		size_t getWorkerCount() const { return m_workers.size(); }
+
+		/**
+		 * @brief: 排队加正在执行的任务数
+		 */
+		uint64_t getTaskCount() const { return m_taskCount.load(std::memory_order_relaxed); }
+
+		std::vector<WorkerStats> getStats() const;
+
+		std::string statsToString() const;
+
+		/**
+		 * @brief: 当前线程所属的调度器，不是工作线程返回 nullptr
+		 */
+		static Scheduler* GetThis();
+
+		/**
+		 * @brief: 当前线程的工作线程下标，不是工作线程返回 -1
+		 */
+		static int GetWorkerIndex();
+
+	protected:
+		/**
+		 * @brief: 唤醒在 idle 里等待的工作线程
+		 */
+		virtual void tickle(uint32_t worker);
+
+		/**
+		 * @brief: 工作线程没有任务时调用，阻塞到被 tickle 或有事可做，返回后调度循环会重新找任务
+		 */
+		virtual void idle(uint32_t worker);
+
+		/**
+		 * @brief: 可以退出调度循环了
+		 */
+		virtual bool stopping();
+
+		/**
+		 * @brief: 工作线程每执行完一个任务调用一次。一直有任务可跑的线程不会进 idle，
+		 * 需要定期做的事(比如 IOManager 提交攒下的 SQE、收割完成事件)放在这里
+		 */
+		virtual void onTaskExecuted(uint32_t worker)
+		{
+		}
+
+		/**
+		 * @brief: 工作线程是否在 idle 里(或正准备进入)
+		 */
+		bool isSleeping(uint32_t worker) const;
+
+		/**
+		 * @brief: 本次进入 idle 之后是否被 tickle 过。idle 的实现在阻塞前检查，避免丢失唤醒
+		 */
+		bool isTickled(uint32_t worker) const;
+
+		void tickleAll();
+
+		/**
+		 * @brief: 是否已经调用了 stop
+		 */
+		bool isStopping() const { return m_stopping.load(std::memory_order_acquire); }
+
+	private:
+		struct Task
+		{
+			Fiber::ptr fiber;
+			std::function<void()> cb;
+			int thread = -1;
+		};
+
+		struct alignas(RAREVOYAGER_CACHELINE_SIZE) Worker
+		{
+			Worker() : inbox(4096)
+			{
+			}
+
+			WorkStealingDeque<Task> local;
+			MPMCQueue<Task*> inbox;
+			MutexType overflowMutex;
+			std::deque<Task*> overflow;
+			std::atomic<size_t> overflowSize{0};
+			// 只有本线程访问，pinnedSize 给统计用
+			std::deque<Task*> pinned;
+			std::atomic<size_t> pinnedSize{0};
+			uint32_t turn = 0;
+			// 执行回调用的协程，回调结束后复用
+			Fiber::ptr cbFiber;
+
+			// 睡眠与唤醒: 睡前记下 wakeup，tickle 时加一
+			alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<uint32_t> sleeping{0};
+			std::atomic<uint32_t> wakeup{0};
+			uint32_t wakeupSeen = 0;
+
+			std::atomic<uint64_t> executed{0};
+			std::atomic<uint64_t> steals{0};
+			std::atomic<uint64_t> idleCount{0};
+			std::atomic<uint64_t> idleNS{0};
+		};
+
+		Scheduler(const Scheduler&) = delete;
+
+		Scheduler& operator=(const Scheduler&) = delete;
+
+		void push(Task* task);
+
+		/**
+		 * @brief: 工作线程的调度循环
+		 */
+		void run(uint32_t index);
+
+		Task* findTask(Worker* self);
+
+		Task* stealTask(Worker* self);
+
+		/**
+		 * @brief: 把 inbox 与 overflow 里的任务转到 local 或 pinned
+		 */
+		void drainInbox(Worker* self);
+
+		/**
+		 * @brief: 准备睡眠前再检查一遍，和入队方的"先入队再检查 sleeping"配对
+		 */
+		bool hasWork(Worker* self) const;
+
+		void runTask(Worker* self, Task* task);
+
+		/**
+		 * @brief: 叫醒一个睡着的工作线程来窃取
+		 */
+		void wakeIdle(uint32_t except);
+
+	private:
+		std::string m_name;
+		bool m_useCaller;
+		std::vector<std::unique_ptr<Worker> > m_workers;
+		ThreadGroup m_threads;
+		std::atomic<uint64_t> m_taskCount{0};
+		std::atomic<uint32_t> m_sleepers{0};
+		// 外部线程投递不指定线程的任务时轮流选择目标
+		std::atomic<uint32_t> m_nextTarget{0};
+		std::atomic<bool> m_stopping{false};
+		bool m_started = false;
+	};
+#pragma endregion Scheduler
+}
+
+#endif //RAREVOYAGER_SCHEDULER_H
@@ -0,0 +1,119 @@
+/*************************************************
+ * 描述：顺序锁。适合读多写少的小数据，读者不写任何共享内存
+ *
+ * File：seqlock.h
+ * Author：Cipher
+ * Date：2026/10/19-18:10
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_SEQLOCK_H
+#define RAREVOYAGER_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <include/macro.h>
+#include <include/thread/mutex.h>
+
+namespace RareVoyager
+{
+#pragma region SeqLock
+	/**
+	 * @brief: 顺序锁
+	 * 写者: 序号加一(变奇数) -> 写数据 -> 序号再加一(变偶数)，写者之间用 Mutex 互斥
+	 * 读者: 读序号 -> 读数据 -> 再读序号，序号是奇数或前后不一致就重读
+	 * 数据按 8 字节拆成原子变量保存，读写都是 relaxed 原子操作，没有数据竞争
+	 * @tparam T 必须是平凡可复制的类型
+	 */
+	template<class T>
+	class SeqLock
+	{
+	public:
+		static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+		typedef Mutex MutexType;
+
+		SeqLock(const T& value = T())
+			: m_seq(0)
+		{
+			storeWords(value);
+		}
+
+		T load() const
+		{
+			uint64_t words[s_words];
+			while (true)
+			{
+				uint32_t seq = m_seq.load(std::memory_order_acquire);
+				if (RAREVOYAGER_UNLIKELY(seq & 1))
+				{
+					RAREVOYAGER_CPU_RELAX();
+					continue;
+				}
+				for (size_t i = 0; i < s_words; ++i)
+				{
+					words[i] = m_data[i].load(std::memory_order_relaxed);
+				}
+				// 保证上面的数据读取不会被重排到第二次读序号之后
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (RAREVOYAGER_LIKELY(m_seq.load(std::memory_order_relaxed) == seq))
+				{
+					break;
+				}
+			}
+			T value;
+			memcpy(&value, words, sizeof(T));
+			return value;
+		}
+
+		void store(const T& value)
+		{
+			MutexType::Lock lock(&m_mutex);
+			uint32_t seq = m_seq.load(std::memory_order_relaxed);
+			m_seq.store(seq + 1, std::memory_order_relaxed);
+			// 保证序号先于数据可见
+			std::atomic_thread_fence(std::memory_order_release);
+			storeWords(value);
+			m_seq.store(seq + 2, std::memory_order_release);
+		}
+
+		/**
+		 * @brief: 写入并返回旧值，写者之间是原子的
+		 */
+		T exchange(const T& value)
+		{
+			MutexType::Lock lock(&m_mutex);
+			T old = load();
+			uint32_t seq = m_seq.load(std::memory_order_relaxed);
+			m_seq.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			storeWords(value);
+			m_seq.store(seq + 2, std::memory_order_release);
+			return old;
+		}
+
+	private:
+		void storeWords(const T& value)
+		{
+			uint64_t words[s_words] = {0};
+			memcpy(words, &value, sizeof(T));
+			for (size_t i = 0; i < s_words; ++i)
+			{
+				m_data[i].store(words[i], std::memory_order_relaxed);
+			}
+		}
+
+	private:
+		static const size_t s_words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+		std::atomic<uint32_t> m_seq;
+		std::atomic<uint64_t> m_data[s_words];
+		MutexType m_mutex;
+	};
+#pragma endregion SeqLock
+}
+
+#endif //RAREVOYAGER_SEQLOCK_H
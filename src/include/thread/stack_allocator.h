@@ -0,0 +1,77 @@
+/*************************************************
+ * 描述：协程栈分配器。mmap 分配、栈底保护页、每线程缓存回收的栈，可选统计栈使用高水位
+ *
+ * File：stack_allocator.h
+ * Author：Cipher
+ * Date：2026/10/20-14:30
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_STACK_ALLOCATOR_H
+#define RAREVOYAGER_STACK_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace RareVoyager
+{
+#pragma region StackAllocator
+	/**
+	 * @brief: 协程栈分配器
+	 * 1. 每个栈单独 mmap，物理页在第一次访问时才分配，没用到的部分不占 RSS
+	 * 2. 栈向低地址增长，最低的一页设为 PROT_NONE，溢出时立刻 SIGSEGV 而不是踩坏相邻内存
+	 * 3. 释放的栈放进当前线程的空闲列表，下次同样大小的分配直接复用，不走系统调用
+	 * 4. 打开 fiber.stack_high_water 后，释放时用 mincore 扫描驻留的页，记录栈用到的最深位置，
+	 *    然后用 MADV_DONTNEED 归还物理页，下次使用从干净的栈开始，便于据此调整 fiber.stack_size
+	 * 每个栈占两个内存映射(保护页与栈)，同时存在几十万个协程时需要调大 vm.max_map_count
+	 */
+	class StackAllocator
+	{
+	public:
+		/**
+		 * @brief: 分配栈，返回可用区域的最低地址(保护页之上)，栈顶是返回值 + size
+		 * @param size 必须是 RoundUp 之后的大小
+		 */
+		static void* Alloc(size_t size);
+
+		/**
+		 * @brief: 释放栈，size 与分配时相同
+		 */
+		static void Dealloc(void* stack, size_t size);
+
+		/**
+		 * @brief: 向上取整到页大小
+		 */
+		static size_t RoundUp(size_t size);
+
+		/**
+		 * @brief: 默认栈大小，取配置 fiber.stack_size
+		 */
+		static size_t GetDefaultStackSize();
+
+		/**
+		 * @brief: 用 mincore 扫描栈驻留的页，返回从栈顶算起用到的字节数(按页计)
+		 */
+		static size_t MeasureUsage(void* stack, size_t size);
+
+		/**
+		 * @brief: 打开高水位统计后，所有释放过的栈里用得最深的字节数
+		 */
+		static size_t GetHighWater();
+
+		/**
+		 * @brief: 当前 mmap 着的栈数，包括各线程缓存的
+		 */
+		static uint64_t GetMappedCount();
+
+		/**
+		 * @brief: 当前线程缓存的空闲栈数
+		 */
+		static size_t GetPooledCount();
+
+		static size_t GetPageSize();
+	};
+#pragma endregion StackAllocator
+}
+
+#endif //RAREVOYAGER_STACK_ALLOCATOR_H
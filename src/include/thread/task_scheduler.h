@@ -0,0 +1,388 @@
+/*************************************************
+ * 描述：工作窃取任务调度器。每个工作线程一个 Chase-Lev 双端队列，
+ * 空闲时随机窃取其它线程的任务，适合细粒度的 CPU 密集型任务
+ *
+ * File：task_scheduler.h
+ * Author：Cipher
+ * Date：2026/10/19-20:40
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_TASK_SCHEDULER_H
+#define RAREVOYAGER_TASK_SCHEDULER_H
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <include/macro.h>
+#include <include/thread/thread.h>
+#include <include/thread/thread_group.h>
+#include <include/thread/mutex.h>
+
+namespace RareVoyager
+{
+	class TaskScheduler;
+
+#pragma region WorkStealingDeque
+	/**
+	 * @brief: Chase-Lev 双端队列(Lê 等人的 C11 内存模型版本)
+	 * 所有者在底部 push/pop，其它线程在顶部 steal；容量不够时翻倍，旧数组留到析构时释放
+	 */
+	template<class T>
+	class WorkStealingDeque
+	{
+	public:
+		explicit WorkStealingDeque(int64_t capacity = 256)
+			: m_top(0)
+			  , m_bottom(0)
+		{
+			int64_t n = 1;
+			while (n < capacity)
+			{
+				n <<= 1;
+			}
+			m_array.store(new Array(n), std::memory_order_relaxed);
+		}
+
+		~WorkStealingDeque()
+		{
+			delete m_array.load(std::memory_order_relaxed);
+			for (auto a: m_garbage)
+			{
+				delete a;
+			}
+		}
+
+		/**
+		 * @brief: 只能由所有者调用
+		 */
+		void push(T* item)
+		{
+			int64_t b = m_bottom.load(std::memory_order_relaxed);
+			int64_t t = m_top.load(std::memory_order_acquire);
+			Array* a = m_array.load(std::memory_order_relaxed);
+			if (RAREVOYAGER_UNLIKELY(b - t > a->capacity - 1))
+			{
+				a = grow(a, b, t);
+			}
+			a->put(b, item);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief: 只能由所有者调用，取最后 push 的任务
+		 */
+		T* pop()
+		{
+			int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+			Array* a = m_array.load(std::memory_order_relaxed);
+			m_bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = m_top.load(std::memory_order_relaxed);
+			if (t > b)
+			{
+				m_bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			T* item = a->get(b);
+			if (t == b)
+			{
+				// 最后一个元素，和窃取者抢
+				if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					item = nullptr;
+				}
+				m_bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return item;
+		}
+
+		/**
+		 * @brief: 任意线程调用，取最早 push 的任务；和别人抢失败也返回 nullptr
+		 */
+		T* steal()
+		{
+			int64_t t = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = m_bottom.load(std::memory_order_acquire);
+			if (t >= b)
+			{
+				return nullptr;
+			}
+			Array* a = m_array.load(std::memory_order_acquire);
+			T* item = a->get(t);
+			if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+			return item;
+		}
+
+		/**
+		 * @brief: 近似的元素个数
+		 */
+		int64_t size() const
+		{
+			int64_t b = m_bottom.load(std::memory_order_relaxed);
+			int64_t t = m_top.load(std::memory_order_relaxed);
+			return b > t ? b - t : 0;
+		}
+
+	private:
+		struct Array
+		{
+			explicit Array(int64_t n) : capacity(n), mask(n - 1), items(new std::atomic<T*>[n])
+			{
+			}
+
+			~Array()
+			{
+				delete[] items;
+			}
+
+			T* get(int64_t i) const { return items[i & mask].load(std::memory_order_relaxed); }
+
+			void put(int64_t i, T* item) { items[i & mask].store(item, std::memory_order_relaxed); }
+
+			int64_t capacity;
+			int64_t mask;
+			std::atomic<T*>* items;
+		};
+
+		Array* grow(Array* a, int64_t b, int64_t t)
+		{
+			Array* n = new Array(a->capacity * 2);
+			for (int64_t i = t; i < b; ++i)
+			{
+				n->put(i, a->get(i));
+			}
+			// 窃取者可能还在读旧数组，不能马上释放
+			m_garbage.push_back(a);
+			m_array.store(n, std::memory_order_release);
+			return n;
+		}
+
+	private:
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<int64_t> m_top;
+		alignas(RAREVOYAGER_CACHELINE_SIZE) std::atomic<int64_t> m_bottom;
+		std::atomic<Array*> m_array;
+		std::vector<Array*> m_garbage;
+	};
+#pragma endregion WorkStealingDeque
+
+#pragma region TaskGroup
+	/**
+	 * @brief: 一组任务。wait 时当前线程会帮忙执行任务，而不是阻塞等待，
+	 * 所以可以在任务里再创建 TaskGroup 递归地拆分
+	 * 任务抛出的第一个异常在 wait 时重新抛出
+	 */
+	class TaskGroup
+	{
+	public:
+		/**
+		 * @param scheduler 为空时使用当前线程所属的调度器
+		 */
+		explicit TaskGroup(TaskScheduler* scheduler = nullptr);
+
+		~TaskGroup();
+
+		void run(std::function<void()> cb);
+
+		void wait();
+
+	private:
+		TaskGroup(const TaskGroup&) = delete;
+
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+	private:
+		TaskScheduler* m_scheduler;
+		std::atomic<uint64_t> m_pending{0};
+		Mutex m_mutex;
+		std::exception_ptr m_exception;
+	};
+#pragma endregion TaskGroup
+
+#pragma region TaskScheduler
+	/**
+	 * @brief: 工作窃取调度器
+	 * 1. 工作线程里 spawn 的任务进自己的队列(后进先出，缓存友好)，外部线程 spawn 的进全局注入队列
+	 * 2. 空闲线程依次尝试: 自己的队列 -> 全局队列 -> 随机窃取；都没有就短暂自旋后在 futex 上睡眠
+	 * 配置项:
+	 *   task_scheduler.threads      工作线程数，0 表示 CPU 核数
+	 *   task_scheduler.pin_threads  每个工作线程绑定到一个物理核，此时 threads 为 0 表示物理核数
+	 */
+	class TaskScheduler
+	{
+	public:
+		typedef std::shared_ptr<TaskScheduler> ptr;
+
+		explicit TaskScheduler(const std::string& name = "ws", uint32_t threads = 0);
+
+		~TaskScheduler();
+
+		void spawn(std::function<void()> cb);
+
+		/**
+		 * @brief: 执行一个待处理的任务(自己的、全局的或窃取的)，没有任务返回 false
+		 */
+		bool runOne();
+
+		void stop();
+
+		uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+		const std::string& getName() const { return m_name; }
+
+		/**
+		 * @brief: 当前线程所属的调度器(包括外部线程在 wait 中帮忙执行任务时)，都不是返回 nullptr
+		 */
+		static TaskScheduler* GetThis();
+
+		/**
+		 * @brief: 对 [begin, end) 的每个下标调用 f(i)
+		 * 惰性二分: 每做完 grain 个检查一次，自己的队列空了(说明别人在偷)才把剩下的一半拆出去
+		 * @param grain 为 0 时按 (end - begin) / (线程数 * 64) 自动选择
+		 */
+		template<class F>
+		void parallelFor(size_t begin, size_t end, const F& f, size_t grain = 0)
+		{
+			if (begin >= end)
+			{
+				return;
+			}
+			grain = grain ? grain : autoGrain(end - begin);
+			TaskGroup group(this);
+			forRange(group, begin, end, f, grain);
+			group.wait();
+		}
+
+		/**
+		 * @brief: 并行归约。map(b, e) 计算 [b, e) 的部分结果，reduce(left, right) 按下标顺序合并
+		 */
+		template<class T, class Map, class Reduce>
+		T parallelReduce(size_t begin, size_t end, const T& identity, const Map& map, const Reduce& reduce,
+		                 size_t grain = 0)
+		{
+			if (begin >= end)
+			{
+				return identity;
+			}
+			grain = grain ? grain : autoGrain(end - begin);
+			return reduceRange(begin, end, identity, map, reduce, grain);
+		}
+
+	private:
+		struct Job
+		{
+			std::function<void()> cb;
+		};
+
+		struct alignas(RAREVOYAGER_CACHELINE_SIZE) Worker
+		{
+			WorkStealingDeque<Job> deque;
+			uint32_t index = 0;
+		};
+
+		TaskScheduler(const TaskScheduler&) = delete;
+
+		TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+		void workerLoop(Worker* worker);
+
+		Job* findJob(Worker* self);
+
+		Job* stealJob(Worker* self);
+
+		void notifyOne();
+
+		/**
+		 * @brief: 当前线程是否应该把任务拆出去
+		 */
+		bool needSplit();
+
+		size_t autoGrain(size_t n) const
+		{
+			size_t grain = n / (static_cast<size_t>(getWorkerCount()) * 64);
+			return grain ? grain : 1;
+		}
+
+		template<class F>
+		void forRange(TaskGroup& group, size_t b, size_t e, const F& f, size_t grain)
+		{
+			while (e - b > grain)
+			{
+				if (e - b > grain * 2 && needSplit())
+				{
+					size_t mid = b + (e - b) / 2;
+					group.run([this, &group, mid, e, &f, grain]() { forRange(group, mid, e, f, grain); });
+					e = mid;
+					continue;
+				}
+				for (size_t end = b + grain; b < end; ++b)
+				{
+					f(b);
+				}
+			}
+			for (; b < e; ++b)
+			{
+				f(b);
+			}
+		}
+
+		template<class T, class Map, class Reduce>
+		T reduceRange(size_t b, size_t e, const T& identity, const Map& map, const Reduce& reduce, size_t grain)
+		{
+			T acc = identity;
+			// 拆出去的右半部分，越往后越靠近当前区间
+			std::deque<T> rights;
+			TaskGroup group(this);
+			while (e - b > grain)
+			{
+				if (e - b > grain * 2 && needSplit())
+				{
+					size_t mid = b + (e - b) / 2;
+					rights.push_back(identity);
+					T* slot = &rights.back();
+					group.run([this, slot, mid, e, &identity, &map, &reduce, grain]() {
+						*slot = reduceRange(mid, e, identity, map, reduce, grain);
+					});
+					e = mid;
+					continue;
+				}
+				acc = reduce(acc, map(b, b + grain));
+				b += grain;
+			}
+			acc = reduce(acc, map(b, e));
+			group.wait();
+			for (auto it = rights.rbegin(); it != rights.rend(); ++it)
+			{
+				acc = reduce(acc, *it);
+			}
+			return acc;
+		}
+
+	private:
+		std::string m_name;
+		std::vector<std::unique_ptr<Worker> > m_workers;
+		// 工作线程并行启动，m_threads.getThread(i) 执行 m_workers[i]
+		ThreadGroup m_threads;
+		// 外部线程提交的任务
+		Mutex m_injectMutex;
+		std::deque<Job*> m_inject;
+		std::atomic<size_t> m_injectSize{0};
+		// 睡眠与唤醒: 睡前记下 epoch，有新任务时 epoch 加一并唤醒
+		std::atomic<uint32_t> m_epoch{0};
+		std::atomic<uint32_t> m_sleepers{0};
+		std::atomic<bool> m_stopping{false};
+	};
+#pragma endregion TaskScheduler
+}
+
+#endif //RAREVOYAGER_TASK_SCHEDULER_H
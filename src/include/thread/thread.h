@@ -4,13 +4,18 @@
  * File：thread.h
  * Author：Cipher
  * Date：2026/1/8-10:00
- * Update：
+ * Update：2026/10/19 Semaphore 改为基于 futex 实现，增加 tryWait/waitFor/waitUntil/notify(n)
+ *         2026/10/19 增加 ThreadOptions: 绑核、NUMA 节点、栈大小、调度策略
+ *         2026/10/20 ThreadOptions 增加 startLatch，构造时可以不等待线程启动
  * ************************************************/
 
 #ifndef RAREVOYAGER_THREAD_H
 #define RAREVOYAGER_THREAD_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
-#include <semaphore.h>
+#include <vector>
 
 extern "C" {
 #include <pthread.h>
@@ -30,7 +35,14 @@ using tid_t = pid_t;
 
 namespace RareVoyager
 {
+	class Latch;
+
 #pragma region Semaphore
+	/**
+	 * @brief: 基于 futex 的信号量
+	 * 没有等待者时 notify 不进内核；wait 先短暂自旋，拿不到再睡眠
+	 * 被信号打断(EINTR)或虚假唤醒时会重新检查计数，不会报错
+	 */
 	class Semaphore
 	{
 	public:
@@ -40,7 +52,28 @@ namespace RareVoyager
 
 		void wait();
 
-		void notify();
+		/**
+		 * @brief: 不阻塞，计数大于 0 时减一并返回 true
+		 */
+		bool tryWait();
+
+		/**
+		 * @brief: 最多等待 timeout，超时返回 false
+		 */
+		template<class Rep, class Period>
+		bool waitFor(const std::chrono::duration<Rep, Period>& timeout)
+		{
+			return waitUntil(std::chrono::steady_clock::now() + timeout);
+		}
+
+		bool waitUntil(const std::chrono::steady_clock::time_point& deadline);
+
+		/**
+		 * @brief: 计数加 n，并用一次系统调用唤醒最多 n 个等待者
+		 */
+		void notify(uint32_t n = 1);
+
+		uint32_t getCount() const { return static_cast<uint32_t>(m_state.load(std::memory_order_relaxed)); }
 
 	private:
 		Semaphore(const Semaphore&);
@@ -49,13 +82,43 @@ namespace RareVoyager
 
 		Semaphore& operator=(const Semaphore&) = delete;
 
+		bool spinWait();
+
+		/**
+		 * @brief: m_state 中计数所在的 32 位，作为 futex 字
+		 */
+		std::atomic<uint32_t>* countWord();
+
 	private:
-		sem_t m_sem;
+		// 低 32 位是剩余的计数，高 32 位是正在(或即将)睡眠的线程数。
+		// 放在同一个原子变量里，notify 加计数的同时就知道要不要 FUTEX_WAKE，之后不再访问成员:
+		// 等待者拿到计数后可能立刻返回并销毁信号量
+		std::atomic<uint64_t> m_state;
 
 	};
 #pragma endregion Semaphore
 
 #pragma region Thread
+	/**
+	 * @brief: 线程创建参数，默认值都表示沿用系统默认
+	 * 绑核、NUMA 与调度策略在新线程里、回调执行之前设置，失败只打警告，线程照常运行
+	 */
+	struct ThreadOptions
+	{
+		// 允许运行的 CPU，为空且指定了 numaNode 时使用该节点的全部 CPU
+		std::vector<int> cpus;
+		// NUMA 节点，线程之后分配的内存绑定到该节点(set_mempolicy MPOL_BIND)
+		int numaNode = -1;
+		// 栈大小(字节)，0 表示默认(通常是 ulimit -s)
+		size_t stackSize = 0;
+		// SCHED_OTHER / SCHED_FIFO / SCHED_RR / SCHED_BATCH / SCHED_IDLE，小于 0 表示不修改
+		int schedPolicy = -1;
+		// 实时策略下的优先级
+		int priority = 0;
+		// 不为空时构造函数不等待新线程启动，新线程完成初始化后对它 countDown，用于并行启动一组线程
+		Latch* startLatch = nullptr;
+	};
+
 	/**
 	 * @brief: 使用pthread 实现多线程，以及互斥量
 	 */
@@ -66,12 +129,15 @@ namespace RareVoyager
 
 		Thread(std::function<void()> cb, const std::string& name);
 
+		Thread(std::function<void()> cb, const std::string& name, const ThreadOptions& options);
+
 		~Thread();
 
 		void join();
 
 		const std::string& getName() const { return m_name; }
 		pid_t getId() const { return m_id; }
+		const ThreadOptions& getOptions() const { return m_options; }
 
 		static void* run(void* arg);
 
@@ -88,11 +154,17 @@ namespace RareVoyager
 
 		Thread& operator=(const Thread&) = delete;
 
+		/**
+		 * @brief: 在新线程里应用绑核、NUMA、调度策略
+		 */
+		void applyOptions();
+
 	private:
 		pid_t m_id = -1;
 		pthread_t m_thread = 0;
 		std::function<void()> m_cb;
 		std::string m_name;
+		ThreadOptions m_options;
 
 		Semaphore m_semaphore;
 	};
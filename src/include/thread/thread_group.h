@@ -0,0 +1,72 @@
+/*************************************************
+ * 描述：线程组。一次性并行启动一组线程，只等待一次全部启动完成
+ *
+ * File：thread_group.h
+ * Author：Cipher
+ * Date：2026/10/20-10:40
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_THREAD_GROUP_H
+#define RAREVOYAGER_THREAD_GROUP_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <include/thread/thread.h>
+#include <include/thread/barrier.h>
+
+namespace RareVoyager
+{
+#pragma region ThreadGroup
+	/**
+	 * @brief: 线程组
+	 * Thread 的构造函数会等新线程启动后才返回，逐个创建 N 个线程就是 N 次串行的创建加握手；
+	 * 线程组先把 N 个线程全部创建出来，再在一个 Latch 上等待一次
+	 * 析构时 join 所有线程
+	 */
+	class ThreadGroup
+	{
+	public:
+		typedef std::shared_ptr<ThreadGroup> ptr;
+
+		explicit ThreadGroup(const std::string& name = "group");
+
+		~ThreadGroup();
+
+		/**
+		 * @brief: 启动 n 个线程，第 i 个线程执行 cb(i)，线程名为 name_i；所有线程完成初始化后返回
+		 * @param options 每个线程相同的创建参数，startLatch 会被忽略
+		 */
+		void start(size_t n, std::function<void(size_t)> cb, const ThreadOptions& options = ThreadOptions());
+
+		/**
+		 * @brief: 同 start，第 i 个线程使用 options[i]，可以分别绑核
+		 */
+		void start(std::function<void(size_t)> cb, const std::vector<ThreadOptions>& options);
+
+		void join();
+
+		size_t size() const { return m_threads.size(); }
+
+		const Thread::ptr& getThread(size_t i) const { return m_threads[i]; }
+
+		const std::string& getName() const { return m_name; }
+
+	private:
+		ThreadGroup(const ThreadGroup&) = delete;
+
+		ThreadGroup& operator=(const ThreadGroup&) = delete;
+
+	private:
+		std::string m_name;
+		std::vector<Thread::ptr> m_threads;
+		// 每次 start 一个，和线程组同生命周期，最后一个 countDown 的线程可能还在访问
+		std::vector<std::unique_ptr<Latch> > m_latches;
+	};
+#pragma endregion ThreadGroup
+}
+
+#endif //RAREVOYAGER_THREAD_GROUP_H
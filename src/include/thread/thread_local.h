@@ -0,0 +1,242 @@
+/*************************************************
+ * 描述：可枚举的线程局部存储。每个 ThreadLocal 对象在每个线程里有一份独立的值，
+ * 可以遍历所有线程的值做汇总，线程退出时自动析构
+ *
+ * File：thread_local.h
+ * Author：Cipher
+ * Date：2026/10/20-09:30
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_THREAD_LOCAL_H
+#define RAREVOYAGER_THREAD_LOCAL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <include/macro.h>
+
+namespace RareVoyager
+{
+	class ThreadLocalBase;
+
+	struct ThreadLocalData;
+
+#pragma region ThreadLocalEntry
+	/**
+	 * @brief: 某个 ThreadLocal 在某个线程里的一份值，挂在所属 ThreadLocal 的链表上
+	 */
+	struct ThreadLocalEntry
+	{
+		virtual ~ThreadLocalEntry() = default;
+
+		ThreadLocalBase* owner = nullptr;
+		ThreadLocalData* data = nullptr;
+		ThreadLocalEntry* prev = nullptr;
+		ThreadLocalEntry* next = nullptr;
+	};
+#pragma endregion ThreadLocalEntry
+
+#pragma region ThreadLocalBase
+	/**
+	 * @brief: 与值类型无关的部分: 槽位分配、线程登记、链表维护
+	 * 每个线程有一张两级槽位表，按 ThreadLocal 的编号取自己的那一份；
+	 * 槽位表只由本线程创建和扩展，读取不加锁
+	 * 创建、线程退出、ThreadLocal 析构与遍历由一把全局锁串行化，它们都不在取值的快速路径上
+	 */
+	class ThreadLocalBase
+	{
+	public:
+		// 每块槽位数与最多块数，最多同时存在 s_chunkSize * s_maxChunks 个 ThreadLocal
+		static const uint32_t s_chunkSize = 64;
+		static const uint32_t s_maxChunks = 1024;
+
+		ThreadLocalBase();
+
+		virtual ~ThreadLocalBase();
+
+		/**
+		 * @brief: 有值的线程数
+		 */
+		size_t getThreadCount() const;
+
+	protected:
+		/**
+		 * @brief: 当前线程的值，没有返回 nullptr
+		 */
+		ThreadLocalEntry* find() const
+		{
+			ThreadLocalData* data = t_data;
+			if (RAREVOYAGER_UNLIKELY(!data))
+			{
+				return nullptr;
+			}
+			return Lookup(data, m_id);
+		}
+
+		/**
+		 * @brief: 当前线程第一次取值时创建
+		 */
+		ThreadLocalEntry* create();
+
+		/**
+		 * @brief: 持有全局锁遍历所有线程的值
+		 */
+		void visit(const std::function<void(ThreadLocalEntry*)>& cb) const;
+
+		virtual ThreadLocalEntry* newEntry() = 0;
+
+		/**
+		 * @brief: 线程退出、值被释放之前调用
+		 */
+		virtual void onThreadExit(ThreadLocalEntry*)
+		{
+		}
+
+	private:
+		friend struct ThreadLocalData;
+
+		static ThreadLocalEntry* Lookup(ThreadLocalData* data, uint32_t id);
+
+		/**
+		 * @brief: 调用者持有全局锁，从链表与槽位表摘下并释放
+		 */
+		void destroyEntry(ThreadLocalEntry* entry);
+
+		ThreadLocalBase(const ThreadLocalBase&) = delete;
+
+		ThreadLocalBase& operator=(const ThreadLocalBase&) = delete;
+
+	private:
+		static inline thread_local ThreadLocalData* t_data = nullptr;
+
+		uint32_t m_id;
+		ThreadLocalEntry* m_head = nullptr;
+		size_t m_count = 0;
+	};
+
+	/**
+	 * @brief: 一个线程的槽位表
+	 */
+	struct ThreadLocalData
+	{
+		ThreadLocalData();
+
+		~ThreadLocalData();
+
+		std::atomic<std::atomic<ThreadLocalEntry*>*> chunks[ThreadLocalBase::s_maxChunks];
+	};
+
+	inline ThreadLocalEntry* ThreadLocalBase::Lookup(ThreadLocalData* data, uint32_t id)
+	{
+		// 槽位表只有本线程会写入新值，别的线程只会在全局锁内把槽位清空
+		std::atomic<ThreadLocalEntry*>* chunk = data->chunks[id / s_chunkSize].load(std::memory_order_relaxed);
+		return chunk ? chunk[id % s_chunkSize].load(std::memory_order_relaxed) : nullptr;
+	}
+#pragma endregion ThreadLocalBase
+
+#pragma region ThreadLocal
+	/**
+	 * @brief: 线程局部变量
+	 * 1. get() 的快速路径是两次数组下标访问，不加锁、不写共享内存
+	 * 2. 任何线程(包括不是 RareVoyager::Thread 创建的)退出时，它的值被析构；
+	 *    可以设置 onExit 在析构前把值合并到别处，避免退出线程的计数丢失
+	 * 3. forEachThread 在全局锁内遍历，值的所有者此时仍可能在修改，需要跨线程读的字段应使用原子变量
+	 * @tparam T 指定初始值时需要可复制构造，否则只需要可默认构造(可以是原子变量)
+	 */
+	template<class T>
+	class ThreadLocal : public ThreadLocalBase
+	{
+	public:
+		typedef std::shared_ptr<ThreadLocal> ptr;
+
+		/**
+		 * @brief: 每个线程的值默认构造
+		 * @param on_exit 线程退出时在全局锁内调用，不能再访问任何 ThreadLocal
+		 */
+		explicit ThreadLocal(std::function<void(T&)> on_exit = nullptr)
+			: m_factory([]() { return new Entry(); })
+			  , m_onExit(std::move(on_exit))
+		{
+		}
+
+		/**
+		 * @brief: 每个线程的值从 init 复制
+		 */
+		explicit ThreadLocal(const T& init, std::function<void(T&)> on_exit = nullptr)
+			: m_factory([init]() { return new Entry(init); })
+			  , m_onExit(std::move(on_exit))
+		{
+		}
+
+		~ThreadLocal() override = default;
+
+		T& get()
+		{
+			ThreadLocalEntry* entry = find();
+			if (RAREVOYAGER_UNLIKELY(!entry))
+			{
+				entry = create();
+			}
+			return static_cast<Entry*>(entry)->value;
+		}
+
+		T& operator*() { return get(); }
+
+		T* operator->() { return &get(); }
+
+		/**
+		 * @brief: 对每个线程的值调用 cb(T&)
+		 */
+		template<class F>
+		void forEachThread(F cb) const
+		{
+			visit([&cb](ThreadLocalEntry* entry) { cb(static_cast<Entry*>(entry)->value); });
+		}
+
+		/**
+		 * @brief: 汇总所有线程的值: result = f(result, value)
+		 */
+		template<class R, class F>
+		R combine(R init, F f) const
+		{
+			forEachThread([&init, &f](T& value) { init = f(init, value); });
+			return init;
+		}
+
+	protected:
+		ThreadLocalEntry* newEntry() override
+		{
+			return m_factory();
+		}
+
+		void onThreadExit(ThreadLocalEntry* entry) override
+		{
+			if (m_onExit)
+			{
+				m_onExit(static_cast<Entry*>(entry)->value);
+			}
+		}
+
+	private:
+		struct Entry : public ThreadLocalEntry
+		{
+			template<class... Args>
+			explicit Entry(Args&&... args) : value(std::forward<Args>(args)...)
+			{
+			}
+
+			T value;
+		};
+
+	private:
+		std::function<Entry*()> m_factory;
+		std::function<void(T&)> m_onExit;
+	};
+#pragma endregion ThreadLocal
+}
+
+#endif //RAREVOYAGER_THREAD_LOCAL_H
@@ -0,0 +1,217 @@
+/*************************************************
+ * 描述：线程池。固定或弹性数量的工作线程，提交任务返回 future
+ *
+ * File：thread_pool.h
+ * Author：Cipher
+ * Date：2026/10/19-19:30
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_THREAD_POOL_H
+#define RAREVOYAGER_THREAD_POOL_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <include/thread/thread.h>
+#include <include/thread/mutex.h>
+#include <include/thread/barrier.h>
+#include <include/metrics/hdr_histogram.h>
+#include <include/util.h>
+
+namespace RareVoyager
+{
+#pragma region ThreadPool
+	/**
+	 * @brief: 线程池
+	 * 1. 工作线程数在 [minThreads, maxThreads] 之间，所有线程都在忙时按需增加，
+	 *    超过 minThreads 的线程空闲 idleTimeout 后退出；minThreads == maxThreads 即固定大小
+	 * 2. 被取消或关闭时丢弃的任务不会执行，对应 future.get() 抛出 std::future_error(broken_promise)
+	 * 配置项(使用不带参数个数的构造函数时生效):
+	 *   thread_pool.min_threads       最少线程数
+	 *   thread_pool.max_threads       最多线程数，0 表示与 min_threads 相同
+	 *   thread_pool.idle_timeout_ms   多余线程的空闲退出时间
+	 */
+	class ThreadPool
+	{
+	public:
+		typedef std::shared_ptr<ThreadPool> ptr;
+		typedef Mutex MutexType;
+
+		enum ShutdownMode
+		{
+			// 执行完队列里剩余的任务再退出
+			DRAIN = 0,
+			// 丢弃还没开始的任务，只等正在执行的任务
+			ABANDON = 1
+		};
+
+		/**
+		 * @brief: 任务句柄，用于取消还没开始执行的任务
+		 */
+		class Task
+		{
+		public:
+			typedef std::shared_ptr<Task> ptr;
+
+			enum State
+			{
+				PENDING = 0,
+				RUNNING = 1,
+				FINISHED = 2,
+				CANCELLED = 3
+			};
+
+			/**
+			 * @brief: 只有还在排队的任务能取消成功
+			 */
+			bool cancel()
+			{
+				int expected = PENDING;
+				return m_state.compare_exchange_strong(expected, CANCELLED);
+			}
+
+			State getState() const { return static_cast<State>(m_state.load()); }
+
+		private:
+			friend class ThreadPool;
+
+			std::function<void()> m_cb;
+			std::atomic<int> m_state{PENDING};
+			uint64_t m_enqueueNS = 0;
+		};
+
+		struct Stats
+		{
+			uint32_t threads = 0;
+			uint32_t idleThreads = 0;
+			uint64_t queueDepth = 0;
+			uint64_t maxQueueDepth = 0;
+			uint64_t submitted = 0;
+			uint64_t completed = 0;
+			uint64_t cancelled = 0;
+		};
+
+		/**
+		 * @brief: 线程数与空闲时间从配置读取
+		 */
+		explicit ThreadPool(const std::string& name = "pool");
+
+		ThreadPool(const std::string& name, uint32_t min_threads, uint32_t max_threads = 0,
+		           uint64_t idle_timeout_ms = 60000);
+
+		~ThreadPool();
+
+		/**
+		 * @brief: 提交一个任务
+		 * @param task 不为空时返回任务句柄，可用于取消
+		 */
+		template<class F>
+		auto submit(F&& f, Task::ptr* task = nullptr) -> std::future<typename std::invoke_result<F>::type>
+		{
+			typedef typename std::invoke_result<F>::type ResultType;
+			auto pt = std::make_shared<std::packaged_task<ResultType()> >(std::forward<F>(f));
+			std::future<ResultType> future = pt->get_future();
+			Task::ptr t = makeTask([pt]() { (*pt)(); });
+			if (task)
+			{
+				*task = t;
+			}
+			enqueue(&t, 1);
+			return future;
+		}
+
+		/**
+		 * @brief: 批量提交，只加一次锁、只唤醒一次
+		 */
+		std::vector<std::future<void> > submitN(const std::vector<std::function<void()> >& cbs,
+		                                        std::vector<Task::ptr>* tasks = nullptr);
+
+		/**
+		 * @brief: 停止接收新任务并等待工作线程退出，重复调用无副作用
+		 * 在本线程池的任务里调用(包括任务释放了线程池的最后一个引用)时不等待当前线程，它在任务返回后退出
+		 */
+		void shutdown(ShutdownMode mode = DRAIN);
+
+		bool isStopping() const { return m_stopping.load(std::memory_order_acquire); }
+
+		const std::string& getName() const { return m_name; }
+
+		Stats getStats();
+
+		/**
+		 * @brief: 任务从提交到开始执行的排队时间(纳秒)
+		 */
+		const HdrHistogram& getQueueLatency() const { return m_queueLatency; }
+
+		/**
+		 * @brief: 任务执行时间(纳秒)
+		 */
+		const HdrHistogram& getRunLatency() const { return m_runLatency; }
+
+		std::string toString();
+
+	private:
+		ThreadPool(const ThreadPool&) = delete;
+
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void start();
+
+		Task::ptr makeTask(std::function<void()> cb);
+
+		void enqueue(Task::ptr* tasks, size_t n);
+
+		/**
+		 * @brief: 需要时增加工作线程，调用者持有 m_mutex
+		 */
+		void maybeSpawn(size_t pending);
+
+		/**
+		 * @param latch 不为空时不等待新线程启动，由调用者统一等待
+		 */
+		void spawn(Latch* latch = nullptr);
+
+		void reapFinished();
+
+		void workerLoop();
+
+	private:
+		std::string m_name;
+		uint32_t m_minThreads;
+		uint32_t m_maxThreads;
+		uint64_t m_idleTimeoutMS;
+
+		MutexType m_mutex;
+		std::deque<Task::ptr> m_tasks;
+		std::list<Thread::ptr> m_threads;
+		// 已经退出、等待 join 的线程
+		std::list<Thread::ptr> m_finished;
+		// 初始线程并行启动用的门闩
+		std::unique_ptr<Latch> m_startLatch;
+		uint32_t m_threadIndex = 0;
+		uint32_t m_idle = 0;
+		uint64_t m_maxQueueDepth = 0;
+
+		// 计数等于队列中(包括已取消)的任务数，关闭时额外加上线程数用于唤醒
+		Semaphore m_semaphore;
+		std::atomic<bool> m_stopping{false};
+		std::atomic<bool> m_abandon{false};
+
+		std::atomic<uint64_t> m_submitted{0};
+		std::atomic<uint64_t> m_completed{0};
+		std::atomic<uint64_t> m_cancelled{0};
+		HdrHistogram m_queueLatency;
+		HdrHistogram m_runLatency;
+	};
+#pragma endregion ThreadPool
+}
+
+#endif //RAREVOYAGER_THREAD_POOL_H
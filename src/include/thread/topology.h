@@ -0,0 +1,95 @@
+/*************************************************
+ * 描述：CPU 拓扑。读取 /sys/devices/system/cpu 与 /sys/devices/system/node，
+ * 用于把线程按物理核、NUMA 节点排布
+ *
+ * File：topology.h
+ * Author：Cipher
+ * Date：2026/10/19-21:30
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_TOPOLOGY_H
+#define RAREVOYAGER_TOPOLOGY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace RareVoyager
+{
+#pragma region CpuTopology
+	/**
+	 * @brief: 一个逻辑 CPU(硬件线程)的位置
+	 */
+	struct CpuInfo
+	{
+		int cpu = 0;
+		// 物理核编号，只在同一个 package 内唯一
+		int core = 0;
+		int package = 0;
+		int node = 0;
+	};
+
+	/**
+	 * @brief: 进程启动后第一次调用时解析一次；读不到 sysfs 时退化成每个逻辑 CPU 一个核、单个节点
+	 */
+	class CpuTopology
+	{
+	public:
+		static const CpuTopology& Get();
+
+		const std::vector<CpuInfo>& getCpus() const { return m_cpus; }
+
+		int getNodeCount() const { return m_nodeCount; }
+
+		/**
+		 * @brief: 物理核数(不计超线程)
+		 */
+		int getCoreCount() const;
+
+		/**
+		 * @brief: 某个 NUMA 节点上的逻辑 CPU
+		 */
+		std::vector<int> getNodeCpus(int node) const;
+
+		int getNodeOfCpu(int cpu) const;
+
+		/**
+		 * @brief: 每个物理核取一个逻辑 CPU，按节点、核排好序，适合给线程池逐个绑定
+		 * @param node 小于 0 表示所有节点
+		 */
+		std::vector<int> onePerPhysicalCore(int node = -1) const;
+
+		std::string toString() const;
+
+		/**
+		 * @brief: 解析 "0-3,8,10-11" 格式的 CPU 列表
+		 */
+		static std::vector<int> ParseCpuList(const std::string& str);
+
+	private:
+		CpuTopology();
+
+	private:
+		std::vector<CpuInfo> m_cpus;
+		int m_nodeCount = 1;
+	};
+#pragma endregion CpuTopology
+
+#pragma region Numa
+	/**
+	 * @brief: 当前线程之后分配的内存只从 node 上取(set_mempolicy MPOL_BIND)
+	 * @param node 小于 0 时恢复默认策略
+	 * @return 内核不支持 NUMA 或节点不存在时返回 false
+	 */
+	bool NumaBindThread(int node);
+
+	/**
+	 * @brief: 把 [addr, addr + len) 的页绑定到 node(mbind MPOL_BIND)，addr 需按页对齐
+	 * 只影响之后首次访问的页，已经分配的页不迁移
+	 */
+	bool NumaBindMemory(void* addr, size_t len, int node);
+#pragma endregion Numa
+}
+
+#endif //RAREVOYAGER_TOPOLOGY_H
@@ -0,0 +1,221 @@
+/*************************************************
+ * 描述：定时器。分层时间轮，添加、取消、刷新都是 O(1)，
+ * 支持循环定时器与绑定 weak_ptr 的条件定时器
+ *
+ * File：timer.h
+ * Author：Cipher
+ * Date：2026/10/20-11:20
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_TIMER_H
+#define RAREVOYAGER_TIMER_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <include/thread/mutex.h>
+
+namespace RareVoyager
+{
+	class TimerManager;
+
+#pragma region Timer
+	/**
+	 * @brief: 定时器句柄
+	 * 等待中的定时器由时间轮持有(自引用)，到期、取消后释放；外部不保存句柄也会按时执行
+	 */
+	class Timer : public std::enable_shared_from_this<Timer>
+	{
+		friend class TimerManager;
+
+	public:
+		typedef std::shared_ptr<Timer> ptr;
+
+		/**
+		 * @brief: 取消，已经到期或取消过返回 false
+		 */
+		bool cancel();
+
+		/**
+		 * @brief: 从现在起重新计时，周期不变
+		 */
+		bool refresh();
+
+		/**
+		 * @brief: 修改周期
+		 * @param from_now true 从现在开始计时，false 从上次开始计时的时间算起
+		 */
+		bool reset(uint64_t ms, bool from_now);
+
+		uint64_t getPeriod() const { return m_ms; }
+
+		bool isRecurring() const { return m_recurring; }
+
+	private:
+		Timer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager* manager);
+
+	private:
+		// 周期(毫秒)
+		uint64_t m_ms = 0;
+		// 开始计时的时刻与到期时刻，单位是时间轮的 tick(毫秒)
+		uint64_t m_start = 0;
+		uint64_t m_expire = 0;
+		std::function<void()> m_cb;
+		bool m_recurring = false;
+		TimerManager* m_manager = nullptr;
+
+		// 所在的层(0 是第 0 层)和槽，-1 表示不在时间轮里(已到期、已取消)
+		int32_t m_level = -1;
+		uint32_t m_index = 0;
+		// 槽位里的双向链表
+		Timer* m_prev = nullptr;
+		Timer* m_next = nullptr;
+		// 在时间轮里时指向自己，保证等待期间不被释放
+		ptr m_self;
+	};
+#pragma endregion Timer
+
+#pragma region TimerManager
+	/**
+	 * @brief: 分层时间轮
+	 * 第 0 层 256 个槽，每槽 1 毫秒；第 1~4 层各 64 个槽，每层粒度是上一层的 64 倍，共覆盖 2^32 毫秒(约 49 天)，
+	 * 更远的定时器放在最高层，转到时再重新放置
+	 * 1. 添加、取消、刷新只是槽位链表的插入删除
+	 * 2. 时间推进时第 0 层转满一圈，就把上一层当前槽的定时器按剩余时间重新分配到下层(级联)
+	 * 3. listExpiredCallbacks 一次加锁取出所有到期回调，调用者在锁外批量执行
+	 * 时间使用单调时钟，不受系统时间调整影响
+	 */
+	class TimerManager
+	{
+		friend class Timer;
+
+	public:
+		typedef Mutex MutexType;
+
+		TimerManager();
+
+		virtual ~TimerManager();
+
+		/**
+		 * @param ms 多少毫秒后执行
+		 * @param recurring 是否循环执行
+		 */
+		Timer::ptr addTimer(uint64_t ms, std::function<void()> cb, bool recurring = false);
+
+		/**
+		 * @brief: 条件定时器，到期时 weak_cond 指向的对象已经释放就不执行
+		 */
+		Timer::ptr addConditionTimer(uint64_t ms, std::function<void()> cb, std::weak_ptr<void> weak_cond,
+		                             bool recurring = false);
+
+		/**
+		 * @brief: 距离下一个定时器到期的毫秒数，已经有到期的返回 0，没有定时器返回 UINT64_MAX
+		 * 高层的定时器返回的是它所在槽开始的时间，可能比实际到期早，到时再次调用即可
+		 */
+		uint64_t getNextTimer();
+
+		/**
+		 * @brief: 推进时间轮，取出所有到期定时器的回调；循环定时器重新放回
+		 */
+		void listExpiredCallbacks(std::vector<std::function<void()> >& cbs);
+
+		bool hasTimer();
+
+		size_t getTimerCount();
+
+	protected:
+		/**
+		 * @brief: 新加的定时器比上次 getNextTimer 返回的时间更早时调用，事件循环据此提前唤醒
+		 */
+		virtual void onTimerInsertedAtFront()
+		{
+		}
+
+		/**
+		 * @brief: 当前时刻，单位 tick(毫秒)
+		 */
+		uint64_t nowTick() const;
+
+	private:
+		static const uint32_t s_rootBits = 8;
+		static const uint32_t s_levelBits = 6;
+		static const uint32_t s_rootSize = 1u << s_rootBits;
+		static const uint32_t s_levelSize = 1u << s_levelBits;
+		static const uint32_t s_levels = 4;
+
+		struct Slot
+		{
+			Timer* head = nullptr;
+			Timer* tail = nullptr;
+		};
+
+		/**
+		 * @brief: 第 level 层第 index 个槽，第 0 层是 m_root
+		 */
+		Slot& slot(uint32_t level, uint32_t index) { return level ? m_wheels[level - 1][index] : m_root[index]; }
+
+		/**
+		 * @brief: 向上取整的当前 tick，作为定时器的起点。nowTick 向下取整，
+		 * 用它加 ms 算出的到期时间最多会提前 1ms
+		 */
+		uint64_t startTick() const;
+
+		/**
+		 * @brief: 按到期时间放入对应的槽，调用者持有锁
+		 */
+		void place(Timer* timer);
+
+		/**
+		 * @brief: 到期时间是否比上次告诉事件循环的更早，是则需要通知，同一轮只通知一次
+		 */
+		bool markFront(uint64_t expire);
+
+		/**
+		 * @brief: 从所在的槽取下，调用者持有锁
+		 */
+		void unlink(Timer* timer);
+
+		/**
+		 * @brief: 把 level 层 index 槽的定时器按剩余时间重新放置，返回 index
+		 */
+		uint32_t cascade(uint32_t level, uint32_t index);
+
+		/**
+		 * @brief: 时间轮推进到 tick(含)，到期的定时器追加到 expired
+		 */
+		void advance(uint64_t tick, std::vector<Timer::ptr>& expired);
+
+		/**
+		 * @brief: 最早到期时间的下界，单位 tick
+		 */
+		uint64_t nextExpire() const;
+
+		/**
+		 * @brief: 添加或修改后通知事件循环，调用者不能持有锁
+		 */
+		void notifyFront(bool front);
+
+	private:
+		MutexType m_mutex;
+		// 创建时的单调时钟，tick 从 0 开始
+		uint64_t m_baseNS;
+		// 下一个要处理的 tick
+		uint64_t m_current = 0;
+		size_t m_count = 0;
+		// 上次 getNextTimer 之后是否已经通知过，避免重复唤醒
+		bool m_tickled = false;
+		// 上次 getNextTimer 算出的下次到期 tick
+		uint64_t m_nextHint = UINT64_MAX;
+		Slot m_root[s_rootSize];
+		Slot m_wheels[s_levels][s_levelSize];
+		// 非空槽的位图，推进时跳过空槽，getNextTimer 不用逐个槽扫描
+		uint64_t m_rootBitmap[s_rootSize / 64] = {};
+		uint64_t m_wheelBitmap[s_levels] = {};
+	};
+#pragma endregion TimerManager
+}
+
+#endif //RAREVOYAGER_TIMER_H
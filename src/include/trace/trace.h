@@ -0,0 +1,136 @@
+/*************************************************
+ * 描述：作用域追踪。记录代码段的起止时间，导出为 Chrome trace-event JSON (可用 Perfetto 查看)
+ *
+ * File：trace.h
+ * Author：Cipher
+ * Date：2026/10/19-13:40
+ * Update：
+ * ************************************************/
+
+#ifndef RAREVOYAGER_TRACE_H
+#define RAREVOYAGER_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <include/macro.h>
+
+#define RAREVOYAGER_TRACE_CONCAT_IMPL(a, b) a##b
+#define RAREVOYAGER_TRACE_CONCAT(a, b) RAREVOYAGER_TRACE_CONCAT_IMPL(a, b)
+
+/**
+ * @brief 追踪当前作用域，name 必须是字符串字面量(只保存指针)
+ * 关闭时只有一次分支判断；定义 RAREVOYAGER_DISABLE_TRACE 后编译期完全移除
+ */
+#ifdef RAREVOYAGER_DISABLE_TRACE
+#define RAREVOYAGER_TRACE_SCOPE(name)
+#else
+#define RAREVOYAGER_TRACE_SCOPE(name) \
+RareVoyager::TraceScope RAREVOYAGER_TRACE_CONCAT(__rarevoyager_trace_, __LINE__)(name)
+#endif
+
+namespace RareVoyager
+{
+#pragma region TraceClock
+	/**
+	 * @brief: 追踪用时钟。x86 上直接读 TSC(几个纳秒)，导出时再换算成微秒
+	 */
+	class TraceClock
+	{
+	public:
+		static uint64_t Now()
+		{
+#if defined(__x86_64__) || defined(__i386__)
+			return __rdtsc();
+#else
+			return NowNS();
+#endif
+		}
+
+		/**
+		 * @brief: 把 Now() 的读数换算成单调时钟的纳秒
+		 */
+		static uint64_t ToNS(uint64_t ticks);
+
+	private:
+		static uint64_t NowNS();
+	};
+#pragma endregion TraceClock
+
+#pragma region Tracer
+	/**
+	 * @brief: 追踪器。每个线程一个环形缓冲区，写满后覆盖最旧的事件
+	 * 开关与导出可通过配置项控制:
+	 *   trace.enable       是否记录
+	 *   trace.buffer_size  每个线程缓冲区的事件数
+	 *   trace.dump         设置为文件路径时立即导出一次
+	 */
+	class Tracer
+	{
+	public:
+		static bool IsEnabled()
+		{
+			return s_enabled.load(std::memory_order_relaxed);
+		}
+
+		static void SetEnabled(bool v);
+
+		/**
+		 * @brief: 写入当前线程的缓冲区，只由 TraceScope 调用
+		 */
+		static void Record(const char* name, uint64_t begin, uint64_t end);
+
+		/**
+		 * @brief: 收集所有线程(包括已退出的线程)的事件，生成 Chrome trace-event JSON
+		 */
+		static std::string ToChromeTraceJson();
+
+		static bool WriteChromeTrace(const std::string& filename);
+
+		/**
+		 * @brief: 清空所有事件，并释放已退出线程的缓冲区
+		 */
+		static void Clear();
+
+	private:
+		static std::atomic<bool> s_enabled;
+	};
+#pragma endregion Tracer
+
+#pragma region TraceScope
+	class TraceScope
+	{
+	public:
+		explicit TraceScope(const char* name)
+			: m_name(name)
+			  , m_begin(RAREVOYAGER_UNLIKELY(Tracer::IsEnabled()) ? TraceClock::Now() : 0)
+		{
+		}
+
+		~TraceScope()
+		{
+			if (RAREVOYAGER_UNLIKELY(m_begin))
+			{
+				Tracer::Record(m_name, m_begin, TraceClock::Now());
+			}
+		}
+
+	private:
+		TraceScope(const TraceScope&) = delete;
+
+		TraceScope& operator=(const TraceScope&) = delete;
+
+	private:
+		const char* m_name;
+		uint64_t m_begin;
+	};
+#pragma endregion TraceScope
+}
+
+#endif //RAREVOYAGER_TRACE_H
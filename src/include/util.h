@@ -26,6 +26,9 @@ namespace RareVoyager
 	// 获取当前时间字符串
 	std::string GetCurrentDateStr();
 
+	// 单调时钟(CLOCK_MONOTONIC)的纳秒数，不受系统时间调整影响，用于计时
+	uint64_t GetMonotonicNS();
+
 	// 断言信息assert
 	void Backtrace(std::vector<std::string>& bt,int size ,int skip = 1);
 
@@ -92,10 +92,15 @@ namespace RareVoyager
 			}
 		}
 	}
-	ConfigVarBase::ptr Config::LookupBase(const std::string& name) {
-		// RWMutexType::ReadLock lock(GetMutex());
-		auto it = GetDatas().find(name);
-		return it == GetDatas().end() ? nullptr : it->second;
+	ConfigVarBase::ptr Config::LookupBase(std::string_view name) {
+		ConfigVarBase::ptr var;
+		GetDatas().find(name, var);
+		return var;
+	}
+
+	void Config::Visit(std::function<void(const std::string&, const ConfigVarBase::ptr&)> cb)
+	{
+		GetDatas().forEach(cb);
 	}
 #pragma endregion Config
 
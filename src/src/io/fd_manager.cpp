@@ -0,0 +1,136 @@
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <include/io/fd_manager.h>
+#include <include/io/hook.h>
+
+namespace RareVoyager
+{
+	// fd 上限，RLIMIT_NOFILE 的硬限制更大(或无限)时按这个算
+	static const size_t s_fd_max_fds = 1u << 24;
+
+#pragma region FdCtx
+	void FdCtx::init(int fd)
+	{
+		struct stat st;
+		if (fstat(fd, &st))
+		{
+			return;
+		}
+		m_fd = fd;
+		m_isSocket = S_ISSOCK(st.st_mode);
+		m_userNonblock = false;
+		m_sysNonblock = false;
+		if (m_isSocket)
+		{
+			// 绕过 hook 的 fcntl，直接改系统层面的标志
+			int flags = fcntl_f(fd, F_GETFL, 0);
+			m_userNonblock = flags & O_NONBLOCK;
+			if (!(flags & O_NONBLOCK))
+			{
+				fcntl_f(fd, F_SETFL, flags | O_NONBLOCK);
+			}
+			m_sysNonblock = true;
+		}
+		m_isClosed = false;
+		m_recvTimeout = UINT64_MAX;
+		m_sendTimeout = UINT64_MAX;
+		m_isInit.store(true, std::memory_order_release);
+	}
+
+	void FdCtx::reset()
+	{
+		m_isInit.store(false, std::memory_order_release);
+		m_isClosed = true;
+		m_recvTimeout = UINT64_MAX;
+		m_sendTimeout = UINT64_MAX;
+	}
+
+	void FdCtx::setTimeout(int type, uint64_t ms)
+	{
+		if (type == SO_RCVTIMEO)
+		{
+			m_recvTimeout = ms;
+		}
+		else
+		{
+			m_sendTimeout = ms;
+		}
+	}
+
+	uint64_t FdCtx::getTimeout(int type) const
+	{
+		return type == SO_RCVTIMEO ? m_recvTimeout : m_sendTimeout;
+	}
+#pragma endregion FdCtx
+
+#pragma region FdManager
+	FdManager::FdManager()
+	{
+		rlimit rl;
+		size_t max_fds = s_fd_max_fds;
+		if (!getrlimit(RLIMIT_NOFILE, &rl) && rl.rlim_max != RLIM_INFINITY && rl.rlim_max < max_fds)
+		{
+			max_fds = rl.rlim_max;
+		}
+		m_chunkCount = (max_fds + s_chunkSize - 1) / s_chunkSize;
+		m_chunks = new std::atomic<FdCtx*>[m_chunkCount];
+		for (size_t i = 0; i < m_chunkCount; ++i)
+		{
+			m_chunks[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	FdCtx* FdManager::get(int fd, bool auto_create)
+	{
+		if (fd < 0)
+		{
+			return nullptr;
+		}
+		size_t chunk_index = static_cast<size_t>(fd) >> s_chunkBits;
+		if (chunk_index >= m_chunkCount)
+		{
+			return nullptr;
+		}
+		FdCtx* chunk = m_chunks[chunk_index].load(std::memory_order_acquire);
+		if (!chunk && !auto_create)
+		{
+			return nullptr;
+		}
+		if (chunk)
+		{
+			FdCtx* ctx = &chunk[fd & (s_chunkSize - 1)];
+			if (ctx->isInit() || !auto_create)
+			{
+				return ctx->isInit() ? ctx : nullptr;
+			}
+		}
+
+		MutexType::Lock lock(&m_mutex);
+		chunk = m_chunks[chunk_index].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new FdCtx[s_chunkSize];
+			m_chunks[chunk_index].store(chunk, std::memory_order_release);
+		}
+		FdCtx* ctx = &chunk[fd & (s_chunkSize - 1)];
+		if (!ctx->isInit())
+		{
+			ctx->init(fd);
+		}
+		return ctx->isInit() ? ctx : nullptr;
+	}
+
+	void FdManager::del(int fd)
+	{
+		FdCtx* ctx = get(fd, false);
+		if (ctx)
+		{
+			MutexType::Lock lock(&m_mutex);
+			ctx->reset();
+		}
+	}
+#pragma endregion FdManager
+}
@@ -0,0 +1,464 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <memory>
+
+#include <dlfcn.h>
+
+#include <include/io/hook.h>
+#include <include/io/fd_manager.h>
+#include <include/io/io_manager.h>
+#include <include/config/config.h>
+#include <include/util.h>
+#include <include/logger/logger.h>
+
+namespace RareVoyager
+{
+	static Logger::ptr g_logger = RAREVOYAGER_LOG_NAME("system");
+
+	static ConfigVar<uint64_t>::ptr g_tcp_connect_timeout =
+			Config::Lookup("tcp.connect.timeout", (uint64_t)5000, "hooked connect timeout in ms");
+
+	static thread_local bool t_hook_enable = false;
+
+	static std::atomic<uint64_t> s_connect_timeout{UINT64_MAX};
+
+#define RAREVOYAGER_HOOK_FUN(XX) \
+	XX(sleep) \
+	XX(usleep) \
+	XX(nanosleep) \
+	XX(socket) \
+	XX(connect) \
+	XX(accept) \
+	XX(read) \
+	XX(readv) \
+	XX(recv) \
+	XX(recvfrom) \
+	XX(write) \
+	XX(writev) \
+	XX(send) \
+	XX(sendto) \
+	XX(close) \
+	XX(fcntl) \
+	XX(setsockopt)
+
+	static void hook_init()
+	{
+		static bool is_inited = false;
+		if (is_inited)
+		{
+			return;
+		}
+		is_inited = true;
+#define XX(name) name ## _f = (name ## _fun)dlsym(RTLD_NEXT, #name);
+		RAREVOYAGER_HOOK_FUN(XX)
+#undef XX
+	}
+
+#pragma region HookIniter
+	struct HookIniter
+	{
+		HookIniter()
+		{
+			hook_init();
+		}
+	};
+
+	// 先于其它静态初始化取得原函数，它们里面可能已经调用了被 hook 的函数
+	static HookIniter __hook_init __attribute__((init_priority(101)));
+
+	struct HookConfigIniter
+	{
+		HookConfigIniter()
+		{
+			s_connect_timeout = g_tcp_connect_timeout->getValue();
+			g_tcp_connect_timeout->addListener([](const uint64_t& old_value, const uint64_t& new_value) {
+				RAREVOYAGER_LOG_INFO(g_logger) << "tcp.connect.timeout " << old_value << " -> " << new_value;
+				s_connect_timeout = new_value;
+			});
+		}
+	};
+
+	static HookConfigIniter __hook_config_init;
+#pragma endregion HookIniter
+
+	bool IsHookEnable()
+	{
+		return t_hook_enable;
+	}
+
+	void SetHookEnable(bool flag)
+	{
+		t_hook_enable = flag;
+	}
+
+	/**
+	 * @brief: 当前在 IOManager 的协程里时返回它，否则(不在 IOManager 的线程上、或在线程的主协程里)返回 nullptr
+	 */
+	static IOManager* hook_io_manager()
+	{
+		IOManager* iom = IOManager::GetThis();
+		if (!iom || Fiber::GetThis().get() == Fiber::GetMainFiber())
+		{
+			return nullptr;
+		}
+		return iom;
+	}
+
+	/**
+	 * @brief: 在协程里睡眠 ms 毫秒，不能挂起时返回 false，由调用者调用原函数
+	 */
+	static bool hook_sleep(uint64_t ms)
+	{
+		IOManager* iom = hook_io_manager();
+		return iom && !iom->asyncSleep(ms);
+	}
+
+	/**
+	 * @brief: 超时定时器与等待的协程共享的状态，定时器触发时写入 errno
+	 */
+	struct TimerInfo
+	{
+		int cancelled = 0;
+	};
+
+	/**
+	 * @brief: 在 fd 上等待 event，timeout_ms 到期时取消等待
+	 * @return 0 事件到达，-1 注册失败或超时(errno 为 timeout_errno)
+	 */
+	static int wait_fd(IOManager* iom, int fd, IOManager::Event event, uint64_t timeout_ms, int timeout_errno)
+	{
+		std::shared_ptr<TimerInfo> tinfo;
+		Timer::ptr timer;
+		if (timeout_ms != UINT64_MAX)
+		{
+			tinfo = std::make_shared<TimerInfo>();
+			std::weak_ptr<TimerInfo> winfo(tinfo);
+			timer = iom->addConditionTimer(timeout_ms, [winfo, fd, iom, event, timeout_errno]() {
+				std::shared_ptr<TimerInfo> t = winfo.lock();
+				if (!t || t->cancelled)
+				{
+					return;
+				}
+				t->cancelled = timeout_errno;
+				iom->cancelEvent(fd, event);
+			}, winfo);
+		}
+		if (iom->addEvent(fd, event))
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "hook addEvent(" << fd << ", " << event << ") failed";
+			if (timer)
+			{
+				timer->cancel();
+			}
+			return -1;
+		}
+		Fiber::YieldToHold();
+		if (timer)
+		{
+			timer->cancel();
+		}
+		if (tinfo && tinfo->cancelled)
+		{
+			errno = tinfo->cancelled;
+			return -1;
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief: 读写类调用的公共流程: 先直接调用，EAGAIN 时在 fd 上等待 event 后重试。
+	 * 超时取 SO_RCVTIMEO/SO_SNDTIMEO，与内核一致超时返回 EAGAIN
+	 */
+	template<typename OriginFun, typename... Args>
+	static ssize_t do_io(int fd, OriginFun fun, IOManager::Event event, int timeout_so, Args... args)
+	{
+		if (!t_hook_enable)
+		{
+			return fun(fd, args...);
+		}
+		FdCtx* ctx = FdMgr::GetInstance()->get(fd);
+		if (!ctx || !ctx->isSocket() || ctx->getUserNonblock())
+		{
+			return fun(fd, args...);
+		}
+		IOManager* iom = hook_io_manager();
+		if (!iom)
+		{
+			return fun(fd, args...);
+		}
+		uint64_t timeout = ctx->getTimeout(timeout_so);
+		while (true)
+		{
+			ssize_t n = fun(fd, args...);
+			while (n == -1 && errno == EINTR)
+			{
+				n = fun(fd, args...);
+			}
+			if (n != -1 || errno != EAGAIN)
+			{
+				return n;
+			}
+			if (wait_fd(iom, fd, event, timeout, EAGAIN))
+			{
+				return -1;
+			}
+			// 等待期间被其它线程关闭
+			if (ctx->isClose())
+			{
+				errno = EBADF;
+				return -1;
+			}
+		}
+	}
+}
+
+extern "C" {
+#define XX(name) name ## _fun name ## _f = nullptr;
+RAREVOYAGER_HOOK_FUN(XX)
+#undef XX
+
+#pragma region sleep
+unsigned int sleep(unsigned int seconds)
+{
+	if (!RareVoyager::t_hook_enable || !RareVoyager::hook_sleep(static_cast<uint64_t>(seconds) * 1000))
+	{
+		return sleep_f(seconds);
+	}
+	return 0;
+}
+
+int usleep(useconds_t usec)
+{
+	if (!RareVoyager::t_hook_enable || !RareVoyager::hook_sleep(usec / 1000))
+	{
+		return usleep_f(usec);
+	}
+	return 0;
+}
+
+int nanosleep(const struct timespec* req, struct timespec* rem)
+{
+	if (!RareVoyager::t_hook_enable || !req
+		|| !RareVoyager::hook_sleep(static_cast<uint64_t>(req->tv_sec) * 1000 + req->tv_nsec / 1000000))
+	{
+		return nanosleep_f(req, rem);
+	}
+	return 0;
+}
+#pragma endregion sleep
+
+#pragma region socket
+int socket(int domain, int type, int protocol)
+{
+	int fd = socket_f(domain, type, protocol);
+	if (!RareVoyager::t_hook_enable || fd < 0)
+	{
+		return fd;
+	}
+	RareVoyager::FdMgr::GetInstance()->get(fd, true);
+	return fd;
+}
+
+int connect_with_timeout(int fd, const struct sockaddr* addr, socklen_t addrlen, uint64_t timeout_ms)
+{
+	if (!RareVoyager::t_hook_enable)
+	{
+		return connect_f(fd, addr, addrlen);
+	}
+	RareVoyager::FdCtx* ctx = RareVoyager::FdMgr::GetInstance()->get(fd);
+	RareVoyager::IOManager* iom = RareVoyager::hook_io_manager();
+	if (!ctx || !ctx->isSocket() || ctx->getUserNonblock() || !iom)
+	{
+		return connect_f(fd, addr, addrlen);
+	}
+	int n = connect_f(fd, addr, addrlen);
+	if (n == 0 || errno != EINPROGRESS)
+	{
+		return n;
+	}
+	if (RareVoyager::wait_fd(iom, fd, RareVoyager::IOManager::WRITE, timeout_ms, ETIMEDOUT))
+	{
+		return -1;
+	}
+	int error = 0;
+	socklen_t len = sizeof(error);
+	if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len))
+	{
+		return -1;
+	}
+	if (error)
+	{
+		errno = error;
+		return -1;
+	}
+	return 0;
+}
+
+int connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
+{
+	return connect_with_timeout(sockfd, addr, addrlen, RareVoyager::s_connect_timeout.load(std::memory_order_relaxed));
+}
+
+int accept(int s, struct sockaddr* addr, socklen_t* addrlen)
+{
+	int fd = static_cast<int>(RareVoyager::do_io(s, accept_f, RareVoyager::IOManager::READ, SO_RCVTIMEO, addr,
+												addrlen));
+	if (fd >= 0 && RareVoyager::t_hook_enable)
+	{
+		RareVoyager::FdMgr::GetInstance()->get(fd, true);
+	}
+	return fd;
+}
+#pragma endregion socket
+
+#pragma region read
+ssize_t read(int fd, void* buf, size_t count)
+{
+	return RareVoyager::do_io(fd, read_f, RareVoyager::IOManager::READ, SO_RCVTIMEO, buf, count);
+}
+
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt)
+{
+	return RareVoyager::do_io(fd, readv_f, RareVoyager::IOManager::READ, SO_RCVTIMEO, iov, iovcnt);
+}
+
+ssize_t recv(int sockfd, void* buf, size_t len, int flags)
+{
+	return RareVoyager::do_io(sockfd, recv_f, RareVoyager::IOManager::READ, SO_RCVTIMEO, buf, len, flags);
+}
+
+ssize_t recvfrom(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen)
+{
+	return RareVoyager::do_io(sockfd, recvfrom_f, RareVoyager::IOManager::READ, SO_RCVTIMEO, buf, len, flags,
+							src_addr, addrlen);
+}
+#pragma endregion read
+
+#pragma region write
+ssize_t write(int fd, const void* buf, size_t count)
+{
+	return RareVoyager::do_io(fd, write_f, RareVoyager::IOManager::WRITE, SO_SNDTIMEO, buf, count);
+}
+
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt)
+{
+	return RareVoyager::do_io(fd, writev_f, RareVoyager::IOManager::WRITE, SO_SNDTIMEO, iov, iovcnt);
+}
+
+ssize_t send(int s, const void* msg, size_t len, int flags)
+{
+	return RareVoyager::do_io(s, send_f, RareVoyager::IOManager::WRITE, SO_SNDTIMEO, msg, len, flags);
+}
+
+ssize_t sendto(int s, const void* msg, size_t len, int flags, const struct sockaddr* to, socklen_t tolen)
+{
+	return RareVoyager::do_io(s, sendto_f, RareVoyager::IOManager::WRITE, SO_SNDTIMEO, msg, len, flags, to, tolen);
+}
+#pragma endregion write
+
+#pragma region fd
+int close(int fd)
+{
+	// 不管当前线程是否开启 hook 都要清掉 fd 的状态，fd 号可能被开启 hook 的线程复用。
+	// 等在 fd 上的协程可能属于别的 IOManager，要在所有 IOManager 上取消。
+	// 先标记关闭再唤醒，醒来的协程据此返回 EBADF，不会在还没真正关闭的 fd 上重新等待
+	RareVoyager::FdCtx* ctx = RareVoyager::FdMgr::GetInstance()->get(fd);
+	if (ctx)
+	{
+		RareVoyager::FdMgr::GetInstance()->del(fd);
+		RareVoyager::IOManager::CancelAllOnClose(fd);
+	}
+	return close_f(fd);
+}
+
+int fcntl(int fd, int cmd, ...)
+{
+	va_list va;
+	va_start(va, cmd);
+	switch (cmd)
+	{
+		case F_SETFL:
+		{
+			int arg = va_arg(va, int);
+			va_end(va);
+			// 记下用户要求的非阻塞，系统层面保持 hook 设置的状态
+			RareVoyager::FdCtx* ctx = RareVoyager::FdMgr::GetInstance()->get(fd);
+			if (ctx && ctx->isSocket())
+			{
+				ctx->setUserNonblock(arg & O_NONBLOCK);
+				arg = ctx->getSysNonblock() ? arg | O_NONBLOCK : arg & ~O_NONBLOCK;
+			}
+			return fcntl_f(fd, cmd, arg);
+		}
+		case F_GETFL:
+		{
+			va_end(va);
+			int arg = fcntl_f(fd, cmd);
+			RareVoyager::FdCtx* ctx = RareVoyager::FdMgr::GetInstance()->get(fd);
+			if (arg == -1 || !ctx || !ctx->isSocket())
+			{
+				return arg;
+			}
+			return ctx->getUserNonblock() ? arg | O_NONBLOCK : arg & ~O_NONBLOCK;
+		}
+		case F_DUPFD:
+		case F_DUPFD_CLOEXEC:
+		case F_SETFD:
+		case F_SETOWN:
+		case F_SETSIG:
+		case F_SETLEASE:
+		case F_NOTIFY:
+#ifdef F_SETPIPE_SZ
+		case F_SETPIPE_SZ:
+#endif
+#ifdef F_ADD_SEALS
+		case F_ADD_SEALS:
+#endif
+		{
+			int arg = va_arg(va, int);
+			va_end(va);
+			return fcntl_f(fd, cmd, arg);
+		}
+		case F_GETFD:
+		case F_GETOWN:
+		case F_GETSIG:
+		case F_GETLEASE:
+#ifdef F_GETPIPE_SZ
+		case F_GETPIPE_SZ:
+#endif
+#ifdef F_GET_SEALS
+		case F_GET_SEALS:
+#endif
+		{
+			va_end(va);
+			return fcntl_f(fd, cmd);
+		}
+		default:
+		{
+			// 其余命令(锁、F_GETOWN_EX 等)的参数都是指针
+			void* arg = va_arg(va, void*);
+			va_end(va);
+			return fcntl_f(fd, cmd, arg);
+		}
+	}
+}
+
+int setsockopt(int sockfd, int level, int optname, const void* optval, socklen_t optlen)
+{
+	if (RareVoyager::t_hook_enable && level == SOL_SOCKET && (optname == SO_RCVTIMEO || optname == SO_SNDTIMEO)
+		&& optval && optlen >= sizeof(timeval))
+	{
+		RareVoyager::FdCtx* ctx = RareVoyager::FdMgr::GetInstance()->get(sockfd);
+		if (ctx)
+		{
+			const timeval* tv = static_cast<const timeval*>(optval);
+			uint64_t ms = static_cast<uint64_t>(tv->tv_sec) * 1000 + tv->tv_usec / 1000;
+			// 与内核一致，0 表示不超时
+			ctx->setTimeout(optname, ms ? ms : UINT64_MAX);
+		}
+	}
+	return setsockopt_f(sockfd, level, optname, optval, optlen);
+}
+#pragma endregion fd
+}
@@ -0,0 +1,1015 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <include/io/io_manager.h>
+#include <include/config/config.h>
+#include <include/util.h>
+#include <include/logger/logger.h>
+
+namespace RareVoyager
+{
+	static Logger::ptr g_logger = RAREVOYAGER_LOG_NAME("system");
+
+	// 没有定时器时 epoll_wait 的最长等待，醒来后重新检查是否可以停止
+	static const uint64_t s_io_max_timeout = 3000;
+	// 一次 epoll_wait 最多取回的事件数
+	static const int s_io_max_events = 256;
+	// fd 上限，RLIMIT_NOFILE 的硬限制更大(或无限)时按这个算
+	static const size_t s_io_max_fds = 1u << 24;
+	// io_uring 的 user_data: eventfd 上的读、不需要处理结果的提交(POLL_REMOVE)，其余是 IoOp 的地址
+	static const uint64_t s_uring_wakeup = 0;
+	static const uint64_t s_uring_ignore = 1;
+
+	static ConfigVar<std::string>::ptr g_io_backend =
+			Config::Lookup("io.backend", std::string("epoll"), "io manager backend, epoll or io_uring");
+
+	static ConfigVar<uint32_t>::ptr g_io_uring_entries =
+			Config::Lookup("io.uring_entries", (uint32_t)4096, "io_uring submission queue entries");
+
+	static ConfigVar<uint32_t>::ptr g_io_poll_interval =
+			Config::Lookup("io.poll_interval", (uint32_t)32,
+			               "busy workers submit queued sqes and poll events once per this many tasks");
+
+	// 本线程距离上次顺带提交、收割执行过的任务数
+	static thread_local uint32_t t_io_tasks = 0;
+
+#pragma region FdContext
+	void IOManager::FdContext::triggerEvent(Event event)
+	{
+		events = static_cast<Event>(events & ~event);
+		EventContext& ctx = getContext(event);
+		if (ctx.cb)
+		{
+			ctx.scheduler->schedule(std::move(ctx.cb));
+			ctx.cb = nullptr;
+		}
+		else
+		{
+			ctx.scheduler->schedule(std::move(ctx.fiber));
+			ctx.fiber = nullptr;
+		}
+		ctx.scheduler = nullptr;
+	}
+#pragma endregion FdContext
+
+#pragma region IOManager
+	/**
+	 * @brief: 存活的 IOManager。fd 可能在任何线程上被关闭，关闭时要在所有 IOManager 上清掉它的事件。
+	 * 故意不释放，静态析构之后仍可能有 close 调用进来
+	 */
+	struct IOManagerRegistry
+	{
+		RWMutex mutex;
+		std::vector<IOManager*> managers;
+	};
+
+	static IOManagerRegistry& GetRegistry()
+	{
+		static IOManagerRegistry* s_registry = new IOManagerRegistry;
+		return *s_registry;
+	}
+
+	IOManager::IOManager(size_t threads, bool use_caller, const std::string& name)
+		: Scheduler(threads, use_caller, name)
+		  , m_pollInterval(g_io_poll_interval->getValue() ? g_io_poll_interval->getValue() : 1)
+	{
+		if (g_io_backend->getValue() == "io_uring")
+		{
+			uint32_t entries = g_io_uring_entries->getValue();
+			// CQ 取 SQ 的 4 倍，POLL_ADD 与 async* 同时在途时不至于溢出
+			int rt = m_uring.init(entries, entries * 4);
+			uint32_t required = IORING_FEAT_EXT_ARG | IORING_FEAT_NODROP;
+			if (!rt && (m_uring.getFeatures() & required) == required)
+			{
+				m_backend = IO_URING;
+			}
+			else
+			{
+				RAREVOYAGER_LOG_WARN(g_logger) << "IOManager " << name << " io_uring unavailable (" << strerror(-rt)
+						<< ", features " << m_uring.getFeatures() << "), fall back to epoll";
+			}
+		}
+
+		if (m_backend == IO_URING)
+		{
+			// io_uring 上的读要阻塞语义，非阻塞的 eventfd 会直接返回 EAGAIN
+			m_eventfd = eventfd(0, EFD_CLOEXEC);
+			if (m_eventfd < 0)
+			{
+				throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+			}
+			armWakeup();
+			flushSqes();
+		}
+		else
+		{
+			m_epfd = epoll_create1(EPOLL_CLOEXEC);
+			if (m_epfd < 0)
+			{
+				throw std::runtime_error(std::string("epoll_create1 failed: ") + strerror(errno));
+			}
+			m_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (m_eventfd < 0)
+			{
+				close(m_epfd);
+				throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+			}
+			// data.ptr 为空表示 eventfd，其它 fd 都指向各自的 FdContext
+			epoll_event ev;
+			memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLIN | EPOLLET;
+			ev.data.ptr = nullptr;
+			if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_eventfd, &ev))
+			{
+				close(m_eventfd);
+				close(m_epfd);
+				throw std::runtime_error(std::string("epoll_ctl eventfd failed: ") + strerror(errno));
+			}
+		}
+
+		rlimit rl;
+		size_t max_fds = s_io_max_fds;
+		if (!getrlimit(RLIMIT_NOFILE, &rl) && rl.rlim_max != RLIM_INFINITY && rl.rlim_max < max_fds)
+		{
+			max_fds = rl.rlim_max;
+		}
+		m_chunkCount = (max_fds + s_fdChunkSize - 1) / s_fdChunkSize;
+		m_chunks.reset(new std::atomic<FdContext*>[m_chunkCount]);
+		for (size_t i = 0; i < m_chunkCount; ++i)
+		{
+			m_chunks[i].store(nullptr, std::memory_order_relaxed);
+		}
+		{
+			IOManagerRegistry& registry = GetRegistry();
+			RWMutex::WriteLock lock(&registry.mutex);
+			registry.managers.push_back(this);
+		}
+
+		start();
+	}
+
+	IOManager::~IOManager()
+	{
+		// 基类析构时虚函数已经不是 IOManager 的版本，必须在这里停止。
+		// 已经 stop 过的不能再 stop: use_caller 时析构可能不在调用线程上，会抛异常
+		if (!isStopping())
+		{
+			stop();
+		}
+		{
+			IOManagerRegistry& registry = GetRegistry();
+			RWMutex::WriteLock lock(&registry.mutex);
+			registry.managers.erase(std::find(registry.managers.begin(), registry.managers.end(), this));
+		}
+		close(m_eventfd);
+		if (m_epfd >= 0)
+		{
+			close(m_epfd);
+		}
+		for (size_t i = 0; i < m_chunkCount; ++i)
+		{
+			delete[] m_chunks[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	IOManager* IOManager::GetThis()
+	{
+		return dynamic_cast<IOManager*>(Scheduler::GetThis());
+	}
+
+	void IOManager::CancelAllOnClose(int fd)
+	{
+		IOManagerRegistry& registry = GetRegistry();
+		RWMutex::ReadLock lock(&registry.mutex);
+		for (IOManager* iom: registry.managers)
+		{
+			iom->cancelAll(fd);
+		}
+	}
+
+	IOManager::FdContext* IOManager::getFdContext(int fd, bool create)
+	{
+		if (fd < 0)
+		{
+			return nullptr;
+		}
+		size_t chunk_index = static_cast<size_t>(fd) >> s_fdChunkBits;
+		if (chunk_index >= m_chunkCount)
+		{
+			return nullptr;
+		}
+		FdContext* chunk = m_chunks[chunk_index].load(std::memory_order_acquire);
+		if (!chunk)
+		{
+			if (!create)
+			{
+				return nullptr;
+			}
+			MutexType::Lock lock(&m_chunkMutex);
+			chunk = m_chunks[chunk_index].load(std::memory_order_relaxed);
+			if (!chunk)
+			{
+				chunk = new FdContext[s_fdChunkSize];
+				for (size_t i = 0; i < s_fdChunkSize; ++i)
+				{
+					chunk[i].fd = static_cast<int>(chunk_index * s_fdChunkSize + i);
+				}
+				m_chunks[chunk_index].store(chunk, std::memory_order_release);
+			}
+		}
+		return &chunk[fd & (s_fdChunkSize - 1)];
+	}
+
+	int IOManager::addEvent(int fd, Event event, std::function<void()> cb)
+	{
+		FdContext* ctx = getFdContext(fd, true);
+		if (!ctx)
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "IOManager::addEvent fd " << fd << " out of range";
+			return -1;
+		}
+		Fiber::ptr fiber;
+		if (!cb)
+		{
+			fiber = Fiber::GetThis();
+			if (fiber.get() == Fiber::GetMainFiber())
+			{
+				RAREVOYAGER_LOG_ERROR(g_logger) << "IOManager::addEvent without callback outside fiber, fd " << fd;
+				return -1;
+			}
+		}
+
+		MutexType::Lock lock(&ctx->mutex);
+		if (ctx->events & event)
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "IOManager::addEvent fd " << fd << " event " << event
+					<< " already registered, events " << ctx->events;
+			return -1;
+		}
+		IoOp* op = nullptr;
+		if (m_backend == IO_URING)
+		{
+			op = new IoOp;
+			op->ctx = ctx;
+			op->event = event;
+			MutexType::Lock sq_lock(&m_sqMutex);
+			// READ/WRITE 与 POLLIN/POLLOUT 取值相同
+			prepareSqe(IORING_OP_POLL_ADD, fd, 0, 0, 0, event, 0, reinterpret_cast<uint64_t>(op));
+		}
+		else
+		{
+			int op_code = ctx->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+			epoll_event ev;
+			memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLET | ctx->events | event;
+			ev.data.ptr = ctx;
+			m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+			if (epoll_ctl(m_epfd, op_code, fd, &ev))
+			{
+				RAREVOYAGER_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", " << op_code << ", " << fd << ", "
+						<< ev.events << "): " << errno << " " << strerror(errno);
+				return -1;
+			}
+		}
+		m_pendingEventCount.fetch_add(1, std::memory_order_relaxed);
+		ctx->events = static_cast<Event>(ctx->events | event);
+		FdContext::EventContext& event_ctx = ctx->getContext(event);
+		event_ctx.scheduler = this;
+		event_ctx.op = op;
+		if (cb)
+		{
+			event_ctx.cb.swap(cb);
+		}
+		else
+		{
+			event_ctx.fiber.swap(fiber);
+		}
+		lock.unlock();
+		if (op)
+		{
+			flushIfExternal();
+		}
+		return 0;
+	}
+
+	bool IOManager::detachEvents(FdContext* ctx, uint32_t events)
+	{
+		if (m_backend == IO_URING)
+		{
+			MutexType::Lock sq_lock(&m_sqMutex);
+			for (Event event: {READ, WRITE})
+			{
+				FdContext::EventContext& event_ctx = ctx->getContext(event);
+				if (!(events & event) || !event_ctx.op)
+				{
+					continue;
+				}
+				// POLL_ADD 的 CQE 之后仍会到达(-ECANCELED 或已经就绪)，那时 op 不再是当前的，只释放不触发。
+				// POLL_REMOVE 还没提交时原来的 op 就完成释放、地址又被新的 POLL_ADD 复用，
+				// 会把新的取消掉并触发一次，等待者重试时会重新 addEvent，只是一次多余的唤醒
+				prepareSqe(IORING_OP_POLL_REMOVE, -1, reinterpret_cast<uint64_t>(event_ctx.op), 0, 0, 0, 0,
+							s_uring_ignore);
+				event_ctx.op = nullptr;
+			}
+			return true;
+		}
+		uint32_t left = ctx->events & ~events;
+		epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLET | left;
+		ev.data.ptr = ctx;
+		m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+		if (epoll_ctl(m_epfd, left ? EPOLL_CTL_MOD : EPOLL_CTL_DEL, ctx->fd, &ev))
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "epoll_ctl fd " << ctx->fd << " remove " << events << ": " << errno
+					<< " " << strerror(errno);
+			return false;
+		}
+		return true;
+	}
+
+	bool IOManager::delEvent(int fd, Event event)
+	{
+		FdContext* ctx = getFdContext(fd, false);
+		if (!ctx)
+		{
+			return false;
+		}
+		MutexType::Lock lock(&ctx->mutex);
+		if (!(ctx->events & event) || !detachEvents(ctx, event))
+		{
+			return false;
+		}
+		m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
+		ctx->events = static_cast<Event>(ctx->events & ~event);
+		FdContext::EventContext& event_ctx = ctx->getContext(event);
+		event_ctx.scheduler = nullptr;
+		event_ctx.fiber = nullptr;
+		event_ctx.cb = nullptr;
+		lock.unlock();
+		flushIfExternal();
+		return true;
+	}
+
+	bool IOManager::cancelEvent(int fd, Event event)
+	{
+		FdContext* ctx = getFdContext(fd, false);
+		if (!ctx)
+		{
+			return false;
+		}
+		MutexType::Lock lock(&ctx->mutex);
+		if (!(ctx->events & event) || !detachEvents(ctx, event))
+		{
+			return false;
+		}
+		ctx->triggerEvent(event);
+		m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
+		lock.unlock();
+		flushIfExternal();
+		return true;
+	}
+
+	bool IOManager::cancelAll(int fd)
+	{
+		FdContext* ctx = getFdContext(fd, false);
+		if (!ctx)
+		{
+			return false;
+		}
+		MutexType::Lock lock(&ctx->mutex);
+		if (!ctx->events || !detachEvents(ctx, ctx->events))
+		{
+			return false;
+		}
+		if (ctx->events & READ)
+		{
+			ctx->triggerEvent(READ);
+			m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+		if (ctx->events & WRITE)
+		{
+			ctx->triggerEvent(WRITE);
+			m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+		lock.unlock();
+		flushIfExternal();
+		return true;
+	}
+
+	void IOManager::handleEvent(FdContext* ctx, uint32_t revents)
+	{
+		MutexType::Lock lock(&ctx->mutex);
+		// 出错或挂断时唤醒所有等待者，让它们自己从 read/write 拿到错误
+		if (revents & (EPOLLERR | EPOLLHUP))
+		{
+			revents |= (EPOLLIN | EPOLLOUT) & ctx->events;
+		}
+		uint32_t real = NONE;
+		if (revents & EPOLLIN)
+		{
+			real |= READ;
+		}
+		if (revents & EPOLLOUT)
+		{
+			real |= WRITE;
+		}
+		real &= ctx->events;
+		if (!real || !detachEvents(ctx, real))
+		{
+			return;
+		}
+		if (real & READ)
+		{
+			ctx->triggerEvent(READ);
+			m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+		if (real & WRITE)
+		{
+			ctx->triggerEvent(WRITE);
+			m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	void IOManager::handleCompletion(uint64_t user_data, int32_t res)
+	{
+		if (user_data == s_uring_wakeup)
+		{
+			armWakeup();
+			return;
+		}
+		if (user_data == s_uring_ignore)
+		{
+			return;
+		}
+		IoOp* op = reinterpret_cast<IoOp*>(user_data);
+		if (!op->ctx)
+		{
+			// async*: 先取出协程再写结果，调度之后 op 所在的协程栈随时可能返回
+			Fiber::ptr fiber = std::move(op->fiber);
+			op->res = res;
+			schedule(std::move(fiber));
+			m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
+			return;
+		}
+		FdContext* ctx = op->ctx;
+		{
+			MutexType::Lock lock(&ctx->mutex);
+			FdContext::EventContext& event_ctx = ctx->getContext(op->event);
+			if (event_ctx.op == op)
+			{
+				event_ctx.op = nullptr;
+				ctx->triggerEvent(op->event);
+				m_pendingEventCount.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+		delete op;
+	}
+
+	void IOManager::tickle(uint32_t worker)
+	{
+		Scheduler::tickle(worker);
+		// 先改唤醒计数再看 poller，和 idle 的"先当 poller 再检查唤醒计数"配对
+		if (m_poller.load(std::memory_order_seq_cst) == static_cast<int>(worker))
+		{
+			uint64_t one = 1;
+			m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+			if (write(m_eventfd, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN)
+			{
+				RAREVOYAGER_LOG_ERROR(g_logger) << "IOManager write eventfd: " << errno << " " << strerror(errno);
+			}
+		}
+	}
+
+	void IOManager::idle(uint32_t worker)
+	{
+		int expected = -1;
+		if (!m_poller.compare_exchange_strong(expected, static_cast<int>(worker), std::memory_order_seq_cst))
+		{
+			// 已经有线程在等 IO，先把本线程攒下的 SQE 交出去，再在 futex 上等
+			if (m_backend == IO_URING)
+			{
+				flushSqes();
+			}
+			Scheduler::idle(worker);
+			return;
+		}
+		if (isTickled(worker))
+		{
+			m_poller.store(-1, std::memory_order_seq_cst);
+			if (m_backend == IO_URING)
+			{
+				flushSqes();
+			}
+			return;
+		}
+		if (m_backend == IO_URING)
+		{
+			idleUring();
+		}
+		else
+		{
+			idleEpoll();
+		}
+	}
+
+	void IOManager::onTaskExecuted(uint32_t worker)
+	{
+		if (++t_io_tasks < m_pollInterval)
+		{
+			return;
+		}
+		t_io_tasks = 0;
+		// 一直有任务可跑的线程不会进 idle: 不在这里提交，本线程协程发起的 IO 永远到不了内核
+		int expected = -1;
+		if (!m_poller.compare_exchange_strong(expected, static_cast<int>(worker), std::memory_order_seq_cst))
+		{
+			// 有线程在等 IO，完成事件由它收，这里只把 SQE 交出去
+			if (m_backend == IO_URING)
+			{
+				flushSqes();
+			}
+			return;
+		}
+		if (m_backend == IO_URING)
+		{
+			idleUring(false);
+		}
+		else
+		{
+			idleEpoll(false);
+		}
+	}
+
+	void IOManager::idleEpoll(bool block)
+	{
+		int timeout = 0;
+		if (block)
+		{
+			uint64_t next = getNextTimer();
+			timeout = static_cast<int>(next < s_io_max_timeout ? next : s_io_max_timeout);
+		}
+		epoll_event events[s_io_max_events];
+		int n;
+		do
+		{
+			m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+			n = epoll_wait(m_epfd, events, s_io_max_events, timeout);
+		} while (n < 0 && errno == EINTR);
+		m_poller.store(-1, std::memory_order_seq_cst);
+
+		std::vector<std::function<void()> > cbs;
+		listExpiredCallbacks(cbs);
+		for (auto& cb: cbs)
+		{
+			schedule(std::move(cb));
+		}
+
+		for (int i = 0; i < n; ++i)
+		{
+			if (!events[i].data.ptr)
+			{
+				uint64_t value;
+				do
+				{
+					m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+				} while (read(m_eventfd, &value, sizeof(value)) == sizeof(value));
+				continue;
+			}
+			handleEvent(static_cast<FdContext*>(events[i].data.ptr), events[i].events);
+		}
+	}
+
+	void IOManager::idleUring(bool block)
+	{
+		if (block)
+		{
+			uint64_t next = getNextTimer();
+			uint64_t timeout = next < s_io_max_timeout ? next : s_io_max_timeout;
+			__kernel_timespec ts;
+			ts.tv_sec = static_cast<int64_t>(timeout / 1000);
+			ts.tv_nsec = static_cast<long long>(timeout % 1000 * 1000000);
+			io_uring_getevents_arg arg;
+			memset(&arg, 0, sizeof(arg));
+			arg.ts = reinterpret_cast<uint64_t>(&ts);
+
+			uint32_t to_submit;
+			{
+				MutexType::Lock lock(&m_sqMutex);
+				to_submit = m_sqPending;
+				m_sqPending = 0;
+			}
+			// 一次系统调用提交攒下的 SQE 并等待至少一个完成
+			m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+			int rt = m_uring.enter(to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+			if (rt < 0 && rt != -ETIME && rt != -EINTR && rt != -EBUSY)
+			{
+				RAREVOYAGER_LOG_ERROR(g_logger) << "io_uring_enter: " << -rt << " " << strerror(-rt);
+			}
+			// 没提交出去的(EINTR 等)留给下一次
+			if (rt < static_cast<int>(to_submit))
+			{
+				MutexType::Lock lock(&m_sqMutex);
+				m_sqPending += to_submit - (rt > 0 ? rt : 0);
+			}
+		}
+		else
+		{
+			// 不等待: 只提交，CQ 环在共享内存里，收割不需要系统调用
+			flushSqes();
+		}
+
+		// CQ 只由 poller 消费，收割完再交出 poller
+		io_uring_cqe cqes[s_io_max_events];
+		size_t n = m_uring.reap(cqes, s_io_max_events);
+		m_poller.store(-1, std::memory_order_seq_cst);
+
+		std::vector<std::function<void()> > cbs;
+		listExpiredCallbacks(cbs);
+		for (auto& cb: cbs)
+		{
+			schedule(std::move(cb));
+		}
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			handleCompletion(cqes[i].user_data, cqes[i].res);
+		}
+	}
+
+	bool IOManager::stopping()
+	{
+		return Scheduler::stopping() && !m_pendingEventCount.load(std::memory_order_acquire) && !hasTimer();
+	}
+
+	void IOManager::onTimerInsertedAtFront()
+	{
+		int poller = m_poller.load(std::memory_order_seq_cst);
+		if (poller >= 0)
+		{
+			tickle(static_cast<uint32_t>(poller));
+		}
+	}
+#pragma endregion IOManager
+
+#pragma region io_uring 提交
+	void IOManager::prepareSqe(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t off,
+								uint32_t op_flags, uint16_t buf_index, uint64_t user_data)
+	{
+		io_uring_sqe* sqe = m_uring.getSqe();
+		while (!sqe)
+		{
+			// SQ 满了，先把已发布的交给内核
+			m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+			int rt = m_uring.enter(m_sqPending, 0, 0);
+			if (rt > 0)
+			{
+				m_sqPending -= rt;
+			}
+			else
+			{
+				sched_yield();
+			}
+			sqe = m_uring.getSqe();
+		}
+		sqe->opcode = opcode;
+		sqe->fd = fd;
+		if (fd >= 0 && static_cast<size_t>(fd) < m_fileSlots.size() && m_fileSlots[fd] >= 0)
+		{
+			sqe->fd = m_fileSlots[fd];
+			sqe->flags |= IOSQE_FIXED_FILE;
+		}
+		sqe->addr = addr;
+		sqe->len = len;
+		sqe->off = off;
+		// rw_flags、poll32_events、accept_flags、timeout_flags 是同一个联合
+		sqe->rw_flags = static_cast<__kernel_rwf_t>(op_flags);
+		sqe->buf_index = buf_index;
+		sqe->user_data = user_data;
+		m_uring.publish();
+		++m_sqPending;
+	}
+
+	void IOManager::flushSqes()
+	{
+		uint32_t to_submit;
+		{
+			MutexType::Lock lock(&m_sqMutex);
+			to_submit = m_sqPending;
+			m_sqPending = 0;
+		}
+		if (!to_submit)
+		{
+			return;
+		}
+		m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+		int rt = m_uring.enter(to_submit, 0, 0);
+		if (rt < static_cast<int>(to_submit))
+		{
+			if (rt < 0 && rt != -EINTR && rt != -EBUSY)
+			{
+				RAREVOYAGER_LOG_ERROR(g_logger) << "io_uring_enter submit: " << -rt << " " << strerror(-rt);
+			}
+			MutexType::Lock lock(&m_sqMutex);
+			m_sqPending += to_submit - (rt > 0 ? rt : 0);
+		}
+	}
+
+	void IOManager::flushIfExternal()
+	{
+		if (m_backend == IO_URING && Scheduler::GetThis() != this)
+		{
+			flushSqes();
+		}
+	}
+
+	void IOManager::armWakeup()
+	{
+		MutexType::Lock lock(&m_sqMutex);
+		prepareSqe(IORING_OP_READ, m_eventfd, reinterpret_cast<uint64_t>(&m_wakeValue), sizeof(m_wakeValue), 0, 0,
+					0, s_uring_wakeup);
+	}
+
+	int32_t IOManager::uringCall(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t off,
+								uint32_t op_flags, uint16_t buf_index)
+	{
+		IoOp op;
+		op.fiber = Fiber::GetThis();
+		if (op.fiber.get() == Fiber::GetMainFiber())
+		{
+			return -EPERM;
+		}
+		m_pendingEventCount.fetch_add(1, std::memory_order_relaxed);
+		{
+			MutexType::Lock lock(&m_sqMutex);
+			prepareSqe(opcode, fd, addr, len, off, op_flags, buf_index, reinterpret_cast<uint64_t>(&op));
+		}
+		flushIfExternal();
+		Fiber::YieldToHold();
+		return op.res;
+	}
+
+	int IOManager::waitEvent(int fd, Event event)
+	{
+		if (addEvent(fd, event))
+		{
+			return -1;
+		}
+		Fiber::YieldToHold();
+		return 0;
+	}
+#pragma endregion io_uring 提交
+
+#pragma region 协程内的异步 IO
+	ssize_t IOManager::asyncRead(int fd, void* buf, size_t len)
+	{
+		return asyncReadFixed(fd, buf, len, -1);
+	}
+
+	ssize_t IOManager::asyncWrite(int fd, const void* buf, size_t len)
+	{
+		return asyncWriteFixed(fd, buf, len, -1);
+	}
+
+	ssize_t IOManager::asyncReadFixed(int fd, void* buf, size_t len, int buf_index)
+	{
+		while (true)
+		{
+			ssize_t n;
+			if (m_backend == IO_URING)
+			{
+				// 偏移 -1 表示从文件当前位置读，对 socket、管道同样适用
+				n = buf_index >= 0
+						? uringCall(IORING_OP_READ_FIXED, fd, reinterpret_cast<uint64_t>(buf), len, (uint64_t)-1, 0,
+									static_cast<uint16_t>(buf_index))
+						: uringCall(IORING_OP_READ, fd, reinterpret_cast<uint64_t>(buf), len, (uint64_t)-1);
+				if (n < 0)
+				{
+					errno = static_cast<int>(-n);
+					n = -1;
+				}
+			}
+			else
+			{
+				m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+				n = read(fd, buf, len);
+			}
+			if (n >= 0 || (errno != EAGAIN && errno != EINTR))
+			{
+				return n;
+			}
+			if (errno == EAGAIN && waitEvent(fd, READ))
+			{
+				return -1;
+			}
+		}
+	}
+
+	ssize_t IOManager::asyncWriteFixed(int fd, const void* buf, size_t len, int buf_index)
+	{
+		while (true)
+		{
+			ssize_t n;
+			if (m_backend == IO_URING)
+			{
+				n = buf_index >= 0
+						? uringCall(IORING_OP_WRITE_FIXED, fd, reinterpret_cast<uint64_t>(buf), len, (uint64_t)-1, 0,
+									static_cast<uint16_t>(buf_index))
+						: uringCall(IORING_OP_WRITE, fd, reinterpret_cast<uint64_t>(buf), len, (uint64_t)-1);
+				if (n < 0)
+				{
+					errno = static_cast<int>(-n);
+					n = -1;
+				}
+			}
+			else
+			{
+				m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+				n = write(fd, buf, len);
+			}
+			if (n >= 0 || (errno != EAGAIN && errno != EINTR))
+			{
+				return n;
+			}
+			if (errno == EAGAIN && waitEvent(fd, WRITE))
+			{
+				return -1;
+			}
+		}
+	}
+
+	int IOManager::asyncAccept(int fd, sockaddr* addr, socklen_t* addrlen, int flags)
+	{
+		while (true)
+		{
+			int rt;
+			if (m_backend == IO_URING)
+			{
+				rt = uringCall(IORING_OP_ACCEPT, fd, reinterpret_cast<uint64_t>(addr), 0,
+								reinterpret_cast<uint64_t>(addrlen), static_cast<uint32_t>(flags));
+				if (rt < 0)
+				{
+					errno = -rt;
+					rt = -1;
+				}
+			}
+			else
+			{
+				m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+				rt = accept4(fd, addr, addrlen, flags);
+			}
+			if (rt >= 0 || (errno != EAGAIN && errno != EINTR))
+			{
+				return rt;
+			}
+			if (errno == EAGAIN && waitEvent(fd, READ))
+			{
+				return -1;
+			}
+		}
+	}
+
+	int IOManager::asyncConnect(int fd, const sockaddr* addr, socklen_t addrlen)
+	{
+		int rt;
+		if (m_backend == IO_URING)
+		{
+			rt = uringCall(IORING_OP_CONNECT, fd, reinterpret_cast<uint64_t>(addr), 0, addrlen);
+			if (rt < 0)
+			{
+				errno = -rt;
+				rt = -1;
+			}
+		}
+		else
+		{
+			m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+			rt = connect(fd, addr, addrlen);
+		}
+		if (rt == 0 || errno != EINPROGRESS)
+		{
+			return rt;
+		}
+		// 非阻塞 socket: 等可写后取连接结果
+		if (waitEvent(fd, WRITE))
+		{
+			return -1;
+		}
+		int error = 0;
+		socklen_t len = sizeof(error);
+		m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+		if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len))
+		{
+			return -1;
+		}
+		if (error)
+		{
+			errno = error;
+			return -1;
+		}
+		return 0;
+	}
+
+	int IOManager::asyncSleep(uint64_t ms)
+	{
+		if (m_backend == IO_URING)
+		{
+			__kernel_timespec ts;
+			ts.tv_sec = static_cast<int64_t>(ms / 1000);
+			ts.tv_nsec = static_cast<long long>(ms % 1000 * 1000000);
+			int32_t rt = uringCall(IORING_OP_TIMEOUT, -1, reinterpret_cast<uint64_t>(&ts), 1, 0);
+			if (rt < 0 && rt != -ETIME)
+			{
+				errno = -rt;
+				return -1;
+			}
+			return 0;
+		}
+		Fiber::ptr fiber = Fiber::GetThis();
+		if (fiber.get() == Fiber::GetMainFiber())
+		{
+			errno = EPERM;
+			return -1;
+		}
+		addTimer(ms, [this, fiber]() { schedule(fiber); });
+		Fiber::YieldToHold();
+		return 0;
+	}
+
+	int IOManager::registerBuffers(const std::vector<iovec>& buffers)
+	{
+		if (m_backend != IO_URING)
+		{
+			return 0;
+		}
+		MutexType::Lock lock(&m_sqMutex);
+		m_syscallCount.fetch_add(2, std::memory_order_relaxed);
+		m_uring.unregisterBuffers();
+		int rt = m_uring.registerBuffers(buffers.data(), static_cast<unsigned>(buffers.size()));
+		if (rt)
+		{
+			errno = -rt;
+			return -1;
+		}
+		return 0;
+	}
+
+	int IOManager::registerFiles(const std::vector<int>& fds)
+	{
+		if (m_backend != IO_URING)
+		{
+			return 0;
+		}
+		MutexType::Lock lock(&m_sqMutex);
+		m_syscallCount.fetch_add(2, std::memory_order_relaxed);
+		m_uring.unregisterFiles();
+		m_fileSlots.clear();
+		int rt = m_uring.registerFiles(fds.data(), static_cast<unsigned>(fds.size()));
+		if (rt)
+		{
+			errno = -rt;
+			return -1;
+		}
+		for (size_t i = 0; i < fds.size(); ++i)
+		{
+			if (fds[i] < 0)
+			{
+				continue;
+			}
+			if (static_cast<size_t>(fds[i]) >= m_fileSlots.size())
+			{
+				m_fileSlots.resize(fds[i] + 1, -1);
+			}
+			m_fileSlots[fds[i]] = static_cast<int>(i);
+		}
+		return 0;
+	}
+
+	int IOManager::unregisterFiles()
+	{
+		if (m_backend != IO_URING)
+		{
+			return 0;
+		}
+		MutexType::Lock lock(&m_sqMutex);
+		m_fileSlots.clear();
+		m_syscallCount.fetch_add(1, std::memory_order_relaxed);
+		int rt = m_uring.unregisterFiles();
+		if (rt)
+		{
+			errno = -rt;
+			return -1;
+		}
+		return 0;
+	}
+#pragma endregion 协程内的异步 IO
+}
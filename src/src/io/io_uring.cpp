@@ -0,0 +1,172 @@
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <include/io/io_uring.h>
+
+namespace RareVoyager
+{
+#pragma region IoUring
+	IoUring::~IoUring()
+	{
+		if (m_sqes)
+		{
+			munmap(m_sqes, m_sqesSize);
+		}
+		if (m_cqRing && m_cqRing != m_sqRing)
+		{
+			munmap(m_cqRing, m_cqRingSize);
+		}
+		if (m_sqRing)
+		{
+			munmap(m_sqRing, m_sqRingSize);
+		}
+		if (m_fd >= 0)
+		{
+			close(m_fd);
+		}
+	}
+
+	int IoUring::init(uint32_t entries, uint32_t cq_entries)
+	{
+		if (m_fd >= 0)
+		{
+			return -EBUSY;
+		}
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		params.flags = IORING_SETUP_CLAMP;
+		if (cq_entries)
+		{
+			params.flags |= IORING_SETUP_CQSIZE;
+			params.cq_entries = cq_entries;
+		}
+		int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+		if (fd < 0)
+		{
+			return -errno;
+		}
+		m_fd = fd;
+		m_features = params.features;
+
+		m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		// 5.4 之后 SQ 与 CQ 环可以一次映射
+		if (m_features & IORING_FEAT_SINGLE_MMAP)
+		{
+			m_sqRingSize = m_cqRingSize = m_sqRingSize > m_cqRingSize ? m_sqRingSize : m_cqRingSize;
+		}
+		void* sq_ring = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+							IORING_OFF_SQ_RING);
+		if (sq_ring == MAP_FAILED)
+		{
+			return -errno;
+		}
+		m_sqRing = sq_ring;
+		if (m_features & IORING_FEAT_SINGLE_MMAP)
+		{
+			m_cqRing = m_sqRing;
+		}
+		else
+		{
+			void* cq_ring = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+								IORING_OFF_CQ_RING);
+			if (cq_ring == MAP_FAILED)
+			{
+				return -errno;
+			}
+			m_cqRing = cq_ring;
+		}
+		m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+						IORING_OFF_SQES);
+		if (sqes == MAP_FAILED)
+		{
+			return -errno;
+		}
+		m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+		char* sq = static_cast<char*>(m_sqRing);
+		m_sqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+		m_sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+		m_sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+		m_sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+		m_sqEntries = params.sq_entries;
+		m_sqeTail = *m_sqTail;
+
+		char* cq = static_cast<char*>(m_cqRing);
+		m_cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+		m_cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+		m_cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+		m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+		return 0;
+	}
+
+	io_uring_sqe* IoUring::getSqe()
+	{
+		uint32_t head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+		if (m_sqeTail - head >= m_sqEntries)
+		{
+			return nullptr;
+		}
+		uint32_t index = m_sqeTail & m_sqMask;
+		io_uring_sqe* sqe = &m_sqes[index];
+		memset(sqe, 0, sizeof(*sqe));
+		m_sqArray[index] = index;
+		++m_sqeTail;
+		return sqe;
+	}
+
+	void IoUring::publish()
+	{
+		__atomic_store_n(m_sqTail, m_sqeTail, __ATOMIC_RELEASE);
+	}
+
+	int IoUring::enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags, const void* arg, size_t arg_size)
+	{
+		int rt = static_cast<int>(syscall(__NR_io_uring_enter, m_fd, to_submit, min_complete, flags, arg, arg_size));
+		return rt < 0 ? -errno : rt;
+	}
+
+	size_t IoUring::reap(io_uring_cqe* cqes, size_t max)
+	{
+		uint32_t head = *m_cqHead;
+		uint32_t tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+		size_t count = 0;
+		while (head != tail && count < max)
+		{
+			cqes[count++] = m_cqes[head & m_cqMask];
+			++head;
+		}
+		__atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+		return count;
+	}
+
+	int IoUring::registerBuffers(const iovec* iovs, unsigned count)
+	{
+		int rt = static_cast<int>(syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, iovs, count));
+		return rt < 0 ? -errno : 0;
+	}
+
+	int IoUring::unregisterBuffers()
+	{
+		int rt = static_cast<int>(syscall(__NR_io_uring_register, m_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0));
+		return rt < 0 ? -errno : 0;
+	}
+
+	int IoUring::registerFiles(const int* fds, unsigned count)
+	{
+		int rt = static_cast<int>(syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_FILES, fds, count));
+		return rt < 0 ? -errno : 0;
+	}
+
+	int IoUring::unregisterFiles()
+	{
+		int rt = static_cast<int>(syscall(__NR_io_uring_register, m_fd, IORING_UNREGISTER_FILES, nullptr, 0));
+		return rt < 0 ? -errno : 0;
+	}
+#pragma endregion IoUring
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdarg>
 #include <functional>
 #include <iostream>
@@ -20,6 +21,7 @@ namespace fs = std::filesystem;
 #endif
 #include <include/logger/logger.h>
 #include <include/config/config.h>
+#include <include/metrics/hdr_histogram.h>
 
 
 namespace RareVoyager
@@ -526,26 +528,27 @@ namespace RareVoyager
 				appender->m_hasFormatter = false;
 			}
 		}
-		m_appenders.emplace_back(appender);
+		m_appenders.update([&appender](std::vector<LogAppender::ptr>& appenders) {
+			appenders.push_back(appender);
+		});
 	}
 
 	void Logger::delAppender(const LogAppender::ptr& appender)
 	{
 		Mutex::Lock lock(&m_mutex);
-		for (auto it = m_appenders.begin(); it != m_appenders.end(); ++it)
-		{
-			if (*it == appender)
+		m_appenders.update([&appender](std::vector<LogAppender::ptr>& appenders) {
+			auto it = std::find(appenders.begin(), appenders.end(), appender);
+			if (it != appenders.end())
 			{
-				m_appenders.erase(it);
-				break;
+				appenders.erase(it);
 			}
-		}
+		});
 	}
 
 	void Logger::clearAppenders()
 	{
 		Mutex::Lock lock(&m_mutex);
-		m_appenders.clear();
+		m_appenders.store(new std::vector<LogAppender::ptr>);
 	}
 
 	void Logger::setFormatter(LogFormatter::ptr val)
@@ -553,7 +556,13 @@ namespace RareVoyager
 		// MutexType::Lock lock(m_mutex);
 		m_formatter = val;
 
-		for (auto& i: m_appenders)
+		RcuReadLock rcu;
+		const std::vector<LogAppender::ptr>* appenders = m_appenders.load();
+		if (!appenders)
+		{
+			return;
+		}
+		for (auto& i: *appenders)
 		{
 			// MutexType::Lock ll(i->m_mutex);
 			if (!i->m_hasFormatter)
@@ -594,8 +603,12 @@ namespace RareVoyager
 			node["formatter"] = m_formatter->getPattern();
 		}
 
-		for(auto& i : m_appenders) {
-			node["appenders"].push_back(YAML::Load(i->toYamlString()));
+		RcuReadLock rcu;
+		const std::vector<LogAppender::ptr>* appenders = m_appenders.load();
+		if(appenders) {
+			for(auto& i : *appenders) {
+				node["appenders"].push_back(YAML::Load(i->toYamlString()));
+			}
 		}
 		std::stringstream ss;
 		ss << node;
@@ -603,6 +616,27 @@ namespace RareVoyager
 	}
 
 
+	/**
+	 * @brief: 取 Logger::log 的耗时直方图。名字已被其它类型的指标占用时返回 nullptr，
+	 * 不再记录耗时。这里正处在 log 的静态初始化里，不能打日志(会重入)，只写一次 stderr
+	 */
+	static LatencyHistogram::ptr LookupLogLatency()
+	{
+		const std::string name = "logger.log.latency_ns";
+		MetricBase::ptr exists = Metrics::LookupBase(name);
+		if (exists)
+		{
+			LatencyHistogram::ptr latency = std::dynamic_pointer_cast<LatencyHistogram>(exists);
+			if (!latency)
+			{
+				std::cerr << "metric " << name << " is registered with another type, log latency disabled"
+						<< std::endl;
+			}
+			return latency;
+		}
+		return Metrics::Lookup<LatencyHistogram>(name, "time spent dispatching one log event to appenders");
+	}
+
 	void Logger::log(LogLevel::Level level, const LogEvent::ptr& event)
 	{
 		// 过滤低级日志
@@ -611,17 +645,27 @@ namespace RareVoyager
 			// shared_from_this() 与当前对象 共享同一个引用计数控制块
 			// 防止自身被多次引用造成的严重错误如 多次delete
 			auto self = shared_from_this();
-			Mutex::Lock lock(&m_mutex);
-			if (!m_appenders.empty())
+			// 记录一次完整输出(格式化 + 写入所有Appender)的耗时
+			static LatencyHistogram::ptr s_latency = LookupLogLatency();
+			uint64_t begin = GetMonotonicNS();
 			{
-				for (auto& i: m_appenders)
+				RcuReadLock rcu;
+				const std::vector<LogAppender::ptr>* appenders = m_appenders.load();
+				if (appenders && !appenders->empty())
+				{
+					for (auto& i: *appenders)
+					{
+						i->log(self, level, event);
+					}
+				}
+				else if (m_root)
 				{
-					i->log(self, level, event);
+					m_root->log(level, event);
 				}
 			}
-			else if (m_root)
+			if (s_latency)
 			{
-				m_root->log(level, event);
+				s_latency->record(GetMonotonicNS() - begin);
 			}
 		}
 	}
@@ -784,24 +828,20 @@ namespace RareVoyager
 
 	Logger::ptr LogManager::getLogger(const std::string& name)
 	{
-		Mutex::Lock lock(&m_mutex);
-		auto it = m_loggers.find(name);
-		// 找到了对应的logger
-		if (it != m_loggers.end())
-		{
-			return it->second;
-		}
-		// 如果没有这个Logger 那么添加一个
-		Logger::ptr logger(new Logger(name));
-		m_loggers[name] = logger;
-		return logger;
+		// 找到了对应的logger直接返回，如果没有这个Logger 那么添加一个
+		return m_loggers.getOrInsert(name, [&name]() { return Logger::ptr(new Logger(name)); });
 	}
 
 	std::string LogManager::toYamlString()
 	{
-		Mutex::Lock lock(&m_mutex);
+		// 按名字排序输出，与原来 std::map 的顺序一致
+		auto loggers = m_loggers.snapshot();
+		std::sort(loggers.begin(), loggers.end(),
+		          [](const std::pair<std::string, Logger::ptr>& a, const std::pair<std::string, Logger::ptr>& b) {
+			          return a.first < b.first;
+		          });
 		YAML::Node node;
-		for (auto& i: m_loggers)
+		for (auto& i: loggers)
 		{
 			node.push_back(YAML::Load(i.second->toYamlString()));
 		}
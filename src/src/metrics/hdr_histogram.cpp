@@ -0,0 +1,340 @@
+#include <cmath>
+#include <sstream>
+
+#include <yaml-cpp/yaml.h>
+#include <include/metrics/hdr_histogram.h>
+
+namespace RareVoyager
+{
+#pragma region HdrHistogram
+	// 序列化格式版本号，放在第一个字节
+	static const uint8_t s_hdr_encoding_version = 1;
+
+	static void WriteVarint(std::string& out, uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+			v >>= 7;
+		}
+		out.push_back(static_cast<char>(v));
+	}
+
+	static bool ReadVarint(const std::string& in, size_t& pos, uint64_t& v)
+	{
+		v = 0;
+		for (uint32_t shift = 0; shift < 64 && pos < in.size(); shift += 7)
+		{
+			uint8_t b = static_cast<uint8_t>(in[pos++]);
+			v |= static_cast<uint64_t>(b & 0x7f) << shift;
+			if (!(b & 0x80))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static uint64_t ZigZagEncode(int64_t v)
+	{
+		return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+	}
+
+	static int64_t ZigZagDecode(uint64_t v)
+	{
+		return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+	}
+
+	HdrHistogram::HdrHistogram(uint32_t precision_bits)
+		: m_precisionBits(precision_bits < 2 ? 2 : (precision_bits > 16 ? 16 : precision_bits))
+	{
+		m_subBucketCount = 1ull << m_precisionBits;
+		m_bucketCount = m_subBucketCount + (64 - m_precisionBits) * (m_subBucketCount >> 1);
+		m_counts.reset(new std::atomic<uint64_t>[m_bucketCount]);
+		reset();
+	}
+
+	HdrHistogram::HdrHistogram(const HdrHistogram& oth)
+		: HdrHistogram(oth.m_precisionBits)
+	{
+		merge(oth);
+	}
+
+	bool HdrHistogram::merge(const HdrHistogram& oth)
+	{
+		if (oth.m_precisionBits != m_precisionBits)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < m_bucketCount; ++i)
+		{
+			uint64_t c = oth.m_counts[i].load(std::memory_order_relaxed);
+			if (c)
+			{
+				m_counts[i].fetch_add(c, std::memory_order_relaxed);
+			}
+		}
+		return true;
+	}
+
+	void HdrHistogram::reset()
+	{
+		for (size_t i = 0; i < m_bucketCount; ++i)
+		{
+			m_counts[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	uint64_t HdrHistogram::lowestEquivalent(size_t index) const
+	{
+		if (index < m_subBucketCount)
+		{
+			return index;
+		}
+		uint64_t half = m_subBucketCount >> 1;
+		uint64_t k = index - m_subBucketCount;
+		uint32_t shift = static_cast<uint32_t>(k / half) + 1;
+		return ((k % half) + half) << shift;
+	}
+
+	uint64_t HdrHistogram::highestEquivalent(size_t index) const
+	{
+		if (index < m_subBucketCount)
+		{
+			return index;
+		}
+		uint64_t half = m_subBucketCount >> 1;
+		uint32_t shift = static_cast<uint32_t>((index - m_subBucketCount) / half) + 1;
+		return lowestEquivalent(index) + ((1ull << shift) - 1);
+	}
+
+	uint64_t HdrHistogram::getCount() const
+	{
+		uint64_t count = 0;
+		for (size_t i = 0; i < m_bucketCount; ++i)
+		{
+			count += m_counts[i].load(std::memory_order_relaxed);
+		}
+		return count;
+	}
+
+	uint64_t HdrHistogram::getMin() const
+	{
+		for (size_t i = 0; i < m_bucketCount; ++i)
+		{
+			if (m_counts[i].load(std::memory_order_relaxed))
+			{
+				return lowestEquivalent(i);
+			}
+		}
+		return 0;
+	}
+
+	uint64_t HdrHistogram::getMax() const
+	{
+		for (size_t i = m_bucketCount; i > 0; --i)
+		{
+			if (m_counts[i - 1].load(std::memory_order_relaxed))
+			{
+				return highestEquivalent(i - 1);
+			}
+		}
+		return 0;
+	}
+
+	double HdrHistogram::getMean() const
+	{
+		double total = 0;
+		uint64_t count = 0;
+		for (size_t i = 0; i < m_bucketCount; ++i)
+		{
+			uint64_t c = m_counts[i].load(std::memory_order_relaxed);
+			if (c)
+			{
+				double mid = (static_cast<double>(lowestEquivalent(i)) + static_cast<double>(highestEquivalent(i))) / 2;
+				total += mid * c;
+				count += c;
+			}
+		}
+		return count ? total / count : 0;
+	}
+
+	uint64_t HdrHistogram::getValueAtPercentile(double percentile) const
+	{
+		// 先快照一份计数，避免遍历过程中并发写入导致前后不一致
+		std::vector<uint64_t> counts(m_bucketCount);
+		uint64_t total = 0;
+		for (size_t i = 0; i < m_bucketCount; ++i)
+		{
+			counts[i] = m_counts[i].load(std::memory_order_relaxed);
+			total += counts[i];
+		}
+		if (!total)
+		{
+			return 0;
+		}
+
+		percentile = percentile < 0 ? 0 : (percentile > 100 ? 100 : percentile);
+		uint64_t target = static_cast<uint64_t>(std::ceil(percentile / 100 * total));
+		target = target ? target : 1;
+
+		uint64_t seen = 0;
+		for (size_t i = 0; i < m_bucketCount; ++i)
+		{
+			seen += counts[i];
+			if (seen >= target)
+			{
+				return highestEquivalent(i);
+			}
+		}
+		return highestEquivalent(m_bucketCount - 1);
+	}
+
+	std::string HdrHistogram::serialize() const
+	{
+		std::string out;
+		out.push_back(static_cast<char>(s_hdr_encoding_version));
+		out.push_back(static_cast<char>(m_precisionBits));
+
+		int64_t zeros = 0;
+		for (size_t i = 0; i < m_bucketCount; ++i)
+		{
+			uint64_t c = m_counts[i].load(std::memory_order_relaxed);
+			if (!c)
+			{
+				++zeros;
+				continue;
+			}
+			if (zeros)
+			{
+				// 负数表示连续 zeros 个空桶
+				WriteVarint(out, ZigZagEncode(-zeros));
+				zeros = 0;
+			}
+			WriteVarint(out, ZigZagEncode(static_cast<int64_t>(c)));
+		}
+		// 末尾的空桶直接省略
+		return out;
+	}
+
+	HdrHistogram::ptr HdrHistogram::Deserialize(const std::string& data)
+	{
+		if (data.size() < 2 || static_cast<uint8_t>(data[0]) != s_hdr_encoding_version)
+		{
+			return nullptr;
+		}
+		uint32_t bits = static_cast<uint8_t>(data[1]);
+		if (bits < 2 || bits > 16)
+		{
+			return nullptr;
+		}
+
+		ptr h(new HdrHistogram(bits));
+		size_t pos = 2;
+		size_t index = 0;
+		while (pos < data.size())
+		{
+			uint64_t raw;
+			if (!ReadVarint(data, pos, raw))
+			{
+				return nullptr;
+			}
+			int64_t v = ZigZagDecode(raw);
+			if (v < 0)
+			{
+				index += static_cast<size_t>(-v);
+				continue;
+			}
+			if (index >= h->m_bucketCount)
+			{
+				return nullptr;
+			}
+			h->m_counts[index++].store(static_cast<uint64_t>(v), std::memory_order_relaxed);
+		}
+		return h;
+	}
+
+	std::string HdrHistogram::toString() const
+	{
+		std::stringstream ss;
+		ss << "count=" << getCount()
+				<< " min=" << getMin()
+				<< " mean=" << getMean()
+				<< " p50=" << getValueAtPercentile(50)
+				<< " p90=" << getValueAtPercentile(90)
+				<< " p99=" << getValueAtPercentile(99)
+				<< " p99.9=" << getValueAtPercentile(99.9)
+				<< " max=" << getMax();
+		return ss.str();
+	}
+#pragma endregion HdrHistogram
+
+#pragma region LatencyHistogram
+	// 导出的分位点
+	static const double s_quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+	LatencyHistogram::LatencyHistogram(const std::string& name, const std::string& description,
+	                                   uint32_t precision_bits)
+		: MetricBase(name, description)
+		  , m_precisionBits(precision_bits)
+	{
+		uint32_t shards = GetMetricShardCount();
+		m_shards.reserve(shards);
+		for (uint32_t i = 0; i < shards; ++i)
+		{
+			m_shards.emplace_back(new HdrHistogram(precision_bits));
+		}
+	}
+
+	HdrHistogram LatencyHistogram::getHistogram() const
+	{
+		HdrHistogram snapshot(m_precisionBits);
+		for (auto& shard: m_shards)
+		{
+			snapshot.merge(*shard);
+		}
+		return snapshot;
+	}
+
+	std::string LatencyHistogram::toYamlString()
+	{
+		HdrHistogram histogram = getHistogram();
+		YAML::Node node;
+		node["name"] = getName();
+		node["type"] = getTypeName();
+		if (!getDescription().empty())
+		{
+			node["description"] = getDescription();
+		}
+		node["count"] = histogram.getCount();
+		node["min"] = histogram.getMin();
+		node["mean"] = histogram.getMean();
+		for (auto q: s_quantiles)
+		{
+			std::stringstream key;
+			key << "p" << q * 100;
+			node[key.str()] = histogram.getValueAtPercentile(q * 100);
+		}
+		node["max"] = histogram.getMax();
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	std::string LatencyHistogram::toPrometheusString()
+	{
+		HdrHistogram histogram = getHistogram();
+		std::string name = prometheusName();
+		std::stringstream ss;
+		ss << prometheusHeader();
+		for (auto q: s_quantiles)
+		{
+			ss << name << "{quantile=\"" << q << "\"} " << histogram.getValueAtPercentile(q * 100) << "\n";
+		}
+		uint64_t count = histogram.getCount();
+		ss << name << "_sum " << static_cast<uint64_t>(histogram.getMean() * count) << "\n";
+		ss << name << "_count " << count << "\n";
+		return ss.str();
+	}
+#pragma endregion LatencyHistogram
+}
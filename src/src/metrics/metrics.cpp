@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <yaml-cpp/yaml.h>
+#include <include/metrics/metrics.h>
+
+namespace RareVoyager
+{
+#pragma region MetricShard
+	uint32_t GetMetricShardCount()
+	{
+		static const uint32_t s_count = [] {
+			uint32_t cpus = std::max(1u, std::thread::hardware_concurrency());
+			uint32_t n = 1;
+			while (n < cpus && n < 64)
+			{
+				n <<= 1;
+			}
+			return n;
+		}();
+		return s_count;
+	}
+
+	uint32_t GetMetricShardIndex()
+	{
+		static std::atomic<uint32_t> s_next{0};
+		// 分片数是2的幂，取模可以用与运算
+		static thread_local uint32_t t_index =
+				s_next.fetch_add(1, std::memory_order_relaxed) & (GetMetricShardCount() - 1);
+		return t_index;
+	}
+#pragma endregion MetricShard
+
+#pragma region MetricBase
+	MetricBase::MetricBase(const std::string& name, const std::string& description)
+		: m_name(name), m_description(description)
+	{
+		std::transform(m_name.begin(), m_name.end(), m_name.begin(), ::tolower);
+	}
+
+	std::string MetricBase::prometheusName() const
+	{
+		std::string name = m_name;
+		std::replace(name.begin(), name.end(), '.', '_');
+		return name;
+	}
+
+	std::string MetricBase::prometheusHeader() const
+	{
+		std::stringstream ss;
+		std::string name = prometheusName();
+		if (!m_description.empty())
+		{
+			ss << "# HELP " << name << " " << m_description << "\n";
+		}
+		ss << "# TYPE " << name << " " << getTypeName() << "\n";
+		return ss.str();
+	}
+#pragma endregion MetricBase
+
+#pragma region Counter
+	Counter::Counter(const std::string& name, const std::string& description)
+		: MetricBase(name, description)
+		  , m_shards(new PaddedAtomic<uint64_t>[GetMetricShardCount()])
+	{
+	}
+
+	uint64_t Counter::getValue() const
+	{
+		uint64_t v = 0;
+		for (uint32_t i = 0; i < GetMetricShardCount(); ++i)
+		{
+			v += m_shards[i].value.load(std::memory_order_relaxed);
+		}
+		return v;
+	}
+
+	std::string Counter::toYamlString()
+	{
+		YAML::Node node;
+		node["name"] = getName();
+		node["type"] = getTypeName();
+		if (!getDescription().empty())
+		{
+			node["description"] = getDescription();
+		}
+		node["value"] = getValue();
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	std::string Counter::toPrometheusString()
+	{
+		std::stringstream ss;
+		ss << prometheusHeader() << prometheusName() << " " << getValue() << "\n";
+		return ss.str();
+	}
+#pragma endregion Counter
+
+#pragma region Gauge
+	Gauge::Gauge(const std::string& name, const std::string& description)
+		: MetricBase(name, description)
+		  , m_shards(new PaddedAtomic<int64_t>[GetMetricShardCount()])
+	{
+	}
+
+	int64_t Gauge::sumShards() const
+	{
+		int64_t v = 0;
+		for (uint32_t i = 0; i < GetMetricShardCount(); ++i)
+		{
+			v += m_shards[i].value.load(std::memory_order_relaxed);
+		}
+		return v;
+	}
+
+	void Gauge::set(int64_t v)
+	{
+		// 分片里的增量保持不动，只调整基准值，使总和等于 v
+		m_base.store(v - sumShards(), std::memory_order_relaxed);
+	}
+
+	int64_t Gauge::getValue() const
+	{
+		return m_base.load(std::memory_order_relaxed) + sumShards();
+	}
+
+	std::string Gauge::toYamlString()
+	{
+		YAML::Node node;
+		node["name"] = getName();
+		node["type"] = getTypeName();
+		if (!getDescription().empty())
+		{
+			node["description"] = getDescription();
+		}
+		node["value"] = getValue();
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	std::string Gauge::toPrometheusString()
+	{
+		std::stringstream ss;
+		ss << prometheusHeader() << prometheusName() << " " << getValue() << "\n";
+		return ss.str();
+	}
+#pragma endregion Gauge
+
+#pragma region Histogram
+	static const size_t s_words_per_line = RAREVOYAGER_CACHELINE_SIZE / sizeof(uint64_t);
+
+	static uint64_t DoubleToBits(double v)
+	{
+		uint64_t bits;
+		memcpy(&bits, &v, sizeof(bits));
+		return bits;
+	}
+
+	static double BitsToDouble(uint64_t bits)
+	{
+		double v;
+		memcpy(&v, &bits, sizeof(v));
+		return v;
+	}
+
+	Histogram::Histogram(const std::string& name, const std::string& description, std::vector<double> bounds)
+		: MetricBase(name, description)
+		  , m_bounds(std::move(bounds))
+	{
+		if (m_bounds.empty())
+		{
+			m_bounds = {0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000};
+		}
+		std::sort(m_bounds.begin(), m_bounds.end());
+		m_bounds.erase(std::unique(m_bounds.begin(), m_bounds.end()), m_bounds.end());
+
+		// 1 个字存总和，bounds.size() + 1 个字存桶计数(含 +Inf)
+		size_t words = m_bounds.size() + 2;
+		m_linesPerShard = (words + s_words_per_line - 1) / s_words_per_line;
+		size_t lines = m_linesPerShard * GetMetricShardCount();
+		m_lines.reset(new CacheLine[lines]);
+		for (size_t i = 0; i < lines; ++i)
+		{
+			for (auto& w: m_lines[i].words)
+			{
+				w.store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	std::atomic<uint64_t>& Histogram::word(uint32_t shard, size_t i) const
+	{
+		size_t pos = shard * m_linesPerShard * s_words_per_line + i;
+		return m_lines[pos / s_words_per_line].words[pos % s_words_per_line];
+	}
+
+	void Histogram::observe(double v)
+	{
+		uint32_t shard = GetMetricShardIndex();
+		size_t bucket = std::lower_bound(m_bounds.begin(), m_bounds.end(), v) - m_bounds.begin();
+		word(shard, bucket + 1).fetch_add(1, std::memory_order_relaxed);
+
+		// 分片基本只被一个线程写，CAS 几乎不会失败
+		auto& sum = word(shard, 0);
+		uint64_t old_bits = sum.load(std::memory_order_relaxed);
+		while (!sum.compare_exchange_weak(old_bits, DoubleToBits(BitsToDouble(old_bits) + v),
+		                                  std::memory_order_relaxed))
+		{
+		}
+	}
+
+	std::vector<uint64_t> Histogram::getBucketCounts() const
+	{
+		std::vector<uint64_t> counts(m_bounds.size() + 1, 0);
+		for (uint32_t s = 0; s < GetMetricShardCount(); ++s)
+		{
+			for (size_t i = 0; i < counts.size(); ++i)
+			{
+				counts[i] += word(s, i + 1).load(std::memory_order_relaxed);
+			}
+		}
+		return counts;
+	}
+
+	uint64_t Histogram::getCount() const
+	{
+		uint64_t count = 0;
+		for (auto c: getBucketCounts())
+		{
+			count += c;
+		}
+		return count;
+	}
+
+	double Histogram::getSum() const
+	{
+		double sum = 0;
+		for (uint32_t s = 0; s < GetMetricShardCount(); ++s)
+		{
+			sum += BitsToDouble(word(s, 0).load(std::memory_order_relaxed));
+		}
+		return sum;
+	}
+
+	std::string Histogram::toYamlString()
+	{
+		auto counts = getBucketCounts();
+		YAML::Node node;
+		node["name"] = getName();
+		node["type"] = getTypeName();
+		if (!getDescription().empty())
+		{
+			node["description"] = getDescription();
+		}
+		uint64_t total = 0;
+		for (size_t i = 0; i < counts.size(); ++i)
+		{
+			total += counts[i];
+			YAML::Node bucket;
+			if (i < m_bounds.size())
+			{
+				bucket["le"] = m_bounds[i];
+			}
+			else
+			{
+				bucket["le"] = "+Inf";
+			}
+			bucket["count"] = total;
+			node["buckets"].push_back(bucket);
+		}
+		node["count"] = total;
+		node["sum"] = getSum();
+		std::stringstream ss;
+		ss << node;
+		return ss.str();
+	}
+
+	std::string Histogram::toPrometheusString()
+	{
+		auto counts = getBucketCounts();
+		std::string name = prometheusName();
+		std::stringstream ss;
+		ss << prometheusHeader();
+		uint64_t total = 0;
+		for (size_t i = 0; i < counts.size(); ++i)
+		{
+			// Prometheus 的桶是累计计数
+			total += counts[i];
+			ss << name << "_bucket{le=\"";
+			if (i < m_bounds.size())
+			{
+				ss << m_bounds[i];
+			}
+			else
+			{
+				ss << "+Inf";
+			}
+			ss << "\"} " << total << "\n";
+		}
+		ss << name << "_sum " << getSum() << "\n";
+		ss << name << "_count " << total << "\n";
+		return ss.str();
+	}
+#pragma endregion Histogram
+
+#pragma region Metrics
+	bool Metrics::IsValidName(const std::string& name)
+	{
+		if (name.empty())
+		{
+			return false;
+		}
+		return name.find_first_not_of("abcdefghijklmnopqrstuvwxyz._0123456789") == std::string::npos;
+	}
+
+	MetricBase::ptr Metrics::LookupBase(const std::string& name)
+	{
+		RWMutexType::ReadLock lock(&GetMutex());
+		auto it = GetDatas().find(name);
+		return it == GetDatas().end() ? nullptr : it->second;
+	}
+
+	std::string Metrics::Scrape(Format format)
+	{
+		// 先复制出指标列表，聚合时不持有注册表的锁
+		std::vector<MetricBase::ptr> metrics;
+		{
+			RWMutexType::ReadLock lock(&GetMutex());
+			metrics.reserve(GetDatas().size());
+			for (auto& [_, _value]: GetDatas())
+			{
+				metrics.push_back(_value);
+			}
+		}
+
+		std::stringstream ss;
+		if (format == FORMAT_PROMETHEUS)
+		{
+			for (auto& i: metrics)
+			{
+				ss << i->toPrometheusString();
+			}
+		}
+		else
+		{
+			YAML::Node node;
+			for (auto& i: metrics)
+			{
+				node.push_back(YAML::Load(i->toYamlString()));
+			}
+			ss << node;
+		}
+		return ss.str();
+	}
+
+	bool Metrics::DumpToFile(const std::string& filename, Format format)
+	{
+		std::string tmp = filename + ".tmp";
+		{
+			std::ofstream ofs(tmp, std::ios::trunc);
+			if (!ofs)
+			{
+				RAREVOYAGER_LOG_ERROR(RAREVOYAGER_LOG_ROOT()) << "Metrics::DumpToFile open " << tmp << " failed";
+				return false;
+			}
+			ofs << Scrape(format);
+		}
+		if (std::rename(tmp.c_str(), filename.c_str()))
+		{
+			RAREVOYAGER_LOG_ERROR(RAREVOYAGER_LOG_ROOT()) << "Metrics::DumpToFile rename " << tmp
+					<< " to " << filename << " failed";
+			return false;
+		}
+		return true;
+	}
+#pragma endregion Metrics
+}
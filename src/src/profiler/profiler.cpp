@@ -0,0 +1,540 @@
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <include/profiler/profiler.h>
+#include <include/config/config.h>
+#include <include/thread/thread.h>
+#include <include/thread/fiber.h>
+#include <include/thread/mutex.h>
+#include <include/util.h>
+
+namespace RareVoyager
+{
+	static Logger::ptr g_logger = RAREVOYAGER_LOG_NAME("system");
+
+	static ConfigVar<bool>::ptr g_profiler_enable =
+			Config::Lookup("profiler.enable", false, "sigprof sampling profiler switch");
+
+	static ConfigVar<uint32_t>::ptr g_profiler_frequency =
+			Config::Lookup("profiler.frequency", (uint32_t)99, "samples per second of thread cpu time");
+
+	static ConfigVar<std::string>::ptr g_profiler_output =
+			Config::Lookup("profiler.output", std::string(""), "write folded stacks to this file on stop");
+
+#pragma region Symbolizer
+	std::string SymbolizeAddress(void* addr)
+	{
+		std::stringstream ss;
+		Dl_info info;
+		if (dladdr(addr, &info))
+		{
+			if (info.dli_sname)
+			{
+				int status = 0;
+				char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+				if (status == 0 && demangled)
+				{
+					ss << demangled;
+				}
+				else
+				{
+					ss << info.dli_sname;
+				}
+				free(demangled);
+				return ss.str();
+			}
+			if (info.dli_fname)
+			{
+				const char* base = strrchr(info.dli_fname, '/');
+				ss << (base ? base + 1 : info.dli_fname) << "+0x" << std::hex
+						<< (reinterpret_cast<uintptr_t>(addr) - reinterpret_cast<uintptr_t>(info.dli_fbase));
+				return ss.str();
+			}
+		}
+		ss << "0x" << std::hex << reinterpret_cast<uintptr_t>(addr);
+		return ss.str();
+	}
+#pragma endregion Symbolizer
+
+#pragma region ProfilerState
+	// 单个样本最多记录的栈深度
+	static const uint32_t s_max_depth = 64;
+	// 环形缓冲区大小，必须是2的幂
+	static const uint64_t s_ring_size = 2048;
+	// 后台聚合间隔
+	static const useconds_t s_drain_interval_us = 50 * 1000;
+
+	struct ProfileSample
+	{
+		// Vyukov 有界队列的序号：等于位置时可写，等于位置+1时可读
+		std::atomic<uint64_t> seq{0};
+		pid_t tid = 0;
+		uint32_t depth = 0;
+		void* pcs[s_max_depth];
+	};
+
+	struct ProfilerThreadInfo
+	{
+		pthread_t thread;
+		timer_t timer;
+		bool armed = false;
+		std::string name;
+	};
+
+	struct ProfilerState
+	{
+		ProfilerState()
+			: ring(new ProfileSample[s_ring_size])
+		{
+			for (uint64_t i = 0; i < s_ring_size; ++i)
+			{
+				ring[i].seq.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		// 保护 threads / names / aggregator
+		Mutex mutex;
+		std::map<pid_t, ProfilerThreadInfo> threads;
+		// 被采样过的线程，包括已经退出的，输出时用。只在开启定时器时记录，不随线程创建增长
+		std::map<pid_t, std::string> names;
+		Thread::ptr aggregator;
+		bool handlerInstalled = false;
+
+		std::atomic<bool> running{false};
+		std::atomic<bool> stopping{false};
+		std::atomic<uint64_t> dropped{0};
+
+		// 生产者(信号处理函数)推进 tail，消费者(聚合)推进 head
+		std::unique_ptr<ProfileSample[]> ring;
+		std::atomic<uint64_t> tail{0};
+
+		// 保护 head / stacks
+		Mutex stacksMutex;
+		uint64_t head = 0;
+		// key 的第一个元素是线程id，之后是从内到外的 pc
+		std::map<std::vector<uintptr_t>, uint64_t> stacks;
+	};
+
+	/**
+	 * @brief: 故意不释放，保证进程退出阶段仍有线程收到信号时状态可用
+	 */
+	static ProfilerState& GetState()
+	{
+		static ProfilerState* s_state = new ProfilerState;
+		return *s_state;
+	}
+
+	// 当前线程的栈范围，RegisterThread 时取得。普通整数，信号处理函数里可以直接读
+	static thread_local uintptr_t t_stack_lo = 0;
+	static thread_local uintptr_t t_stack_hi = 0;
+
+	/**
+	 * @brief: 从被打断处的寄存器沿帧指针回溯，返回深度，pcs[0] 是被打断的指令
+	 * backtrace 会经过 _Unwind_Backtrace/dl_iterate_phdr 拿加载器的锁，信号落在抛异常、dlopen 中途时会自锁，
+	 * 这里只读栈内存: 每一帧都必须落在当前栈(线程栈或协程栈)的 [sp, hi) 内，并且严格向高地址走，
+	 * 遇到没有帧指针的代码(如 libc)回溯会提前结束，不会越界读
+	 */
+	static uint32_t WalkFramePointers(void* ucontext, void** pcs, uint32_t max)
+	{
+		const mcontext_t& mc = static_cast<ucontext_t*>(ucontext)->uc_mcontext;
+#if defined(__x86_64__)
+		uintptr_t pc = static_cast<uintptr_t>(mc.gregs[REG_RIP]);
+		uintptr_t fp = static_cast<uintptr_t>(mc.gregs[REG_RBP]);
+		uintptr_t sp = static_cast<uintptr_t>(mc.gregs[REG_RSP]);
+#elif defined(__aarch64__)
+		uintptr_t pc = static_cast<uintptr_t>(mc.pc);
+		uintptr_t fp = static_cast<uintptr_t>(mc.regs[29]);
+		uintptr_t sp = static_cast<uintptr_t>(mc.sp);
+#else
+		return 0;
+#endif
+		if (!max)
+		{
+			return 0;
+		}
+		pcs[0] = reinterpret_cast<void*>(pc);
+		uint32_t depth = 1;
+
+		uintptr_t lo;
+		uintptr_t hi;
+		if (!Fiber::GetStackRange(lo, hi) || sp < lo || sp >= hi)
+		{
+			lo = t_stack_lo;
+			hi = t_stack_hi;
+		}
+		if (sp < lo || sp >= hi)
+		{
+			// 正在切换协程或在信号栈上，只记录当前指令
+			return depth;
+		}
+		while (depth < max && fp >= sp && fp <= hi - 2 * sizeof(uintptr_t) && fp % sizeof(uintptr_t) == 0)
+		{
+			const uintptr_t* frame = reinterpret_cast<const uintptr_t*>(fp);
+			uintptr_t ret = frame[1];
+			uintptr_t next = frame[0];
+			if (!ret)
+			{
+				break;
+			}
+			pcs[depth++] = reinterpret_cast<void*>(ret);
+			// 栈向低地址增长，调用者的帧一定在更高的地址
+			if (next <= fp)
+			{
+				break;
+			}
+			fp = next;
+		}
+		return depth;
+	}
+
+	static void SigprofHandler(int sig, siginfo_t* info, void* ucontext)
+	{
+		int saved_errno = errno;
+		ProfilerState& st = GetState();
+		if (st.running.load(std::memory_order_relaxed))
+		{
+			uint64_t pos = st.tail.load(std::memory_order_relaxed);
+			while (true)
+			{
+				ProfileSample& s = st.ring[pos & (s_ring_size - 1)];
+				int64_t diff = static_cast<int64_t>(s.seq.load(std::memory_order_acquire) - pos);
+				if (diff == 0)
+				{
+					if (st.tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						s.tid = static_cast<pid_t>(::syscall(SYS_gettid));
+						s.depth = WalkFramePointers(ucontext, s.pcs, s_max_depth);
+						s.seq.store(pos + 1, std::memory_order_release);
+						break;
+					}
+				}
+				else if (diff < 0)
+				{
+					// 缓冲区满，信号处理函数里不能等待，直接丢弃
+					st.dropped.fetch_add(1, std::memory_order_relaxed);
+					break;
+				}
+				else
+				{
+					pos = st.tail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+		errno = saved_errno;
+	}
+
+	/**
+	 * @brief: 把环形缓冲区里已完成的样本合并进 stacks
+	 */
+	static void DrainSamples()
+	{
+		ProfilerState& st = GetState();
+		Mutex::Lock lock(&st.stacksMutex);
+		std::vector<uintptr_t> key;
+		while (true)
+		{
+			ProfileSample& s = st.ring[st.head & (s_ring_size - 1)];
+			if (s.seq.load(std::memory_order_acquire) != st.head + 1)
+			{
+				break;
+			}
+			key.clear();
+			key.push_back(static_cast<uintptr_t>(s.tid));
+			for (uint32_t i = 0; i < s.depth; ++i)
+			{
+				key.push_back(reinterpret_cast<uintptr_t>(s.pcs[i]));
+			}
+			++st.stacks[key];
+			s.seq.store(st.head + s_ring_size, std::memory_order_release);
+			++st.head;
+		}
+	}
+
+	static void AggregateLoop()
+	{
+		ProfilerState& st = GetState();
+		while (!st.stopping.load(std::memory_order_relaxed))
+		{
+			usleep(s_drain_interval_us);
+			DrainSamples();
+		}
+	}
+
+	/**
+	 * @brief: 以目标线程的 CPU 时钟创建定时器，到期时把 SIGPROF 投递给该线程
+	 */
+	static bool ArmTimer(pid_t tid, ProfilerThreadInfo& info)
+	{
+		clockid_t clock_id;
+		if (pthread_getcpuclockid(info.thread, &clock_id))
+		{
+			return false;
+		}
+		struct sigevent sev;
+		memset(&sev, 0, sizeof(sev));
+		sev.sigev_notify = SIGEV_THREAD_ID;
+		sev.sigev_signo = SIGPROF;
+#ifdef sigev_notify_thread_id
+		sev.sigev_notify_thread_id = tid;
+#else
+		sev._sigev_un._tid = tid;
+#endif
+		if (timer_create(clock_id, &sev, &info.timer))
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "Profiler timer_create failed tid = " << tid
+					<< " errno = " << errno << " " << strerror(errno);
+			return false;
+		}
+
+		uint32_t hz = g_profiler_frequency->getValue();
+		hz = hz ? hz : 99;
+		struct itimerspec its;
+		its.it_interval.tv_sec = 0;
+		its.it_interval.tv_nsec = 1000000000L / hz;
+		its.it_value = its.it_interval;
+		if (timer_settime(info.timer, 0, &its, nullptr))
+		{
+			timer_delete(info.timer);
+			return false;
+		}
+		info.armed = true;
+		return true;
+	}
+
+	static void DisarmTimer(ProfilerThreadInfo& info)
+	{
+		if (info.armed)
+		{
+			timer_delete(info.timer);
+			info.armed = false;
+		}
+	}
+#pragma endregion ProfilerState
+
+#pragma region Profiler
+	bool Profiler::Start()
+	{
+		ProfilerState& st = GetState();
+		{
+			Mutex::Lock lock(&st.mutex);
+			if (st.running.load(std::memory_order_relaxed))
+			{
+				return true;
+			}
+			if (!st.handlerInstalled)
+			{
+				struct sigaction sa;
+				memset(&sa, 0, sizeof(sa));
+				sa.sa_sigaction = &SigprofHandler;
+				sa.sa_flags = SA_SIGINFO | SA_RESTART;
+				sigemptyset(&sa.sa_mask);
+				if (sigaction(SIGPROF, &sa, nullptr))
+				{
+					RAREVOYAGER_LOG_ERROR(g_logger) << "Profiler sigaction failed errno = " << errno;
+					return false;
+				}
+				// 之后不再恢复 SIG_DFL，迟到的 SIGPROF 默认会终止进程
+				st.handlerInstalled = true;
+			}
+			st.stopping.store(false, std::memory_order_relaxed);
+			st.running.store(true, std::memory_order_relaxed);
+			for (auto& [_tid, _info]: st.threads)
+			{
+				if (ArmTimer(_tid, _info))
+				{
+					st.names[_tid] = _info.name;
+				}
+			}
+		}
+		// 聚合线程自己也会注册进来，不能持有 mutex 创建
+		Thread::ptr aggregator(new Thread(&AggregateLoop, "profiler"));
+		Mutex::Lock lock(&st.mutex);
+		st.aggregator = aggregator;
+		RAREVOYAGER_LOG_INFO(g_logger) << "Profiler started, threads = " << st.threads.size();
+		return true;
+	}
+
+	void Profiler::Stop()
+	{
+		ProfilerState& st = GetState();
+		Thread::ptr aggregator;
+		{
+			Mutex::Lock lock(&st.mutex);
+			if (!st.running.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+			st.running.store(false, std::memory_order_relaxed);
+			for (auto& [_tid, _info]: st.threads)
+			{
+				DisarmTimer(_info);
+			}
+			aggregator.swap(st.aggregator);
+		}
+		st.stopping.store(true, std::memory_order_relaxed);
+		if (aggregator)
+		{
+			aggregator->join();
+		}
+		DrainSamples();
+		RAREVOYAGER_LOG_INFO(g_logger) << "Profiler stopped, dropped samples = " << GetDroppedSamples();
+
+		std::string output = g_profiler_output->getValue();
+		if (!output.empty())
+		{
+			WriteFoldedStacks(output);
+		}
+	}
+
+	bool Profiler::IsRunning()
+	{
+		return GetState().running.load(std::memory_order_relaxed);
+	}
+
+	void Profiler::RegisterThread()
+	{
+		ProfilerState& st = GetState();
+		pid_t tid = getThreadPid();
+		std::string name = Thread::GetName();
+		pthread_attr_t attr;
+		if (!t_stack_hi && pthread_getattr_np(pthread_self(), &attr) == 0)
+		{
+			void* addr;
+			size_t size;
+			if (pthread_attr_getstack(&attr, &addr, &size) == 0)
+			{
+				t_stack_lo = reinterpret_cast<uintptr_t>(addr);
+				t_stack_hi = t_stack_lo + size;
+			}
+			pthread_attr_destroy(&attr);
+		}
+		Mutex::Lock lock(&st.mutex);
+		auto& info = st.threads[tid];
+		info.thread = pthread_self();
+		info.name.swap(name);
+		if (st.running.load(std::memory_order_relaxed) && !info.armed && ArmTimer(tid, info))
+		{
+			st.names[tid] = info.name;
+		}
+	}
+
+	void Profiler::UnregisterThread()
+	{
+		ProfilerState& st = GetState();
+		pid_t tid = getThreadPid();
+		Mutex::Lock lock(&st.mutex);
+		auto it = st.threads.find(tid);
+		if (it != st.threads.end())
+		{
+			DisarmTimer(it->second);
+			st.threads.erase(it);
+		}
+	}
+
+	std::string Profiler::GetFoldedStacks()
+	{
+		DrainSamples();
+		ProfilerState& st = GetState();
+		std::map<std::vector<uintptr_t>, uint64_t> stacks;
+		{
+			Mutex::Lock lock(&st.stacksMutex);
+			stacks = st.stacks;
+		}
+		std::map<pid_t, std::string> names;
+		{
+			Mutex::Lock lock(&st.mutex);
+			names = st.names;
+		}
+
+		// 同一个地址在很多栈里重复出现，缓存符号化结果
+		std::map<uintptr_t, std::string> symbols;
+		// 不同 pc 符号化后可能得到同一条栈，按文本再合并一次
+		std::map<std::string, uint64_t> folded;
+		for (auto& [_key, _count]: stacks)
+		{
+			auto it = names.find(static_cast<pid_t>(_key[0]));
+			std::string line = it == names.end() ? std::string("UNKNOW") : it->second;
+			// 折叠栈从最外层写到最内层
+			for (size_t i = _key.size() - 1; i >= 1; --i)
+			{
+				// 非叶子帧是返回地址，减一才落在 call 指令所在的函数内
+				uintptr_t pc = _key[i] - (i > 1 ? 1 : 0);
+				auto sit = symbols.find(pc);
+				if (sit == symbols.end())
+				{
+					sit = symbols.emplace(pc, SymbolizeAddress(reinterpret_cast<void*>(pc))).first;
+				}
+				line += ";" + sit->second;
+			}
+			folded[line] += _count;
+		}
+
+		std::stringstream ss;
+		for (auto& [_line, _count]: folded)
+		{
+			ss << _line << " " << _count << "\n";
+		}
+		return ss.str();
+	}
+
+	bool Profiler::WriteFoldedStacks(const std::string& filename)
+	{
+		std::ofstream ofs(filename, std::ios::trunc);
+		if (!ofs)
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "Profiler::WriteFoldedStacks open " << filename << " failed";
+			return false;
+		}
+		ofs << GetFoldedStacks();
+		return static_cast<bool>(ofs);
+	}
+
+	void Profiler::Reset()
+	{
+		DrainSamples();
+		ProfilerState& st = GetState();
+		Mutex::Lock lock(&st.stacksMutex);
+		st.stacks.clear();
+		st.dropped.store(0, std::memory_order_relaxed);
+	}
+
+	uint64_t Profiler::GetDroppedSamples()
+	{
+		return GetState().dropped.load(std::memory_order_relaxed);
+	}
+#pragma endregion Profiler
+
+#pragma region ProfilerIniter
+	struct ProfilerIniter
+	{
+		ProfilerIniter()
+		{
+			g_profiler_enable->addListener([](const bool& old_value, const bool& new_value) {
+				if (new_value)
+				{
+					Profiler::Start();
+				}
+				else
+				{
+					Profiler::Stop();
+				}
+			});
+		}
+	};
+
+	static ProfilerIniter __profiler_init;
+#pragma endregion ProfilerIniter
+}
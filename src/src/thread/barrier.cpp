@@ -0,0 +1,116 @@
+#include <climits>
+
+#include <include/thread/barrier.h>
+#include <include/thread/futex.h>
+#include <include/macro.h>
+
+namespace RareVoyager
+{
+	// 睡眠前自旋检查的次数
+	static const uint32_t s_barrier_spins = 128;
+
+#pragma region Latch
+	Latch::Latch(uint32_t count)
+		: m_count(count)
+	{
+	}
+
+	void Latch::countDown(uint32_t n)
+	{
+		uint32_t prev = m_count.fetch_sub(n, std::memory_order_acq_rel);
+		// 计数归零后等待者随时可能返回并销毁 Latch，之后不能再读成员，
+		// 所以不查有没有等待者，直接唤醒。futex 只把地址当作键，对象已释放也无害
+		if (prev == n)
+		{
+			FutexWake(&m_count, INT_MAX);
+		}
+	}
+
+	void Latch::wait()
+	{
+		for (uint32_t i = 0; i < s_barrier_spins; ++i)
+		{
+			if (tryWait())
+			{
+				return;
+			}
+			RAREVOYAGER_CPU_RELAX();
+		}
+		uint32_t count;
+		while ((count = m_count.load(std::memory_order_acquire)) != 0)
+		{
+			FutexWait(&m_count, count);
+		}
+	}
+
+	bool Latch::waitUntil(const std::chrono::steady_clock::time_point& deadline)
+	{
+		if (tryWait())
+		{
+			return true;
+		}
+		bool ok = true;
+		uint32_t count;
+		while ((count = m_count.load(std::memory_order_acquire)) != 0)
+		{
+			auto now = std::chrono::steady_clock::now();
+			if (now >= deadline)
+			{
+				ok = false;
+				break;
+			}
+			auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+			timespec ts;
+			ts.tv_sec = ns / 1000000000;
+			ts.tv_nsec = ns % 1000000000;
+			FutexWait(&m_count, count, &ts);
+		}
+		return ok;
+	}
+
+	void Latch::arriveAndWait(uint32_t n)
+	{
+		countDown(n);
+		wait();
+	}
+#pragma endregion Latch
+
+#pragma region Barrier
+	Barrier::Barrier(uint32_t count, std::function<void()> on_complete)
+		: m_count(count ? count : 1)
+		  , m_onComplete(std::move(on_complete))
+	{
+	}
+
+	bool Barrier::arriveAndWait()
+	{
+		// 先读代数再到达，保证读到的是本轮的代数
+		uint32_t generation = m_generation.load(std::memory_order_acquire);
+		if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_count)
+		{
+			if (m_onComplete)
+			{
+				m_onComplete();
+			}
+			// 其它线程都在等代数变化，先清零到达数再放行，下一轮的到达不会被算进这一轮
+			m_arrived.store(0, std::memory_order_relaxed);
+			m_generation.fetch_add(1, std::memory_order_release);
+			FutexWake(&m_generation, INT_MAX);
+			return true;
+		}
+		for (uint32_t i = 0; i < s_barrier_spins; ++i)
+		{
+			if (m_generation.load(std::memory_order_acquire) != generation)
+			{
+				return false;
+			}
+			RAREVOYAGER_CPU_RELAX();
+		}
+		while (m_generation.load(std::memory_order_acquire) == generation)
+		{
+			FutexWait(&m_generation, generation);
+		}
+		return false;
+	}
+#pragma endregion Barrier
+}
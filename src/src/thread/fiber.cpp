@@ -0,0 +1,215 @@
+#include <atomic>
+#include <stdexcept>
+
+#include <include/thread/fiber.h>
+#include <include/thread/stack_allocator.h>
+#include <include/util.h>
+#include <include/macro.h>
+#include <include/logger/logger.h>
+
+namespace RareVoyager
+{
+	static Logger::ptr g_logger = RAREVOYAGER_LOG_NAME("system");
+
+	static std::atomic<uint64_t> s_fiber_id{0};
+	static std::atomic<uint64_t> s_fiber_count{0};
+
+	// 当前线程正在执行的协程
+	static thread_local Fiber* t_fiber = nullptr;
+	// 当前线程的主协程
+	static thread_local Fiber::ptr t_threadFiber = nullptr;
+
+	/**
+	 * @brief: 交给 boost::context 的栈分配器，栈由 Fiber 自己管理，上下文结束时不释放
+	 */
+	struct FiberStackKeeper
+	{
+		void deallocate(boost::context::stack_context&)
+		{
+		}
+	};
+
+#pragma region Fiber
+	Fiber::Fiber()
+		: m_id(++s_fiber_id)
+		  , m_state(RUNNING)
+	{
+	}
+
+	Fiber::Fiber(std::function<void()> cb, size_t stack_size)
+		: m_id(++s_fiber_id)
+		  , m_cb(std::move(cb))
+		  , m_stackSize(StackAllocator::RoundUp(stack_size ? stack_size : StackAllocator::GetDefaultStackSize()))
+	{
+		m_stack = StackAllocator::Alloc(m_stackSize);
+		++s_fiber_count;
+		makeContext();
+	}
+
+	Fiber::~Fiber()
+	{
+		if (m_stack)
+		{
+			// 挂起中的协程先展开栈上的对象，再释放栈
+			m_ctx = boost::context::fiber();
+			StackAllocator::Dealloc(m_stack, m_stackSize);
+			--s_fiber_count;
+		}
+		else if (t_fiber == this)
+		{
+			t_fiber = nullptr;
+		}
+	}
+
+	void Fiber::reset(std::function<void()> cb)
+	{
+		if (!m_stack || (m_state != INIT && m_state != TERM && m_state != EXCEPT))
+		{
+			throw std::logic_error("Fiber::reset in state " + std::to_string(m_state));
+		}
+		m_cb = std::move(cb);
+		m_state = INIT;
+		if (!m_ctx)
+		{
+			makeContext();
+		}
+	}
+
+	Fiber::State Fiber::resume()
+	{
+		// 协程 yield 之后、真正切出原来的线程之前，可能已经被别的线程唤醒，等它切出去
+		while (m_switching.exchange(true, std::memory_order_acquire))
+		{
+			RAREVOYAGER_CPU_RELAX();
+		}
+		if (!m_ctx || m_state == RUNNING)
+		{
+			m_switching.store(false, std::memory_order_release);
+			throw std::logic_error("Fiber::resume in state " + std::to_string(m_state));
+		}
+		// 保证线程有主协程，嵌套 resume 时记住切换前的协程
+		GetThis();
+		Fiber* prev = t_fiber;
+		t_fiber = this;
+		m_state = RUNNING;
+		m_ctx = std::move(m_ctx).resume();
+		t_fiber = prev;
+		State state = m_state;
+		m_switching.store(false, std::memory_order_release);
+		return state;
+	}
+
+	void Fiber::yield()
+	{
+		if (t_fiber != this || !m_caller)
+		{
+			throw std::logic_error("Fiber::yield outside fiber " + std::to_string(m_id));
+		}
+		if (m_state == RUNNING)
+		{
+			m_state = HOLD;
+		}
+		m_caller = std::move(m_caller).resume();
+	}
+
+	void Fiber::makeContext()
+	{
+		boost::context::stack_context sctx;
+		sctx.size = m_stackSize;
+		sctx.sp = static_cast<char*>(m_stack) + m_stackSize;
+		// boost 把上下文的控制块放在栈顶，剩下的部分给协程用
+		m_ctx = boost::context::fiber(std::allocator_arg, boost::context::preallocated(sctx.sp, sctx.size, sctx),
+		                              FiberStackKeeper(),
+		                              [this](boost::context::fiber&& caller) { return run(std::move(caller)); });
+	}
+
+	boost::context::fiber Fiber::run(boost::context::fiber&& caller)
+	{
+		m_caller = std::move(caller);
+		try
+		{
+			m_cb();
+			m_state = TERM;
+		}
+		catch (boost::context::detail::forced_unwind&)
+		{
+			// 协程挂起时被析构，交给 boost 展开
+			throw;
+		}
+		catch (std::exception& e)
+		{
+			m_state = EXCEPT;
+			RAREVOYAGER_LOG_ERROR(g_logger) << "Fiber " << m_id << " except: " << e.what();
+		}
+		catch (...)
+		{
+			m_state = EXCEPT;
+			RAREVOYAGER_LOG_ERROR(g_logger) << "Fiber " << m_id << " except";
+		}
+		m_cb = nullptr;
+		return std::move(m_caller);
+	}
+
+	Fiber::ptr Fiber::GetThis()
+	{
+		if (t_fiber)
+		{
+			return t_fiber->shared_from_this();
+		}
+		Fiber::ptr main_fiber(new Fiber);
+		t_threadFiber = main_fiber;
+		t_fiber = main_fiber.get();
+		return main_fiber;
+	}
+
+	bool Fiber::GetStackRange(uintptr_t& lo, uintptr_t& hi)
+	{
+		Fiber* cur = t_fiber;
+		if (!cur || !cur->m_stack)
+		{
+			return false;
+		}
+		lo = reinterpret_cast<uintptr_t>(cur->m_stack);
+		hi = lo + cur->m_stackSize;
+		return true;
+	}
+
+	Fiber* Fiber::GetMainFiber()
+	{
+		return t_threadFiber.get();
+	}
+
+	void Fiber::YieldToReady()
+	{
+		// 挂起期间不持有自己的引用，否则没人引用时也无法释放
+		Fiber* cur = t_fiber;
+		if (!cur)
+		{
+			throw std::logic_error("Fiber::YieldToReady outside fiber");
+		}
+		cur->m_state = READY;
+		cur->yield();
+	}
+
+	void Fiber::YieldToHold()
+	{
+		Fiber* cur = t_fiber;
+		if (!cur)
+		{
+			throw std::logic_error("Fiber::YieldToHold outside fiber");
+		}
+		cur->m_state = HOLD;
+		cur->yield();
+	}
+
+	uint64_t Fiber::TotalFibers()
+	{
+		return s_fiber_count;
+	}
+
+	uint64_t Fiber::GetFiberId()
+	{
+		return t_fiber ? t_fiber->m_id : 0;
+	}
+#pragma endregion Fiber
+}
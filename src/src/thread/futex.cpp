@@ -0,0 +1,28 @@
+#include <cerrno>
+#include <climits>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <include/thread/futex.h>
+
+namespace RareVoyager
+{
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+
+	bool FutexWait(std::atomic<uint32_t>* addr, uint32_t expected, const timespec* timeout)
+	{
+		// 只在进程内使用，用 PRIVATE 版本省掉内核里的跨进程查找
+		long rt = syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, timeout,
+		                  nullptr, 0);
+		return rt == 0 || errno != ETIMEDOUT;
+	}
+
+	int FutexWake(std::atomic<uint32_t>* addr, int count)
+	{
+		long rt = syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE,
+		                  count < 0 ? INT_MAX : count, nullptr, nullptr, 0);
+		return rt < 0 ? 0 : static_cast<int>(rt);
+	}
+}
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#include <execinfo.h>
+
+#include <include/thread/lock_profiler.h>
+#include <include/profiler/profiler.h>
+#include <include/config/config.h>
+
+namespace RareVoyager
+{
+	// 每把锁最多保留的不同调用栈，超出后新栈直接丢弃
+	static const size_t s_max_waiter_stacks = 16;
+	// 抓取的最大栈深
+	static const int s_max_waiter_frames = 32;
+
+#pragma region LockStats
+	LockStats::LockStats(const std::string& name)
+		: m_name(name)
+	{
+	}
+
+	void LockStats::onContended(uint64_t wait_ns)
+	{
+		uint64_t n = m_contended.fetch_add(1, std::memory_order_relaxed) + 1;
+		m_waitTotalNS.fetch_add(wait_ns, std::memory_order_relaxed);
+		UpdateMax(m_waitMaxNS, wait_ns);
+
+		uint32_t rate = LockProfiler::GetStackSampleRate();
+		if (!rate || n % rate)
+		{
+			return;
+		}
+		// 拿到锁之后才抓栈，栈仍然是等待者的栈，但不会拉长等待时间
+		void* frames[s_max_waiter_frames];
+		int depth = backtrace(frames, s_max_waiter_frames);
+		// 跳过 onContended 自身
+		std::vector<void*> stack(frames + (depth > 1 ? 1 : 0), frames + depth);
+
+		Mutex::Lock lock(&m_stackMutex);
+		for (auto& s: m_stacks)
+		{
+			if (s.frames == stack)
+			{
+				s.count += rate;
+				s.waitNS += wait_ns * rate;
+				return;
+			}
+		}
+		if (m_stacks.size() < s_max_waiter_stacks)
+		{
+			WaiterStack s;
+			s.frames.swap(stack);
+			s.count = rate;
+			s.waitNS = wait_ns * rate;
+			m_stacks.push_back(std::move(s));
+		}
+	}
+
+	std::vector<LockStats::WaiterStack> LockStats::getWaiterStacks() const
+	{
+		std::vector<WaiterStack> stacks;
+		{
+			Mutex::Lock lock(&m_stackMutex);
+			stacks = m_stacks;
+		}
+		std::sort(stacks.begin(), stacks.end(), [](const WaiterStack& a, const WaiterStack& b) {
+			return a.waitNS > b.waitNS;
+		});
+		return stacks;
+	}
+
+	void LockStats::reset()
+	{
+		m_acquisitions.store(0, std::memory_order_relaxed);
+		m_contended.store(0, std::memory_order_relaxed);
+		m_waitTotalNS.store(0, std::memory_order_relaxed);
+		m_waitMaxNS.store(0, std::memory_order_relaxed);
+		m_holdTotalNS.store(0, std::memory_order_relaxed);
+		m_holdMaxNS.store(0, std::memory_order_relaxed);
+		Mutex::Lock lock(&m_stackMutex);
+		m_stacks.clear();
+	}
+#pragma endregion LockStats
+
+#pragma region LockProfiler
+	std::atomic<uint32_t> LockProfiler::s_stackSampleRate{16};
+
+	/**
+	 * @brief: 具名锁可能是其它编译单元的全局变量，注册表用函数内静态变量避免初始化顺序问题
+	 */
+	static Mutex& GetStatsMutex()
+	{
+		static Mutex s_mutex;
+		return s_mutex;
+	}
+
+	static std::map<std::string, LockStats::ptr>& GetStats()
+	{
+		static std::map<std::string, LockStats::ptr> s_stats;
+		return s_stats;
+	}
+
+	LockStats::ptr LockProfiler::Register(const std::string& name)
+	{
+		Mutex::Lock lock(&GetStatsMutex());
+		auto& stats = GetStats()[name];
+		if (!stats)
+		{
+			stats.reset(new LockStats(name));
+		}
+		return stats;
+	}
+
+	std::vector<LockStats::ptr> LockProfiler::GetTopContended(size_t n)
+	{
+		std::vector<LockStats::ptr> all;
+		{
+			Mutex::Lock lock(&GetStatsMutex());
+			for (auto& i: GetStats())
+			{
+				all.push_back(i.second);
+			}
+		}
+		std::sort(all.begin(), all.end(), [](const LockStats::ptr& a, const LockStats::ptr& b) {
+			return a->getWaitTotalNS() > b->getWaitTotalNS();
+		});
+		if (all.size() > n)
+		{
+			all.resize(n);
+		}
+		return all;
+	}
+
+	std::string LockProfiler::Report(size_t n, size_t stacks)
+	{
+		std::stringstream ss;
+		ss << std::left << std::setw(32) << "lock"
+				<< std::right << std::setw(14) << "acquisitions"
+				<< std::setw(12) << "contended"
+				<< std::setw(14) << "wait_total_us"
+				<< std::setw(12) << "wait_max_us"
+				<< std::setw(14) << "hold_total_us"
+				<< std::setw(12) << "hold_max_us" << "\n";
+		for (auto& s: GetTopContended(n))
+		{
+			ss << std::left << std::setw(32) << s->getName()
+					<< std::right << std::setw(14) << s->getAcquisitions()
+					<< std::setw(12) << s->getContended()
+					<< std::setw(14) << s->getWaitTotalNS() / 1000
+					<< std::setw(12) << s->getWaitMaxNS() / 1000
+					<< std::setw(14) << s->getHoldTotalNS() / 1000
+					<< std::setw(12) << s->getHoldMaxNS() / 1000 << "\n";
+
+			auto waiters = s->getWaiterStacks();
+			for (size_t i = 0; i < waiters.size() && i < stacks; ++i)
+			{
+				ss << "    ~" << waiters[i].count << " waits, ~" << waiters[i].waitNS / 1000 << "us:";
+				for (auto pc: waiters[i].frames)
+				{
+					ss << "\n        " << SymbolizeAddress(pc);
+				}
+				ss << "\n";
+			}
+		}
+		return ss.str();
+	}
+
+	void LockProfiler::Reset()
+	{
+		Mutex::Lock lock(&GetStatsMutex());
+		for (auto& i: GetStats())
+		{
+			i.second->reset();
+		}
+	}
+
+	void LockProfiler::SetStackSampleRate(uint32_t v)
+	{
+		s_stackSampleRate.store(v, std::memory_order_relaxed);
+	}
+#pragma endregion LockProfiler
+
+#pragma region LockProfilerIniter
+	static ConfigVar<uint32_t>::ptr g_lock_stack_sample_rate =
+			Config::Lookup("lock_profiler.stack_sample_rate", (uint32_t)16,
+			               "capture a waiter stack every N contended acquisitions, 0 disables");
+
+	struct LockProfilerIniter
+	{
+		LockProfilerIniter()
+		{
+			LockProfiler::SetStackSampleRate(g_lock_stack_sample_rate->getValue());
+			g_lock_stack_sample_rate->addListener([](const uint32_t& old_value, const uint32_t& new_value) {
+				LockProfiler::SetStackSampleRate(new_value);
+			});
+		}
+	};
+
+	static LockProfilerIniter __lock_profiler_init;
+#pragma endregion LockProfilerIniter
+}
@@ -1,4 +1,12 @@
+#include <algorithm>
+#include <climits>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+
 #include <include/thread/mutex.h>
+#include <include/thread/futex.h>
 
 namespace RareVoyager
 {
@@ -28,12 +36,172 @@ namespace RareVoyager
 		pthread_rwlock_wrlock(&m_rwlock);
 	}
 
+	bool RWMutex::tryRdlock()
+	{
+		return pthread_rwlock_tryrdlock(&m_rwlock) == 0;
+	}
+
+	bool RWMutex::tryWrlock()
+	{
+		return pthread_rwlock_trywrlock(&m_rwlock) == 0;
+	}
+
 	void RWMutex::unlock()
 	{
 		pthread_rwlock_unlock(&m_rwlock);
 	}
 #pragma endregion RWMutex
 
+#pragma region ShardedRWMutex
+	/**
+	 * @brief: 槽位数取不小于 CPU 核数的 2 的幂，最多 64 个
+	 */
+	static uint32_t GetRWMutexSlotCount()
+	{
+		static uint32_t s_count = []() {
+			uint32_t cpus = std::thread::hardware_concurrency();
+			uint32_t n = 1;
+			while (n < cpus && n < 64)
+			{
+				n <<= 1;
+			}
+			return n;
+		}();
+		return s_count;
+	}
+
+	static std::atomic<uint32_t> s_rw_slot_seed{0};
+	// 线程第一次加读锁时分配，之后固定不变。协程会换线程，解锁用 rdlock 返回的槽位
+	static thread_local uint32_t t_rw_slot = UINT32_MAX;
+
+	ShardedRWMutex::ShardedRWMutex()
+		: m_slotMask(GetRWMutexSlotCount() - 1)
+		  , m_writer(NO_WRITER)
+	{
+		m_slots = new Slot[m_slotMask + 1];
+	}
+
+	ShardedRWMutex::~ShardedRWMutex()
+	{
+		delete[] m_slots;
+	}
+
+	uint32_t ShardedRWMutex::getSlot()
+	{
+		if (RAREVOYAGER_UNLIKELY(t_rw_slot == UINT32_MAX))
+		{
+			t_rw_slot = s_rw_slot_seed.fetch_add(1, std::memory_order_relaxed);
+		}
+		return t_rw_slot & m_slotMask;
+	}
+
+	uint32_t ShardedRWMutex::rdlock()
+	{
+		uint32_t index = getSlot();
+		Slot& slot = m_slots[index];
+		while (true)
+		{
+			// 先登记再检查写标志；写者是先置标志再检查槽位，两边都用 seq_cst 保证至少一方能看到对方
+			slot.readers.fetch_add(1, std::memory_order_seq_cst);
+			if (RAREVOYAGER_LIKELY(m_writer.load(std::memory_order_seq_cst) == NO_WRITER))
+			{
+				return index;
+			}
+			slot.readers.fetch_sub(1, std::memory_order_release);
+
+			uint32_t state = m_writer.load(std::memory_order_relaxed);
+			if (state == WRITER)
+			{
+				m_writer.compare_exchange_strong(state, WRITER_WITH_WAITERS, std::memory_order_relaxed);
+				state = WRITER_WITH_WAITERS;
+			}
+			if (state == WRITER_WITH_WAITERS)
+			{
+				FutexWait(&m_writer, WRITER_WITH_WAITERS);
+			}
+		}
+	}
+
+	bool ShardedRWMutex::tryRdlock(uint32_t* slot)
+	{
+		uint32_t index = getSlot();
+		m_slots[index].readers.fetch_add(1, std::memory_order_seq_cst);
+		if (m_writer.load(std::memory_order_seq_cst) == NO_WRITER)
+		{
+			if (slot)
+			{
+				*slot = index;
+			}
+			return true;
+		}
+		m_slots[index].readers.fetch_sub(1, std::memory_order_release);
+		return false;
+	}
+
+	void ShardedRWMutex::rdunlock(uint32_t slot)
+	{
+		m_slots[slot].readers.fetch_sub(1, std::memory_order_release);
+	}
+
+	void ShardedRWMutex::rdunlock()
+	{
+		rdunlock(getSlot());
+	}
+
+	void ShardedRWMutex::waitReaders()
+	{
+		for (uint32_t i = 0; i <= m_slotMask; ++i)
+		{
+			uint32_t spins = 0;
+			while (m_slots[i].readers.load(std::memory_order_acquire))
+			{
+				if (++spins < 1024)
+				{
+					RAREVOYAGER_CPU_RELAX();
+				}
+				else
+				{
+					sched_yield();
+				}
+			}
+		}
+	}
+
+	void ShardedRWMutex::wrlock()
+	{
+		m_writeMutex.lock();
+		m_writer.store(WRITER, std::memory_order_seq_cst);
+		waitReaders();
+	}
+
+	bool ShardedRWMutex::tryWrlock()
+	{
+		if (!m_writeMutex.tryLock())
+		{
+			return false;
+		}
+		m_writer.store(WRITER, std::memory_order_seq_cst);
+		for (uint32_t i = 0; i <= m_slotMask; ++i)
+		{
+			if (m_slots[i].readers.load(std::memory_order_acquire))
+			{
+				wrunlock();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void ShardedRWMutex::wrunlock()
+	{
+		if (m_writer.exchange(NO_WRITER, std::memory_order_release) == WRITER_WITH_WAITERS)
+		{
+			FutexWake(&m_writer, INT_MAX);
+		}
+		m_writeMutex.unlock();
+	}
+#pragma endregion ShardedRWMutex
+
 #pragma region Mutex
 	Mutex::Mutex()
 	{
@@ -50,6 +218,11 @@ namespace RareVoyager
 		pthread_mutex_lock(&m_mutex);
 	}
 
+	bool Mutex::tryLock()
+	{
+		return pthread_mutex_trylock(&m_mutex) == 0;
+	}
+
 	void Mutex::unlock()
 	{
 		pthread_mutex_unlock(&m_mutex);
@@ -71,6 +244,11 @@ namespace RareVoyager
 	{
 		pthread_spin_lock(&m_spinlock);
 	}
+	bool Spinlock::tryLock()
+	{
+		return pthread_spin_trylock(&m_spinlock) == 0;
+	}
+
 	void Spinlock::unlock()
 	{
 		pthread_spin_unlock(&m_spinlock);
@@ -78,24 +256,235 @@ namespace RareVoyager
 #pragma endregion Spinlock
 
 #pragma region CASLock
+	// 自旋轮数的上限，和每轮 pause 次数的上限
+	static const uint32_t s_caslock_max_spins = 100;
+	static const uint32_t s_caslock_max_backoff = 64;
+
 	CASLock::CASLock()
+		: m_state(UNLOCKED)
+		  , m_spins(0)
 	{
-		m_locked.clear();
 	}
 
 	CASLock::~CASLock()
 	{
 	}
 
-	void CASLock::lock()
+	void CASLock::lockSlow()
 	{
-		while (std::atomic_flag_test_and_set_explicit(&m_locked, std::memory_order_acquire));
+		uint32_t estimate = m_spins.load(std::memory_order_relaxed);
+		uint32_t limit = std::min(estimate * 2 + 10, s_caslock_max_spins);
+		uint32_t backoff = 1;
+		for (uint32_t i = 0; i < limit; ++i)
+		{
+			// 只读等待，锁看起来空闲时才去抢，避免一直独占缓存行
+			if (m_state.load(std::memory_order_relaxed) == UNLOCKED && tryLock())
+			{
+				m_spins.store(estimate + (static_cast<int32_t>(i - estimate) / 8), std::memory_order_relaxed);
+				return;
+			}
+			for (uint32_t j = 0; j < backoff; ++j)
+			{
+				RAREVOYAGER_CPU_RELAX();
+			}
+			backoff = std::min(backoff * 2, s_caslock_max_backoff);
+		}
+		m_spins.store(estimate + (static_cast<int32_t>(limit - estimate) / 8), std::memory_order_relaxed);
+
+		// 标记为 PARKED 后睡眠；醒来后仍以 PARKED 抢锁，保证自己解锁时会唤醒后面的线程
+		while (m_state.exchange(PARKED, std::memory_order_acquire) != UNLOCKED)
+		{
+			FutexWait(&m_state, PARKED);
+		}
 	}
 
-	void CASLock::unlock()
+	void CASLock::wake()
 	{
-		std::atomic_flag_clear_explicit(&m_locked, std::memory_order_release);
+		FutexWake(&m_state, 1);
 	}
 #pragma endregion CASLock
 
+#pragma region TicketLock
+	// 在让出 CPU 前最多等待的 pause 次数
+	static const uint32_t s_fairlock_spin_budget = 4096;
+
+	TicketLock::TicketLock()
+		: m_next(0)
+		  , m_serving(0)
+	{
+	}
+
+	void TicketLock::lock()
+	{
+		uint32_t ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+		uint32_t budget = s_fairlock_spin_budget;
+		while (true)
+		{
+			uint32_t serving = m_serving.load(std::memory_order_acquire);
+			if (serving == ticket)
+			{
+				return;
+			}
+			// 前面排了几个人就多等几轮
+			uint32_t pauses = (ticket - serving) * 16;
+			if (pauses <= budget)
+			{
+				budget -= pauses;
+				for (uint32_t i = 0; i < pauses; ++i)
+				{
+					RAREVOYAGER_CPU_RELAX();
+				}
+			}
+			else
+			{
+				sched_yield();
+			}
+		}
+	}
+
+	bool TicketLock::tryLock()
+	{
+		uint32_t serving = m_serving.load(std::memory_order_acquire);
+		return m_next.compare_exchange_strong(serving, serving + 1, std::memory_order_acquire,
+		                                      std::memory_order_relaxed);
+	}
+#pragma endregion TicketLock
+
+#pragma region MCSLock
+	/**
+	 * @brief: lock()/unlock() 用的线程私有节点池。一个线程可能同时持有多把 MCSLock，
+	 * 所以是一个栈而不是单个节点；线程退出时释放
+	 */
+	struct MCSNodePool
+	{
+		~MCSNodePool()
+		{
+			for (auto node: nodes)
+			{
+				delete node;
+			}
+		}
+
+		MCSLock::Node* acquire()
+		{
+			if (nodes.empty())
+			{
+				return new MCSLock::Node;
+			}
+			MCSLock::Node* node = nodes.back();
+			nodes.pop_back();
+			return node;
+		}
+
+		void release(MCSLock::Node* node)
+		{
+			nodes.push_back(node);
+		}
+
+		std::vector<MCSLock::Node*> nodes;
+	};
+
+	static thread_local MCSNodePool t_mcs_node_pool;
+
+	MCSLock::MCSLock()
+		: m_tail(nullptr)
+		  , m_owner(nullptr)
+	{
+	}
+
+	void MCSLock::lock(Node* node)
+	{
+		node->next.store(nullptr, std::memory_order_relaxed);
+		node->state.store(WAITING, std::memory_order_relaxed);
+		Node* prev = m_tail.exchange(node, std::memory_order_acq_rel);
+		if (!prev)
+		{
+			return;
+		}
+		prev->next.store(node, std::memory_order_release);
+
+		for (uint32_t i = 0; i < s_fairlock_spin_budget; ++i)
+		{
+			if (node->state.load(std::memory_order_acquire) == GRANTED)
+			{
+				return;
+			}
+			RAREVOYAGER_CPU_RELAX();
+		}
+		uint32_t expected = WAITING;
+		if (node->state.compare_exchange_strong(expected, PARKED, std::memory_order_acquire))
+		{
+			while (node->state.load(std::memory_order_acquire) != GRANTED)
+			{
+				FutexWait(&node->state, PARKED);
+			}
+		}
+	}
+
+	bool MCSLock::tryLock(Node* node)
+	{
+		node->next.store(nullptr, std::memory_order_relaxed);
+		node->state.store(WAITING, std::memory_order_relaxed);
+		Node* expected = nullptr;
+		return m_tail.compare_exchange_strong(expected, node, std::memory_order_acquire,
+		                                      std::memory_order_relaxed);
+	}
+
+	void MCSLock::unlock(Node* node)
+	{
+		Node* next = node->next.load(std::memory_order_acquire);
+		if (!next)
+		{
+			Node* expected = node;
+			if (m_tail.compare_exchange_strong(expected, nullptr, std::memory_order_release,
+			                                   std::memory_order_relaxed))
+			{
+				return;
+			}
+			// 已经有人入队，但还没来得及把自己挂到 node->next 上
+			while (!(next = node->next.load(std::memory_order_acquire)))
+			{
+				RAREVOYAGER_CPU_RELAX();
+			}
+		}
+		Grant(next);
+	}
+
+	void MCSLock::Grant(Node* node)
+	{
+		if (node->state.exchange(GRANTED, std::memory_order_release) == PARKED)
+		{
+			// 唤醒前节点可能已被对方复用(对方被虚假唤醒后看到了 GRANTED)，
+			// 最坏情况是多一次虚假唤醒，对方会循环检查状态
+			FutexWake(&node->state, 1);
+		}
+	}
+
+	void MCSLock::lock()
+	{
+		Node* node = t_mcs_node_pool.acquire();
+		lock(node);
+		m_owner = node;
+	}
+
+	bool MCSLock::tryLock()
+	{
+		Node* node = t_mcs_node_pool.acquire();
+		if (tryLock(node))
+		{
+			m_owner = node;
+			return true;
+		}
+		t_mcs_node_pool.release(node);
+		return false;
+	}
+
+	void MCSLock::unlock()
+	{
+		Node* node = m_owner;
+		unlock(node);
+		t_mcs_node_pool.release(node);
+	}
+#pragma endregion MCSLock
+
 }
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <include/thread/rcu.h>
+
+namespace RareVoyager
+{
+	// 与 <linux/membarrier.h> 一致，老内核头文件里可能没有
+	static const int s_membarrier_cmd_global = 1 << 0;
+	static const int s_membarrier_cmd_private_expedited = 1 << 3;
+	static const int s_membarrier_cmd_register_private_expedited = 1 << 4;
+
+	// 待释放对象超过这个数时 DeferFree 顺带回收一次
+	static const size_t s_reclaim_threshold = 64;
+
+	struct RcuDeferred
+	{
+		uint64_t epoch;
+		std::function<void()> deleter;
+	};
+
+	/**
+	 * @brief: 读者登记表与待释放表。进程退出时不析构，线程局部变量的析构可能更晚
+	 * 记录用 shared_ptr 持有: Synchronize 在锁外等待读者时，线程注销也不会把它拿着的记录释放掉
+	 */
+	struct RcuState
+	{
+		Mutex recordsMutex;
+		std::vector<std::shared_ptr<Rcu::Record> > records;
+		Mutex deferredMutex;
+		std::vector<RcuDeferred> deferred;
+	};
+
+	static RcuState& GetState()
+	{
+		static RcuState* s_state = new RcuState;
+		return *s_state;
+	}
+
+	static std::once_flag s_init_flag;
+
+	/**
+	 * @brief: 线程退出时注销
+	 */
+	struct RcuThreadExit
+	{
+		~RcuThreadExit()
+		{
+			Rcu::UnregisterThread();
+		}
+	};
+
+	static thread_local RcuThreadExit t_thread_exit;
+
+#pragma region Rcu
+	static void RcuInit(std::atomic<bool>& membarrier)
+	{
+#ifdef SYS_membarrier
+		if (syscall(SYS_membarrier, s_membarrier_cmd_register_private_expedited, 0, 0) == 0)
+		{
+			membarrier.store(true, std::memory_order_relaxed);
+		}
+#endif
+	}
+
+	Rcu::Record* Rcu::RegisterThread()
+	{
+		// 读者与写者都先经过这里，保证两边看到的 s_membarrier 一致
+		std::call_once(s_init_flag, RcuInit, std::ref(s_membarrier));
+		if (t_record)
+		{
+			return t_record;
+		}
+		std::shared_ptr<Record> r(new Record);
+		{
+			RcuState& state = GetState();
+			Mutex::Lock lock(&state.recordsMutex);
+			state.records.push_back(r);
+		}
+		// 取一次地址，让线程退出时的析构函数生效
+		(void) &t_thread_exit;
+		t_record = r.get();
+		return t_record;
+	}
+
+	void Rcu::UnregisterThread()
+	{
+		Record* r = t_record;
+		if (!r)
+		{
+			return;
+		}
+		t_record = nullptr;
+		RcuState& state = GetState();
+		Mutex::Lock lock(&state.recordsMutex);
+		auto it = std::find_if(state.records.begin(), state.records.end(),
+		                       [r](const std::shared_ptr<Record>& p) { return p.get() == r; });
+		if (it != state.records.end())
+		{
+			state.records.erase(it);
+		}
+	}
+
+	void Rcu::Fence()
+	{
+		std::call_once(s_init_flag, RcuInit, std::ref(s_membarrier));
+		if (s_membarrier.load(std::memory_order_relaxed))
+		{
+#ifdef SYS_membarrier
+			// 快速版本失败时退回到全局版本，慢但同样能替读者执行屏障
+			if (syscall(SYS_membarrier, s_membarrier_cmd_private_expedited, 0, 0) == 0
+				|| syscall(SYS_membarrier, s_membarrier_cmd_global, 0, 0) == 0)
+			{
+				return;
+			}
+#endif
+			// 读者已经省掉了屏障，写者这边补不上就无法保证正确性，只能终止。
+			// 这里可能在 Logger 的 DeferFree 里，不能再打日志
+			std::cerr << "Rcu::Fence membarrier failed, errno = " << errno << std::endl;
+			std::abort();
+		}
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	uint64_t Rcu::MinActiveEpoch()
+	{
+		uint64_t min = UINT64_MAX;
+		RcuState& state = GetState();
+		Mutex::Lock lock(&state.recordsMutex);
+		for (auto& r: state.records)
+		{
+			uint64_t e = r->epoch.load(std::memory_order_acquire);
+			if (e && e < min)
+			{
+				min = e;
+			}
+		}
+		return min;
+	}
+
+	void Rcu::Synchronize()
+	{
+		if (InReadSection())
+		{
+			throw std::logic_error("Rcu::Synchronize inside read section");
+		}
+		uint64_t epoch = s_epoch.fetch_add(1, std::memory_order_seq_cst);
+		Fence();
+		// 在锁外等读者，等待期间其它线程照常登记、注销。之后登记的读者 epoch 一定比 epoch 新
+		std::vector<std::shared_ptr<Record> > records;
+		{
+			RcuState& state = GetState();
+			Mutex::Lock lock(&state.recordsMutex);
+			records = state.records;
+		}
+		for (auto& r: records)
+		{
+			while (true)
+			{
+				uint64_t e = r->epoch.load(std::memory_order_acquire);
+				if (!e || e > epoch)
+				{
+					break;
+				}
+				sched_yield();
+			}
+		}
+		Reclaim();
+	}
+
+	void Rcu::DeferFree(std::function<void()> deleter)
+	{
+		// 摘下之后才取 epoch，之后进入临界区的读者 epoch 一定更大
+		uint64_t epoch = s_epoch.fetch_add(1, std::memory_order_seq_cst);
+		size_t pending;
+		{
+			RcuState& state = GetState();
+			Mutex::Lock lock(&state.deferredMutex);
+			state.deferred.push_back(RcuDeferred{epoch, std::move(deleter)});
+			pending = state.deferred.size();
+		}
+		if (pending >= s_reclaim_threshold)
+		{
+			Reclaim();
+		}
+	}
+
+	size_t Rcu::Reclaim()
+	{
+		RcuState& state = GetState();
+		{
+			Mutex::Lock lock(&state.deferredMutex);
+			if (state.deferred.empty())
+			{
+				return 0;
+			}
+		}
+		Fence();
+		uint64_t min = MinActiveEpoch();
+		std::vector<RcuDeferred> ready;
+		{
+			Mutex::Lock lock(&state.deferredMutex);
+			auto it = std::partition(state.deferred.begin(), state.deferred.end(),
+			                         [min](const RcuDeferred& d) { return d.epoch >= min; });
+			std::move(it, state.deferred.end(), std::back_inserter(ready));
+			state.deferred.erase(it, state.deferred.end());
+		}
+		// 在锁外释放，析构函数里还可以再 DeferFree
+		for (auto& d: ready)
+		{
+			d.deleter();
+		}
+		return ready.size();
+	}
+
+	void Rcu::Barrier()
+	{
+		Synchronize();
+		while (GetPendingCount() && Reclaim())
+		{
+		}
+	}
+
+	size_t Rcu::GetPendingCount()
+	{
+		RcuState& state = GetState();
+		Mutex::Lock lock(&state.deferredMutex);
+		return state.deferred.size();
+	}
+	bool Rcu::UseMembarrier()
+	{
+		std::call_once(s_init_flag, RcuInit, std::ref(s_membarrier));
+		return s_membarrier.load(std::memory_order_relaxed);
+	}
+#pragma endregion Rcu
+}
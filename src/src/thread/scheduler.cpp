@@ -0,0 +1,530 @@
+#include <climits>
+#include <sstream>
+#include <stdexcept>
+
+#include <include/thread/scheduler.h>
+#include <include/thread/futex.h>
+#include <include/io/hook.h>
+#include <include/util.h>
+#include <include/logger/logger.h>
+
+namespace RareVoyager
+{
+	static Logger::ptr g_logger = RAREVOYAGER_LOG_NAME("system");
+
+	// 进入 idle 前自旋找任务的轮数
+	static const uint32_t s_scheduler_spins = 64;
+	// 一次从 inbox 转移的最大任务数
+	static const uint32_t s_inbox_batch = 64;
+
+	static thread_local Scheduler* t_scheduler = nullptr;
+	static thread_local int t_worker = -1;
+	static thread_local uint32_t t_steal_seed = 0;
+
+	/**
+	 * @brief: xorshift 随机数，选择窃取对象
+	 */
+	static uint32_t NextRandom()
+	{
+		uint32_t x = t_steal_seed;
+		if (RAREVOYAGER_UNLIKELY(!x))
+		{
+			x = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&t_steal_seed) >> 4) | 1;
+		}
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		t_steal_seed = x;
+		return x;
+	}
+
+#pragma region Scheduler
+	Scheduler::Scheduler(size_t threads, bool use_caller, const std::string& name)
+		: m_name(name)
+		  , m_useCaller(use_caller)
+		  , m_threads(name)
+	{
+		threads = threads ? threads : 1;
+		for (size_t i = 0; i < threads; ++i)
+		{
+			m_workers.emplace_back(new Worker);
+		}
+		if (use_caller)
+		{
+			if (t_scheduler)
+			{
+				throw std::logic_error("Scheduler " + name + ": caller thread already belongs to a scheduler");
+			}
+			Fiber::GetThis();
+			t_scheduler = this;
+			t_worker = 0;
+		}
+	}
+
+	Scheduler::~Scheduler()
+	{
+		if (!m_stopping.load(std::memory_order_acquire))
+		{
+			stop();
+		}
+		if (t_scheduler == this)
+		{
+			t_scheduler = nullptr;
+			t_worker = -1;
+		}
+		// 停止后才投递的任务没有人执行了，直接释放
+		size_t dropped = 0;
+		for (auto& w: m_workers)
+		{
+			Task* task;
+			while ((task = w->local.steal()) || w->inbox.tryPop(task))
+			{
+				delete task;
+				++dropped;
+			}
+			for (auto t: w->pinned)
+			{
+				delete t;
+				++dropped;
+			}
+			for (auto t: w->overflow)
+			{
+				delete t;
+				++dropped;
+			}
+		}
+		if (dropped)
+		{
+			RAREVOYAGER_LOG_WARN(g_logger) << "Scheduler " << m_name << " destroyed with " << dropped
+					<< " pending tasks";
+		}
+	}
+
+	Scheduler* Scheduler::GetThis()
+	{
+		return t_scheduler;
+	}
+
+	int Scheduler::GetWorkerIndex()
+	{
+		return t_worker;
+	}
+
+	void Scheduler::start()
+	{
+		if (m_started)
+		{
+			return;
+		}
+		m_started = true;
+		size_t first = m_useCaller ? 1 : 0;
+		if (m_workers.size() > first)
+		{
+			m_threads.start(m_workers.size() - first,
+			                [this, first](size_t i) { run(static_cast<uint32_t>(i + first)); });
+		}
+	}
+
+	void Scheduler::stop()
+	{
+		if (m_useCaller && t_scheduler != this)
+		{
+			throw std::logic_error("Scheduler " + m_name + ": stop must be called on the caller thread");
+		}
+		start();
+		m_stopping.store(true, std::memory_order_release);
+		tickleAll();
+		if (m_useCaller)
+		{
+			run(0);
+		}
+		m_threads.join();
+	}
+
+	void Scheduler::schedule(Fiber::ptr fiber, int thread)
+	{
+		if (thread >= static_cast<int>(m_workers.size()))
+		{
+			throw std::out_of_range("Scheduler " + m_name + ": no worker " + std::to_string(thread));
+		}
+		Task* task = new Task;
+		task->fiber.swap(fiber);
+		task->thread = thread;
+		push(task);
+	}
+
+	void Scheduler::schedule(std::function<void()> cb, int thread)
+	{
+		if (thread >= static_cast<int>(m_workers.size()))
+		{
+			throw std::out_of_range("Scheduler " + m_name + ": no worker " + std::to_string(thread));
+		}
+		Task* task = new Task;
+		task->cb.swap(cb);
+		task->thread = thread;
+		push(task);
+	}
+
+	void Scheduler::push(Task* task)
+	{
+		m_taskCount.fetch_add(1, std::memory_order_relaxed);
+		int self = t_scheduler == this ? t_worker : -1;
+		if (self >= 0 && (task->thread < 0 || task->thread == self))
+		{
+			Worker* w = m_workers[self].get();
+			if (task->thread < 0)
+			{
+				w->local.push(task);
+				// 和睡眠方的"先登记 sleeping 再检查队列"配对
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (m_sleepers.load(std::memory_order_relaxed))
+				{
+					wakeIdle(self);
+				}
+			}
+			else
+			{
+				w->pinned.push_back(task);
+				w->pinnedSize.store(w->pinned.size(), std::memory_order_relaxed);
+			}
+			return;
+		}
+
+		uint32_t target;
+		if (task->thread >= 0)
+		{
+			target = static_cast<uint32_t>(task->thread);
+		}
+		else
+		{
+			// 调用者线程在 stop 之前不跑调度循环，不给它投递
+			uint32_t first = m_useCaller && m_workers.size() > 1 ? 1 : 0;
+			uint32_t n = static_cast<uint32_t>(m_workers.size()) - first;
+			uint32_t start = m_nextTarget.fetch_add(1, std::memory_order_relaxed);
+			target = first + start % n;
+			// 优先投给睡着的线程
+			if (m_sleepers.load(std::memory_order_relaxed))
+			{
+				for (uint32_t i = 0; i < n; ++i)
+				{
+					uint32_t idx = first + (start + i) % n;
+					if (m_workers[idx]->sleeping.load(std::memory_order_relaxed))
+					{
+						target = idx;
+						break;
+					}
+				}
+			}
+		}
+		Worker* w = m_workers[target].get();
+		if (!w->inbox.tryPush(task))
+		{
+			MutexType::Lock lock(&w->overflowMutex);
+			w->overflow.push_back(task);
+			w->overflowSize.fetch_add(1, std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (w->sleeping.load(std::memory_order_relaxed))
+		{
+			tickle(target);
+		}
+	}
+
+	void Scheduler::drainInbox(Worker* self)
+	{
+		size_t moved = 0;
+		auto place = [self, &moved](Task* task) {
+			if (task->thread >= 0)
+			{
+				self->pinned.push_back(task);
+			}
+			else
+			{
+				self->local.push(task);
+				++moved;
+			}
+		};
+		Task* task;
+		for (uint32_t i = 0; i < s_inbox_batch && self->inbox.tryPop(task); ++i)
+		{
+			place(task);
+		}
+		if (self->overflowSize.load(std::memory_order_relaxed))
+		{
+			MutexType::Lock lock(&self->overflowMutex);
+			for (uint32_t i = 0; i < s_inbox_batch && !self->overflow.empty(); ++i)
+			{
+				place(self->overflow.front());
+				self->overflow.pop_front();
+				self->overflowSize.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+		self->pinnedSize.store(self->pinned.size(), std::memory_order_relaxed);
+		// 转进来不止一个，剩下的可以分给睡着的同伴
+		if (moved > 1)
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (m_sleepers.load(std::memory_order_relaxed))
+			{
+				wakeIdle(static_cast<uint32_t>(t_worker));
+			}
+		}
+	}
+
+	Scheduler::Task* Scheduler::findTask(Worker* self)
+	{
+		if (self->inbox.size() || self->overflowSize.load(std::memory_order_relaxed))
+		{
+			drainInbox(self);
+		}
+		// pinned 与 local 轮流优先，一边源源不断时另一边也不会饿死
+		bool pinned_first = ++self->turn & 1;
+		if (pinned_first && !self->pinned.empty())
+		{
+			Task* task = self->pinned.front();
+			self->pinned.pop_front();
+			self->pinnedSize.store(self->pinned.size(), std::memory_order_relaxed);
+			return task;
+		}
+		// 从顶部取，先进先出
+		if (Task* task = self->local.steal())
+		{
+			return task;
+		}
+		if (!self->pinned.empty())
+		{
+			Task* task = self->pinned.front();
+			self->pinned.pop_front();
+			self->pinnedSize.store(self->pinned.size(), std::memory_order_relaxed);
+			return task;
+		}
+		return stealTask(self);
+	}
+
+	Scheduler::Task* Scheduler::stealTask(Worker* self)
+	{
+		size_t n = m_workers.size();
+		size_t start = NextRandom() % n;
+		for (size_t i = 0; i < n; ++i)
+		{
+			Worker* victim = m_workers[(start + i) % n].get();
+			if (victim == self)
+			{
+				continue;
+			}
+			if (Task* task = victim->local.steal())
+			{
+				self->steals.store(self->steals.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				// 别人的队列里可能还有，叫醒一个同伴一起偷
+				if (victim->local.size() && m_sleepers.load(std::memory_order_relaxed))
+				{
+					wakeIdle(static_cast<uint32_t>(t_worker));
+				}
+				return task;
+			}
+		}
+		return nullptr;
+	}
+
+	bool Scheduler::hasWork(Worker* self) const
+	{
+		if (self->inbox.size() || self->overflowSize.load(std::memory_order_relaxed) || !self->pinned.empty())
+		{
+			return true;
+		}
+		for (auto& w: m_workers)
+		{
+			if (w->local.size())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Scheduler::runTask(Worker* self, Task* task)
+	{
+		Fiber::ptr fiber;
+		bool is_cb = false;
+		if (task->fiber)
+		{
+			fiber.swap(task->fiber);
+		}
+		else
+		{
+			if (self->cbFiber)
+			{
+				self->cbFiber->reset(std::move(task->cb));
+			}
+			else
+			{
+				self->cbFiber.reset(new Fiber(std::move(task->cb)));
+			}
+			fiber = self->cbFiber;
+			is_cb = true;
+		}
+		int thread = task->thread;
+		delete task;
+		self->executed.store(self->executed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+		Fiber::State state = fiber->getState();
+		if (state != Fiber::TERM && state != Fiber::EXCEPT)
+		{
+			state = fiber->resume();
+		}
+		if (state == Fiber::READY)
+		{
+			schedule(fiber, thread);
+		}
+		// 回调协程挂起后由别人持有，下次换一个新的
+		if (is_cb && (state == Fiber::READY || state == Fiber::HOLD))
+		{
+			self->cbFiber.reset();
+		}
+		if (m_taskCount.fetch_sub(1, std::memory_order_acq_rel) == 1 && isStopping())
+		{
+			tickleAll();
+		}
+	}
+
+	void Scheduler::run(uint32_t index)
+	{
+		t_scheduler = this;
+		t_worker = static_cast<int>(index);
+		t_steal_seed = index * 2654435761u + 1;
+		Fiber::GetThis();
+		// 工作线程开启 hook，协程里的阻塞调用交给 IOManager；use_caller 的调用者线程退出时恢复
+		bool hook_enable = IsHookEnable();
+		SetHookEnable(true);
+		Worker* self = m_workers[index].get();
+
+		while (true)
+		{
+			Task* task = nullptr;
+			for (uint32_t i = 0; i < s_scheduler_spins && !task; ++i)
+			{
+				task = findTask(self);
+				if (!task)
+				{
+					RAREVOYAGER_CPU_RELAX();
+				}
+			}
+			if (task)
+			{
+				runTask(self, task);
+				onTaskExecuted(index);
+				continue;
+			}
+			if (stopping())
+			{
+				break;
+			}
+
+			self->wakeupSeen = self->wakeup.load(std::memory_order_acquire);
+			self->sleeping.store(1, std::memory_order_seq_cst);
+			m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+			if (!hasWork(self) && !stopping())
+			{
+				uint64_t begin = GetMonotonicNS();
+				idle(index);
+				self->idleCount.store(self->idleCount.load(std::memory_order_relaxed) + 1,
+				                      std::memory_order_relaxed);
+				self->idleNS.store(self->idleNS.load(std::memory_order_relaxed) + GetMonotonicNS() - begin,
+				                   std::memory_order_relaxed);
+			}
+			m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+			self->sleeping.store(0, std::memory_order_relaxed);
+		}
+
+		// 其它线程可能还睡在 idle 里，叫醒它们重新检查是否可以退出
+		tickleAll();
+		// 调用者线程 stop 之后就不再是工作线程
+		t_scheduler = nullptr;
+		t_worker = -1;
+		SetHookEnable(hook_enable);
+	}
+
+	void Scheduler::tickle(uint32_t worker)
+	{
+		Worker* w = m_workers[worker].get();
+		w->wakeup.fetch_add(1, std::memory_order_seq_cst);
+		FutexWake(&w->wakeup, 1);
+	}
+
+	void Scheduler::idle(uint32_t worker)
+	{
+		Worker* w = m_workers[worker].get();
+		FutexWait(&w->wakeup, w->wakeupSeen);
+	}
+
+	bool Scheduler::stopping()
+	{
+		return m_stopping.load(std::memory_order_acquire) && !m_taskCount.load(std::memory_order_acquire);
+	}
+
+	bool Scheduler::isSleeping(uint32_t worker) const
+	{
+		return m_workers[worker]->sleeping.load(std::memory_order_relaxed);
+	}
+
+	bool Scheduler::isTickled(uint32_t worker) const
+	{
+		Worker* w = m_workers[worker].get();
+		return w->wakeup.load(std::memory_order_seq_cst) != w->wakeupSeen;
+	}
+
+	void Scheduler::tickleAll()
+	{
+		for (uint32_t i = 0; i < m_workers.size(); ++i)
+		{
+			tickle(i);
+		}
+	}
+
+	void Scheduler::wakeIdle(uint32_t except)
+	{
+		size_t n = m_workers.size();
+		size_t start = NextRandom() % n;
+		for (size_t i = 0; i < n; ++i)
+		{
+			uint32_t idx = static_cast<uint32_t>((start + i) % n);
+			if (idx != except && m_workers[idx]->sleeping.load(std::memory_order_relaxed))
+			{
+				tickle(idx);
+				return;
+			}
+		}
+	}
+
+	std::vector<Scheduler::WorkerStats> Scheduler::getStats() const
+	{
+		std::vector<WorkerStats> stats(m_workers.size());
+		for (size_t i = 0; i < m_workers.size(); ++i)
+		{
+			Worker* w = m_workers[i].get();
+			stats[i].queued = static_cast<size_t>(w->local.size()) + w->inbox.size()
+			                  + w->overflowSize.load(std::memory_order_relaxed)
+			                  + w->pinnedSize.load(std::memory_order_relaxed);
+			stats[i].executed = w->executed.load(std::memory_order_relaxed);
+			stats[i].steals = w->steals.load(std::memory_order_relaxed);
+			stats[i].idleCount = w->idleCount.load(std::memory_order_relaxed);
+			stats[i].idleNS = w->idleNS.load(std::memory_order_relaxed);
+		}
+		return stats;
+	}
+
+	std::string Scheduler::statsToString() const
+	{
+		std::stringstream ss;
+		ss << "Scheduler " << m_name << " tasks=" << getTaskCount();
+		auto stats = getStats();
+		for (size_t i = 0; i < stats.size(); ++i)
+		{
+			ss << "\n  worker " << i << ": queued=" << stats[i].queued << " executed=" << stats[i].executed
+					<< " steals=" << stats[i].steals << " idle=" << stats[i].idleCount << " times/"
+					<< stats[i].idleNS / 1000000 << " ms";
+		}
+		return ss.str();
+	}
+#pragma endregion Scheduler
+}
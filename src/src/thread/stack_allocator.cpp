@@ -0,0 +1,167 @@
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <include/thread/stack_allocator.h>
+#include <include/config/config.h>
+
+namespace RareVoyager
+{
+	static ConfigVar<uint32_t>::ptr g_fiber_stack_size =
+			Config::Lookup("fiber.stack_size", (uint32_t)(128 * 1024), "fiber stack size in bytes");
+
+	static ConfigVar<uint32_t>::ptr g_fiber_stack_pool_size =
+			Config::Lookup("fiber.stack_pool_size", (uint32_t)256, "free fiber stacks cached per thread");
+
+	static ConfigVar<bool>::ptr g_fiber_stack_high_water =
+			Config::Lookup("fiber.stack_high_water", false,
+			               "measure fiber stack usage with mincore when a stack is freed");
+
+	static std::atomic<uint64_t> s_stack_mapped{0};
+	static std::atomic<size_t> s_stack_high_water{0};
+
+	/**
+	 * @brief: 每线程的空闲栈缓存，线程退出时归还给系统
+	 */
+	struct StackPool
+	{
+		struct Entry
+		{
+			void* stack;
+			size_t size;
+		};
+
+		~StackPool();
+
+		std::vector<Entry> free;
+	};
+
+	static thread_local StackPool t_stack_pool;
+	// 线程退出时 t_stack_pool 可能先于其它线程局部对象析构，之后释放的栈直接 munmap
+	static thread_local bool t_stack_pool_alive = true;
+
+	static void UnmapStack(void* stack, size_t size)
+	{
+		size_t page = StackAllocator::GetPageSize();
+		munmap(static_cast<char*>(stack) - page, size + page);
+		--s_stack_mapped;
+	}
+
+	StackPool::~StackPool()
+	{
+		t_stack_pool_alive = false;
+		for (auto& e: free)
+		{
+			UnmapStack(e.stack, e.size);
+		}
+	}
+
+#pragma region StackAllocator
+	void* StackAllocator::Alloc(size_t size)
+	{
+		if (t_stack_pool_alive)
+		{
+			// 大小基本都相同，从后往前找通常第一个就命中
+			auto& pool = t_stack_pool.free;
+			for (size_t i = pool.size(); i > 0; --i)
+			{
+				if (pool[i - 1].size == size)
+				{
+					void* stack = pool[i - 1].stack;
+					pool[i - 1] = pool.back();
+					pool.pop_back();
+					return stack;
+				}
+			}
+		}
+
+		size_t page = GetPageSize();
+		void* base = mmap(nullptr, size + page, PROT_READ | PROT_WRITE,
+		                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+		if (base == MAP_FAILED)
+		{
+			throw std::bad_alloc();
+		}
+		if (mprotect(base, page, PROT_NONE))
+		{
+			munmap(base, size + page);
+			throw std::bad_alloc();
+		}
+		++s_stack_mapped;
+		return static_cast<char*>(base) + page;
+	}
+
+	void StackAllocator::Dealloc(void* stack, size_t size)
+	{
+		if (g_fiber_stack_high_water->getValue())
+		{
+			size_t used = MeasureUsage(stack, size);
+			size_t prev = s_stack_high_water.load(std::memory_order_relaxed);
+			while (used > prev && !s_stack_high_water.compare_exchange_weak(prev, used, std::memory_order_relaxed))
+			{
+			}
+			madvise(stack, size, MADV_DONTNEED);
+		}
+		if (t_stack_pool_alive && t_stack_pool.free.size() < g_fiber_stack_pool_size->getValue())
+		{
+			t_stack_pool.free.push_back({stack, size});
+			return;
+		}
+		UnmapStack(stack, size);
+	}
+
+	size_t StackAllocator::RoundUp(size_t size)
+	{
+		size_t page = GetPageSize();
+		return size ? (size + page - 1) & ~(page - 1) : page;
+	}
+
+	size_t StackAllocator::GetDefaultStackSize()
+	{
+		return RoundUp(g_fiber_stack_size->getValue());
+	}
+
+	size_t StackAllocator::MeasureUsage(void* stack, size_t size)
+	{
+		size_t page = GetPageSize();
+		std::vector<unsigned char> resident(size / page);
+		if (mincore(stack, size, resident.data()))
+		{
+			return 0;
+		}
+		// 栈从高地址向低地址增长，最低的驻留页就是用到的最深位置
+		for (size_t i = 0; i < resident.size(); ++i)
+		{
+			if (resident[i] & 1)
+			{
+				return size - i * page;
+			}
+		}
+		return 0;
+	}
+
+	size_t StackAllocator::GetHighWater()
+	{
+		return s_stack_high_water.load(std::memory_order_relaxed);
+	}
+
+	uint64_t StackAllocator::GetMappedCount()
+	{
+		return s_stack_mapped.load(std::memory_order_relaxed);
+	}
+
+	size_t StackAllocator::GetPooledCount()
+	{
+		return t_stack_pool_alive ? t_stack_pool.free.size() : 0;
+	}
+
+	size_t StackAllocator::GetPageSize()
+	{
+		static const size_t s_page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		return s_page;
+	}
+#pragma endregion StackAllocator
+}
@@ -0,0 +1,341 @@
+#include <climits>
+#include <thread>
+
+#include <sched.h>
+
+#include <include/thread/task_scheduler.h>
+#include <include/thread/futex.h>
+#include <include/thread/topology.h>
+#include <include/config/config.h>
+
+namespace RareVoyager
+{
+	static Logger::ptr g_logger = RAREVOYAGER_LOG_NAME("system");
+
+	static ConfigVar<uint32_t>::ptr g_task_scheduler_threads =
+			Config::Lookup("task_scheduler.threads", (uint32_t)0, "work stealing worker threads, 0 means cpu count");
+
+	static ConfigVar<bool>::ptr g_task_scheduler_pin_threads =
+			Config::Lookup("task_scheduler.pin_threads", false,
+			               "pin each worker to its own physical core, 0 threads then means physical core count");
+
+	// 睡眠前自旋找任务的轮数
+	static const uint32_t s_idle_spins = 64;
+
+	// 当前线程是哪个调度器的工作线程
+	static thread_local TaskScheduler* t_scheduler = nullptr;
+	// 外部线程帮忙执行任务时，任务所属的调度器
+	static thread_local TaskScheduler* t_helping = nullptr;
+	static thread_local uint32_t t_worker_index = 0;
+	static thread_local uint32_t t_steal_seed = 0;
+
+	/**
+	 * @brief: xorshift 随机数，选择窃取对象
+	 */
+	static uint32_t NextRandom()
+	{
+		uint32_t x = t_steal_seed;
+		if (RAREVOYAGER_UNLIKELY(!x))
+		{
+			x = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&t_steal_seed) >> 4) | 1;
+		}
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		t_steal_seed = x;
+		return x;
+	}
+
+#pragma region TaskGroup
+	TaskGroup::TaskGroup(TaskScheduler* scheduler)
+		: m_scheduler(scheduler ? scheduler : TaskScheduler::GetThis())
+	{
+		if (!m_scheduler)
+		{
+			throw std::logic_error("TaskGroup without scheduler");
+		}
+	}
+
+	TaskGroup::~TaskGroup()
+	{
+		// 任务引用了这个对象，必须等它们结束；析构里不再抛异常
+		while (m_pending.load(std::memory_order_acquire))
+		{
+			if (!m_scheduler->runOne())
+			{
+				sched_yield();
+			}
+		}
+	}
+
+	void TaskGroup::run(std::function<void()> cb)
+	{
+		m_pending.fetch_add(1, std::memory_order_relaxed);
+		m_scheduler->spawn([this, cb]() {
+			try
+			{
+				cb();
+			}
+			catch (...)
+			{
+				Mutex::Lock lock(&m_mutex);
+				if (!m_exception)
+				{
+					m_exception = std::current_exception();
+				}
+			}
+			m_pending.fetch_sub(1, std::memory_order_release);
+		});
+	}
+
+	void TaskGroup::wait()
+	{
+		uint32_t spins = 0;
+		while (m_pending.load(std::memory_order_acquire))
+		{
+			if (m_scheduler->runOne())
+			{
+				spins = 0;
+				continue;
+			}
+			// 剩下的任务都在别人手里执行，稍等
+			if (++spins < s_idle_spins)
+			{
+				RAREVOYAGER_CPU_RELAX();
+			}
+			else
+			{
+				sched_yield();
+			}
+		}
+		std::exception_ptr e;
+		{
+			Mutex::Lock lock(&m_mutex);
+			e.swap(m_exception);
+		}
+		if (e)
+		{
+			std::rethrow_exception(e);
+		}
+	}
+#pragma endregion TaskGroup
+
+#pragma region TaskScheduler
+	TaskScheduler::TaskScheduler(const std::string& name, uint32_t threads)
+		: m_name(name)
+		  , m_threads(name)
+	{
+		if (!threads)
+		{
+			threads = g_task_scheduler_threads->getValue();
+		}
+		// 绑核时每个物理核一个线程，避开同核的超线程互相抢执行单元
+		std::vector<int> cores;
+		if (g_task_scheduler_pin_threads->getValue())
+		{
+			cores = CpuTopology::Get().onePerPhysicalCore();
+		}
+		if (!threads)
+		{
+			threads = cores.empty() ? std::max(1u, std::thread::hardware_concurrency())
+				          : static_cast<uint32_t>(cores.size());
+		}
+		// 先建好所有队列再启动线程，工作线程会遍历 m_workers 窃取
+		for (uint32_t i = 0; i < threads; ++i)
+		{
+			m_workers.emplace_back(new Worker);
+			m_workers.back()->index = i;
+		}
+		std::vector<ThreadOptions> options(threads);
+		for (uint32_t i = 0; i < threads && !cores.empty(); ++i)
+		{
+			options[i].cpus.push_back(cores[i % cores.size()]);
+		}
+		m_threads.start([this](size_t i) { workerLoop(m_workers[i].get()); }, options);
+	}
+
+	TaskScheduler::~TaskScheduler()
+	{
+		stop();
+	}
+
+	TaskScheduler* TaskScheduler::GetThis()
+	{
+		return t_scheduler ? t_scheduler : t_helping;
+	}
+
+	void TaskScheduler::spawn(std::function<void()> cb)
+	{
+		Job* job = new Job;
+		job->cb.swap(cb);
+		if (t_scheduler == this)
+		{
+			m_workers[t_worker_index]->deque.push(job);
+		}
+		else
+		{
+			Mutex::Lock lock(&m_injectMutex);
+			m_inject.push_back(job);
+			m_injectSize.fetch_add(1, std::memory_order_relaxed);
+		}
+		notifyOne();
+	}
+
+	void TaskScheduler::notifyOne()
+	{
+		// 与睡眠线程的"先登记 sleepers 再检查队列"配对
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_sleepers.load(std::memory_order_relaxed))
+		{
+			m_epoch.fetch_add(1, std::memory_order_seq_cst);
+			FutexWake(&m_epoch, 1);
+		}
+	}
+
+	bool TaskScheduler::needSplit()
+	{
+		if (t_scheduler != this)
+		{
+			return true;
+		}
+		return m_workers[t_worker_index]->deque.size() == 0;
+	}
+
+	TaskScheduler::Job* TaskScheduler::stealJob(Worker* self)
+	{
+		size_t n = m_workers.size();
+		size_t start = NextRandom() % n;
+		for (size_t i = 0; i < n; ++i)
+		{
+			Worker* victim = m_workers[(start + i) % n].get();
+			if (victim == self)
+			{
+				continue;
+			}
+			if (Job* job = victim->deque.steal())
+			{
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	TaskScheduler::Job* TaskScheduler::findJob(Worker* self)
+	{
+		if (self)
+		{
+			if (Job* job = self->deque.pop())
+			{
+				return job;
+			}
+		}
+		if (m_injectSize.load(std::memory_order_relaxed))
+		{
+			Mutex::Lock lock(&m_injectMutex);
+			if (!m_inject.empty())
+			{
+				Job* job = m_inject.front();
+				m_inject.pop_front();
+				m_injectSize.fetch_sub(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+		Job* job = stealJob(self);
+		if (job)
+		{
+			// 别人的队列里可能还有，叫醒一个同伴一起偷
+			notifyOne();
+		}
+		return job;
+	}
+
+	bool TaskScheduler::runOne()
+	{
+		Worker* self = t_scheduler == this ? m_workers[t_worker_index].get() : nullptr;
+		Job* job = findJob(self);
+		if (!job)
+		{
+			return false;
+		}
+		// 外部线程执行的任务里也能用 GetThis 拿到调度器，但 spawn 仍然走全局队列
+		TaskScheduler* helping = t_helping;
+		t_helping = this;
+		job->cb();
+		t_helping = helping;
+		delete job;
+		return true;
+	}
+
+	void TaskScheduler::workerLoop(Worker* worker)
+	{
+		t_scheduler = this;
+		t_worker_index = worker->index;
+		t_steal_seed = worker->index * 2654435761u + 1;
+
+		while (true)
+		{
+			Job* job = nullptr;
+			for (uint32_t i = 0; i < s_idle_spins && !job; ++i)
+			{
+				job = findJob(worker);
+				if (!job)
+				{
+					RAREVOYAGER_CPU_RELAX();
+				}
+			}
+			if (job)
+			{
+				job->cb();
+				delete job;
+				continue;
+			}
+
+			uint32_t epoch = m_epoch.load(std::memory_order_seq_cst);
+			m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+			job = findJob(worker);
+			if (!job && !m_stopping.load(std::memory_order_acquire))
+			{
+				FutexWait(&m_epoch, epoch);
+			}
+			m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+			if (job)
+			{
+				job->cb();
+				delete job;
+			}
+			else if (m_stopping.load(std::memory_order_acquire))
+			{
+				// 停止前把能找到的任务做完
+				while (runOne())
+				{
+				}
+				break;
+			}
+		}
+		t_scheduler = nullptr;
+	}
+
+	void TaskScheduler::stop()
+	{
+		if (m_stopping.exchange(true))
+		{
+			return;
+		}
+		m_epoch.fetch_add(1, std::memory_order_seq_cst);
+		FutexWake(&m_epoch, INT_MAX);
+		m_threads.join();
+		// 停止后外部才 spawn 的任务没有人执行了，直接释放
+		Mutex::Lock lock(&m_injectMutex);
+		if (!m_inject.empty())
+		{
+			RAREVOYAGER_LOG_WARN(g_logger) << "TaskScheduler " << m_name << " stopped with "
+					<< m_inject.size() << " pending jobs";
+		}
+		for (auto job: m_inject)
+		{
+			delete job;
+		}
+		m_inject.clear();
+	}
+#pragma endregion TaskScheduler
+}
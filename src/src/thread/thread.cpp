@@ -1,39 +1,128 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include <sched.h>
+
 #include <include/thread/thread.h>
+#include <include/thread/futex.h>
+#include <include/thread/topology.h>
+#include <include/thread/rcu.h>
+#include <include/thread/barrier.h>
+#include <include/macro.h>
 #include <include/util.h>
 #include <include/logger/logger.h>
+#include <include/profiler/profiler.h>
 
 
 namespace RareVoyager
 {
 #pragma region Semaphore
+	// 睡眠前自旋尝试的次数
+	static const uint32_t s_semaphore_spins = 128;
+	// m_state 中一个等待者的增量
+	static const uint64_t s_semaphore_waiter = 1ull << 32;
+	static const uint64_t s_semaphore_count_mask = s_semaphore_waiter - 1;
 
 	Semaphore::Semaphore(uint32_t count)
+		: m_state(count)
+	{
+	}
+
+	Semaphore::~Semaphore()
+	{
+	}
+
+	bool Semaphore::tryWait()
 	{
-		if (sem_init(&m_sem, 0, count))
+		uint64_t state = m_state.load(std::memory_order_relaxed);
+		while (state & s_semaphore_count_mask)
 		{
-			throw std::logic_error("sem_init failed");
+			if (m_state.compare_exchange_weak(state, state - 1, std::memory_order_acquire,
+			                                  std::memory_order_relaxed))
+			{
+				return true;
+			}
 		}
+		return false;
 	}
 
-	Semaphore::~Semaphore()
+	std::atomic<uint32_t>* Semaphore::countWord()
 	{
-		sem_destroy(&m_sem);
+		static_assert(sizeof(m_state) == 2 * sizeof(std::atomic<uint32_t>), "semaphore state must be 64 bits");
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		return reinterpret_cast<std::atomic<uint32_t>*>(&m_state) + 1;
+#else
+		return reinterpret_cast<std::atomic<uint32_t>*>(&m_state);
+#endif
+	}
+
+	bool Semaphore::spinWait()
+	{
+		for (uint32_t i = 0; i < s_semaphore_spins; ++i)
+		{
+			if (tryWait())
+			{
+				return true;
+			}
+			RAREVOYAGER_CPU_RELAX();
+		}
+		return false;
 	}
 
 	void Semaphore::wait()
 	{
-		if (sem_wait(&m_sem))
+		if (spinWait())
+		{
+			return;
+		}
+		// 登记等待者与 notify 加计数改的是同一个原子变量: 要么 notify 看到等待者，要么这里看到计数，不会漏唤醒
+		m_state.fetch_add(s_semaphore_waiter, std::memory_order_seq_cst);
+		while (!tryWait())
 		{
-			throw std::logic_error("sem_wait failed");
+			FutexWait(countWord(), 0);
 		}
+		m_state.fetch_sub(s_semaphore_waiter, std::memory_order_relaxed);
+	}
 
+	bool Semaphore::waitUntil(const std::chrono::steady_clock::time_point& deadline)
+	{
+		if (spinWait())
+		{
+			return true;
+		}
+		m_state.fetch_add(s_semaphore_waiter, std::memory_order_seq_cst);
+		bool ok = true;
+		while (!tryWait())
+		{
+			auto now = std::chrono::steady_clock::now();
+			if (now >= deadline)
+			{
+				ok = false;
+				break;
+			}
+			auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+			timespec ts;
+			ts.tv_sec = ns / 1000000000;
+			ts.tv_nsec = ns % 1000000000;
+			FutexWait(countWord(), 0, &ts);
+		}
+		m_state.fetch_sub(s_semaphore_waiter, std::memory_order_relaxed);
+		return ok;
 	}
 
-	void Semaphore::notify()
+	void Semaphore::notify(uint32_t n)
 	{
-		if (sem_post(&m_sem))
+		if (!n)
 		{
-			throw std::logic_error("sem_post failed");
+			return;
+		}
+		// 加完计数后信号量可能已经被拿到计数的等待者销毁，只能用之前取到的地址
+		std::atomic<uint32_t>* word = countWord();
+		uint64_t prev = m_state.fetch_add(n, std::memory_order_seq_cst);
+		if (prev >> 32)
+		{
+			FutexWake(word, n > INT_MAX ? INT_MAX : static_cast<int>(n));
 		}
 	}
 
@@ -67,25 +156,48 @@ namespace RareVoyager
 	}
 
 
-	Thread::Thread(std::function<void()> cb, const std::string& name) : m_cb(cb)
+	Thread::Thread(std::function<void()> cb, const std::string& name)
+		: Thread(cb, name, ThreadOptions())
+	{
+	}
+
+	Thread::Thread(std::function<void()> cb, const std::string& name, const ThreadOptions& options)
+		: m_cb(cb)
+		  , m_options(options)
 	{
 		if (name.empty())
 		{
 			m_name = "UNKNOW";
 		}
 		m_name = name;
-		int rt = pthread_create(&m_thread, nullptr, &Thread::run, this);
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		if (m_options.stackSize)
+		{
+			int rt = pthread_attr_setstacksize(&attr, std::max<size_t>(m_options.stackSize, PTHREAD_STACK_MIN));
+			if (rt)
+			{
+				RAREVOYAGER_LOG_WARN(system_logger) << "pthread_attr_setstacksize " << m_options.stackSize
+						<< " faild rt = " << rt << " thread name = " << name;
+			}
+		}
+		int rt = pthread_create(&m_thread, &attr, &Thread::run, this);
+		pthread_attr_destroy(&attr);
 		if (rt)
 		{
 			RAREVOYAGER_LOG_ERROR(system_logger) << "pthread_create thread faild rt = " << rt << "thread name = " << name;
 			throw std::logic_error("pthread_create thread error");
 		}
-		m_semaphore.wait();
+		if (!m_options.startLatch)
+		{
+			m_semaphore.wait();
+		}
 	}
 
 	Thread::~Thread()
 	{
-		if (t_thread)
+		// 没有 join 过的线程分离掉，由系统回收
+		if (m_thread)
 		{
 			pthread_detach(m_thread);
 		}
@@ -117,13 +229,73 @@ namespace RareVoyager
 		std::function<void()> cb;
 
 		cb.swap(thread->m_cb);
-		thread->m_semaphore.notify();
+		thread->applyOptions();
+		// 注册到采样分析器，分析器运行中时立即开始采样
+		Profiler::RegisterThread();
+		Rcu::RegisterThread();
+		if (thread->m_options.startLatch)
+		{
+			// countDown 之后线程组可能已经返回，不能再访问 thread 的成员
+			thread->m_options.startLatch->countDown();
+		}
+		else
+		{
+			thread->m_semaphore.notify();
+		}
 		if (cb)
 		{
 			cb();
 		}
+		Rcu::UnregisterThread();
+		Profiler::UnregisterThread();
 		return 0;
 	}
+
+	void Thread::applyOptions()
+	{
+		std::vector<int> cpus = m_options.cpus;
+		if (m_options.numaNode >= 0)
+		{
+			// 先绑内存策略，之后的栈增长、malloc 都落在本节点
+			NumaBindThread(m_options.numaNode);
+			if (cpus.empty())
+			{
+				cpus = CpuTopology::Get().getNodeCpus(m_options.numaNode);
+			}
+		}
+		if (!cpus.empty())
+		{
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			for (int cpu: cpus)
+			{
+				if (cpu >= 0 && cpu < CPU_SETSIZE)
+				{
+					CPU_SET(cpu, &set);
+				}
+			}
+			int rt = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+			if (rt)
+			{
+				RAREVOYAGER_LOG_WARN(system_logger) << "pthread_setaffinity_np faild rt = " << rt
+						<< " thread name = " << m_name;
+			}
+		}
+		if (m_options.schedPolicy >= 0)
+		{
+			sched_param param;
+			memset(&param, 0, sizeof(param));
+			param.sched_priority = m_options.priority;
+			// 实时策略一般需要 CAP_SYS_NICE，没有权限时保持默认策略
+			int rt = pthread_setschedparam(pthread_self(), m_options.schedPolicy, &param);
+			if (rt)
+			{
+				RAREVOYAGER_LOG_WARN(system_logger) << "pthread_setschedparam policy = " << m_options.schedPolicy
+						<< " priority = " << m_options.priority << " faild rt = " << rt << " errstr = "
+						<< strerror(rt) << " thread name = " << m_name;
+			}
+		}
+	}
 #pragma endregion Thread
 
 }
\ No newline at end of file
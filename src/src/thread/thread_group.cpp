@@ -0,0 +1,61 @@
+#include <include/thread/thread_group.h>
+
+namespace RareVoyager
+{
+#pragma region ThreadGroup
+	ThreadGroup::ThreadGroup(const std::string& name)
+		: m_name(name)
+	{
+	}
+
+	ThreadGroup::~ThreadGroup()
+	{
+		join();
+	}
+
+	void ThreadGroup::start(size_t n, std::function<void(size_t)> cb, const ThreadOptions& options)
+	{
+		start(std::move(cb), std::vector<ThreadOptions>(n, options));
+	}
+
+	void ThreadGroup::start(std::function<void(size_t)> cb, const std::vector<ThreadOptions>& options)
+	{
+		if (options.empty())
+		{
+			return;
+		}
+		m_latches.emplace_back(new Latch(static_cast<uint32_t>(options.size())));
+		Latch* latch = m_latches.back().get();
+		size_t base = m_threads.size();
+		size_t created = 0;
+		try
+		{
+			for (size_t i = 0; i < options.size(); ++i)
+			{
+				ThreadOptions opt = options[i];
+				opt.startLatch = latch;
+				size_t index = base + i;
+				m_threads.emplace_back(new Thread([cb, index]() { cb(index); },
+				                                  m_name + "_" + std::to_string(index), opt));
+				++created;
+			}
+		}
+		catch (...)
+		{
+			// 没创建出来的线程替它们 countDown，已经创建的线程照常运行，由 join 回收
+			latch->countDown(static_cast<uint32_t>(options.size() - created));
+			latch->wait();
+			throw;
+		}
+		latch->wait();
+	}
+
+	void ThreadGroup::join()
+	{
+		for (auto& t: m_threads)
+		{
+			t->join();
+		}
+	}
+#pragma endregion ThreadGroup
+}
@@ -0,0 +1,178 @@
+#include <stdexcept>
+#include <vector>
+
+#include <pthread.h>
+
+#include <include/thread/thread_local.h>
+#include <include/thread/mutex.h>
+
+namespace RareVoyager
+{
+	/**
+	 * @brief: 编号分配与全局锁。进程退出时不析构，其它线程可能还在退出
+	 */
+	struct ThreadLocalRegistry
+	{
+		ThreadLocalRegistry()
+		{
+			// 线程退出时释放槽位表。主线程的值随进程退出，不单独释放
+			pthread_key_create(&key, [](void* data) { delete static_cast<ThreadLocalData*>(data); });
+		}
+
+		Mutex mutex;
+		uint32_t nextId = 0;
+		std::vector<uint32_t> freeIds;
+		pthread_key_t key;
+	};
+
+	static ThreadLocalRegistry& GetRegistry()
+	{
+		static ThreadLocalRegistry* s_registry = new ThreadLocalRegistry;
+		return *s_registry;
+	}
+
+#pragma region ThreadLocalData
+	ThreadLocalData::ThreadLocalData()
+	{
+		for (auto& chunk: chunks)
+		{
+			chunk.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	ThreadLocalData::~ThreadLocalData()
+	{
+		ThreadLocalRegistry& registry = GetRegistry();
+		{
+			Mutex::Lock lock(&registry.mutex);
+			for (auto& c: chunks)
+			{
+				std::atomic<ThreadLocalEntry*>* chunk = c.load(std::memory_order_relaxed);
+				if (!chunk)
+				{
+					continue;
+				}
+				for (uint32_t i = 0; i < ThreadLocalBase::s_chunkSize; ++i)
+				{
+					ThreadLocalEntry* entry = chunk[i].load(std::memory_order_relaxed);
+					if (entry)
+					{
+						entry->owner->onThreadExit(entry);
+						entry->owner->destroyEntry(entry);
+					}
+				}
+				delete[] chunk;
+			}
+		}
+		if (ThreadLocalBase::t_data == this)
+		{
+			ThreadLocalBase::t_data = nullptr;
+		}
+	}
+#pragma endregion ThreadLocalData
+
+#pragma region ThreadLocalBase
+	ThreadLocalBase::ThreadLocalBase()
+	{
+		ThreadLocalRegistry& registry = GetRegistry();
+		Mutex::Lock lock(&registry.mutex);
+		if (!registry.freeIds.empty())
+		{
+			m_id = registry.freeIds.back();
+			registry.freeIds.pop_back();
+		}
+		else
+		{
+			if (registry.nextId >= s_chunkSize * s_maxChunks)
+			{
+				throw std::length_error("too many ThreadLocal instances");
+			}
+			m_id = registry.nextId++;
+		}
+	}
+
+	ThreadLocalBase::~ThreadLocalBase()
+	{
+		// 其它线程里的值一起释放，槽位清空后编号才能复用
+		ThreadLocalRegistry& registry = GetRegistry();
+		Mutex::Lock lock(&registry.mutex);
+		while (m_head)
+		{
+			destroyEntry(m_head);
+		}
+		registry.freeIds.push_back(m_id);
+	}
+
+	ThreadLocalEntry* ThreadLocalBase::create()
+	{
+		ThreadLocalRegistry& registry = GetRegistry();
+		ThreadLocalData* data = t_data;
+		if (!data)
+		{
+			data = new ThreadLocalData;
+			t_data = data;
+			pthread_setspecific(registry.key, data);
+		}
+		std::atomic<ThreadLocalEntry*>* chunk = data->chunks[m_id / s_chunkSize].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new std::atomic<ThreadLocalEntry*>[s_chunkSize];
+			for (uint32_t i = 0; i < s_chunkSize; ++i)
+			{
+				chunk[i].store(nullptr, std::memory_order_relaxed);
+			}
+			// 释放语义: 持有全局锁的线程读到块指针时能看到初始化好的槽位
+			data->chunks[m_id / s_chunkSize].store(chunk, std::memory_order_release);
+		}
+
+		ThreadLocalEntry* entry = newEntry();
+		entry->owner = this;
+		entry->data = data;
+		Mutex::Lock lock(&registry.mutex);
+		entry->next = m_head;
+		if (m_head)
+		{
+			m_head->prev = entry;
+		}
+		m_head = entry;
+		++m_count;
+		chunk[m_id % s_chunkSize].store(entry, std::memory_order_relaxed);
+		return entry;
+	}
+
+	void ThreadLocalBase::destroyEntry(ThreadLocalEntry* entry)
+	{
+		if (entry->prev)
+		{
+			entry->prev->next = entry->next;
+		}
+		else
+		{
+			m_head = entry->next;
+		}
+		if (entry->next)
+		{
+			entry->next->prev = entry->prev;
+		}
+		--m_count;
+		std::atomic<ThreadLocalEntry*>* chunk = entry->data->chunks[m_id / s_chunkSize].load(std::memory_order_acquire);
+		chunk[m_id % s_chunkSize].store(nullptr, std::memory_order_relaxed);
+		delete entry;
+	}
+
+	void ThreadLocalBase::visit(const std::function<void(ThreadLocalEntry*)>& cb) const
+	{
+		Mutex::Lock lock(&GetRegistry().mutex);
+		for (ThreadLocalEntry* entry = m_head; entry; entry = entry->next)
+		{
+			cb(entry);
+		}
+	}
+
+	size_t ThreadLocalBase::getThreadCount() const
+	{
+		Mutex::Lock lock(&GetRegistry().mutex);
+		return m_count;
+	}
+#pragma endregion ThreadLocalBase
+}
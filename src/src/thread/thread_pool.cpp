@@ -0,0 +1,297 @@
+#include <sstream>
+
+#include <include/thread/thread_pool.h>
+#include <include/config/config.h>
+
+namespace RareVoyager
+{
+	static Logger::ptr g_logger = RAREVOYAGER_LOG_NAME("system");
+
+	static ConfigVar<uint32_t>::ptr g_thread_pool_min_threads =
+			Config::Lookup("thread_pool.min_threads", (uint32_t)4, "thread pool min worker threads");
+
+	static ConfigVar<uint32_t>::ptr g_thread_pool_max_threads =
+			Config::Lookup("thread_pool.max_threads", (uint32_t)0, "thread pool max worker threads, 0 means fixed size");
+
+	static ConfigVar<uint64_t>::ptr g_thread_pool_idle_timeout =
+			Config::Lookup("thread_pool.idle_timeout_ms", (uint64_t)60000, "idle time before an extra worker exits");
+
+	// 当前工作线程所属的线程池。任务里析构线程池时由 shutdown 清空，工作线程据此不再访问成员
+	static thread_local ThreadPool* t_pool = nullptr;
+
+#pragma region ThreadPool
+	ThreadPool::ThreadPool(const std::string& name)
+		: ThreadPool(name, g_thread_pool_min_threads->getValue(), g_thread_pool_max_threads->getValue(),
+		             g_thread_pool_idle_timeout->getValue())
+	{
+	}
+
+	ThreadPool::ThreadPool(const std::string& name, uint32_t min_threads, uint32_t max_threads,
+	                       uint64_t idle_timeout_ms)
+		: m_name(name)
+		  , m_minThreads(min_threads ? min_threads : 1)
+		  , m_maxThreads(max_threads > m_minThreads ? max_threads : m_minThreads)
+		  , m_idleTimeoutMS(idle_timeout_ms)
+	{
+		start();
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		shutdown(DRAIN);
+	}
+
+	void ThreadPool::start()
+	{
+		// 先创建全部初始线程，再统一等待一次，不逐个握手
+		m_startLatch.reset(new Latch(m_minThreads));
+		{
+			MutexType::Lock lock(&m_mutex);
+			for (uint32_t i = 0; i < m_minThreads; ++i)
+			{
+				spawn(m_startLatch.get());
+			}
+		}
+		m_startLatch->wait();
+	}
+
+	ThreadPool::Task::ptr ThreadPool::makeTask(std::function<void()> cb)
+	{
+		Task::ptr task(new Task);
+		task->m_cb.swap(cb);
+		return task;
+	}
+
+	std::vector<std::future<void> > ThreadPool::submitN(const std::vector<std::function<void()> >& cbs,
+	                                                    std::vector<Task::ptr>* tasks)
+	{
+		std::vector<std::future<void> > futures;
+		std::vector<Task::ptr> batch;
+		futures.reserve(cbs.size());
+		batch.reserve(cbs.size());
+		for (auto& cb: cbs)
+		{
+			auto pt = std::make_shared<std::packaged_task<void()> >(cb);
+			futures.push_back(pt->get_future());
+			batch.push_back(makeTask([pt]() { (*pt)(); }));
+		}
+		enqueue(batch.data(), batch.size());
+		if (tasks)
+		{
+			tasks->swap(batch);
+		}
+		return futures;
+	}
+
+	void ThreadPool::enqueue(Task::ptr* tasks, size_t n)
+	{
+		if (!n)
+		{
+			return;
+		}
+		reapFinished();
+		uint64_t now = GetMonotonicNS();
+		{
+			MutexType::Lock lock(&m_mutex);
+			if (isStopping())
+			{
+				throw std::logic_error("ThreadPool " + m_name + " is stopping");
+			}
+			for (size_t i = 0; i < n; ++i)
+			{
+				tasks[i]->m_enqueueNS = now;
+				m_tasks.push_back(tasks[i]);
+			}
+			m_maxQueueDepth = std::max<uint64_t>(m_maxQueueDepth, m_tasks.size());
+			maybeSpawn(m_tasks.size());
+		}
+		m_submitted.fetch_add(n, std::memory_order_relaxed);
+		m_semaphore.notify(static_cast<uint32_t>(n));
+	}
+
+	void ThreadPool::maybeSpawn(size_t pending)
+	{
+		while (m_idle < pending && m_threads.size() < m_maxThreads)
+		{
+			spawn();
+		}
+	}
+
+	void ThreadPool::spawn(Latch* latch)
+	{
+		// 新线程启动后先算作空闲
+		++m_idle;
+		ThreadOptions options;
+		options.startLatch = latch;
+		m_threads.emplace_back(new Thread(std::bind(&ThreadPool::workerLoop, this),
+		                                  m_name + "_" + std::to_string(m_threadIndex++), options));
+	}
+
+	void ThreadPool::reapFinished()
+	{
+		std::list<Thread::ptr> finished;
+		{
+			MutexType::Lock lock(&m_mutex);
+			finished.swap(m_finished);
+		}
+		for (auto& t: finished)
+		{
+			t->join();
+		}
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		t_pool = this;
+		while (true)
+		{
+			bool extra;
+			{
+				MutexType::Lock lock(&m_mutex);
+				extra = m_threads.size() > m_minThreads;
+			}
+			bool woken = true;
+			if (extra)
+			{
+				woken = m_semaphore.waitFor(std::chrono::milliseconds(m_idleTimeoutMS));
+			}
+			else
+			{
+				m_semaphore.wait();
+			}
+
+			Task::ptr task;
+			{
+				MutexType::Lock lock(&m_mutex);
+				if (m_tasks.empty())
+				{
+					bool exit = isStopping() || (!woken && m_threads.size() > m_minThreads);
+					if (!exit)
+					{
+						continue;
+					}
+					--m_idle;
+					// 从线程表移到待回收表，由其它线程 join；关闭时线程表已经被取走，这里找不到也没关系
+					for (auto it = m_threads.begin(); it != m_threads.end(); ++it)
+					{
+						if (it->get() == Thread::GetThis())
+						{
+							m_finished.push_back(*it);
+							m_threads.erase(it);
+							break;
+						}
+					}
+					return;
+				}
+				task = m_tasks.front();
+				m_tasks.pop_front();
+				--m_idle;
+			}
+
+			int expected = Task::PENDING;
+			if (task->m_state.compare_exchange_strong(expected, Task::RUNNING))
+			{
+				uint64_t begin = GetMonotonicNS();
+				m_queueLatency.record(begin - task->m_enqueueNS);
+				task->m_cb();
+				if (t_pool != this)
+				{
+					// 回调里析构了线程池，只收尾任务本身
+					task->m_state.store(Task::FINISHED);
+					task->m_cb = nullptr;
+					return;
+				}
+				m_runLatency.record(GetMonotonicNS() - begin);
+				task->m_state.store(Task::FINISHED);
+				m_completed.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				m_cancelled.fetch_add(1, std::memory_order_relaxed);
+			}
+			// 释放回调(以及它持有的 packaged_task)，被取消的任务在这里让 future 变成 broken_promise
+			task->m_cb = nullptr;
+			// 回调持有线程池的最后一个引用时，线程池在上一行析构
+			if (t_pool != this)
+			{
+				return;
+			}
+
+			MutexType::Lock lock(&m_mutex);
+			++m_idle;
+		}
+	}
+
+	void ThreadPool::shutdown(ShutdownMode mode)
+	{
+		std::deque<Task::ptr> abandoned;
+		std::list<Thread::ptr> threads;
+		{
+			MutexType::Lock lock(&m_mutex);
+			m_stopping.store(true, std::memory_order_release);
+			if (mode == ABANDON)
+			{
+				abandoned.swap(m_tasks);
+			}
+			threads.swap(m_threads);
+			threads.splice(threads.end(), m_finished);
+		}
+		for (auto& t: abandoned)
+		{
+			if (t->cancel())
+			{
+				m_cancelled.fetch_add(1, std::memory_order_relaxed);
+			}
+			t->m_cb = nullptr;
+		}
+		// 每个线程一个额外的计数，保证都能醒来看到 stopping
+		m_semaphore.notify(static_cast<uint32_t>(threads.size()));
+		for (auto& t: threads)
+		{
+			// 在本线程池的任务里关闭时不能 join 自己，线程对象析构时分离，任务返回后线程直接退出
+			if (t_pool == this && t.get() == Thread::GetThis())
+			{
+				t_pool = nullptr;
+				continue;
+			}
+			t->join();
+		}
+		if (!threads.empty())
+		{
+			RAREVOYAGER_LOG_DEBUG(g_logger) << "ThreadPool " << m_name << " shutdown, " << toString();
+		}
+	}
+
+	ThreadPool::Stats ThreadPool::getStats()
+	{
+		Stats stats;
+		{
+			MutexType::Lock lock(&m_mutex);
+			stats.threads = static_cast<uint32_t>(m_threads.size());
+			stats.idleThreads = m_idle;
+			stats.queueDepth = m_tasks.size();
+			stats.maxQueueDepth = m_maxQueueDepth;
+		}
+		stats.submitted = m_submitted.load(std::memory_order_relaxed);
+		stats.completed = m_completed.load(std::memory_order_relaxed);
+		stats.cancelled = m_cancelled.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	std::string ThreadPool::toString()
+	{
+		Stats stats = getStats();
+		std::stringstream ss;
+		ss << "threads=" << stats.threads
+				<< " idle=" << stats.idleThreads
+				<< " queue=" << stats.queueDepth
+				<< " max_queue=" << stats.maxQueueDepth
+				<< " submitted=" << stats.submitted
+				<< " completed=" << stats.completed
+				<< " cancelled=" << stats.cancelled
+				<< "\n  queue_ns: " << m_queueLatency.toString()
+				<< "\n  run_ns:   " << m_runLatency.toString();
+		return ss.str();
+	}
+#pragma endregion ThreadPool
+}
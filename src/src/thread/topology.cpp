@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <include/thread/topology.h>
+#include <include/util.h>
+#include <include/logger/logger.h>
+
+namespace RareVoyager
+{
+	static Logger::ptr g_logger = RAREVOYAGER_LOG_NAME("system");
+
+	// 与 <numaif.h> 一致，直接走系统调用，不依赖 libnuma
+	static const int s_mpol_default = 0;
+	static const int s_mpol_bind = 2;
+	// 节点掩码最多支持的节点数
+	static const unsigned long s_max_numa_nodes = 64;
+
+	static bool ReadSysFile(const std::string& path, std::string& out)
+	{
+		std::ifstream ifs(path);
+		if (!ifs)
+		{
+			return false;
+		}
+		std::getline(ifs, out);
+		return true;
+	}
+
+	static int ReadSysInt(const std::string& path, int def)
+	{
+		std::string str;
+		if (!ReadSysFile(path, str) || str.empty())
+		{
+			return def;
+		}
+		return atoi(str.c_str());
+	}
+
+#pragma region CpuTopology
+	std::vector<int> CpuTopology::ParseCpuList(const std::string& str)
+	{
+		std::vector<int> cpus;
+		std::stringstream ss(str);
+		std::string item;
+		while (std::getline(ss, item, ','))
+		{
+			if (item.empty())
+			{
+				continue;
+			}
+			size_t dash = item.find('-');
+			int first = atoi(item.c_str());
+			int last = dash == std::string::npos ? first : atoi(item.c_str() + dash + 1);
+			for (int i = first; i <= last; ++i)
+			{
+				cpus.push_back(i);
+			}
+		}
+		return cpus;
+	}
+
+	CpuTopology::CpuTopology()
+	{
+		std::string online;
+		std::vector<int> cpus;
+		if (ReadSysFile("/sys/devices/system/cpu/online", online))
+		{
+			cpus = ParseCpuList(online);
+		}
+		if (cpus.empty())
+		{
+			for (unsigned i = 0; i < std::max(1u, std::thread::hardware_concurrency()); ++i)
+			{
+				cpus.push_back(static_cast<int>(i));
+			}
+		}
+
+		for (int cpu: cpus)
+		{
+			std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+			CpuInfo info;
+			info.cpu = cpu;
+			// 读不到时当作独立的核
+			info.core = ReadSysInt(base + "core_id", cpu);
+			info.package = ReadSysInt(base + "physical_package_id", 0);
+			m_cpus.push_back(info);
+		}
+
+		std::string nodes;
+		std::vector<int> node_ids;
+		if (ReadSysFile("/sys/devices/system/node/online", nodes))
+		{
+			node_ids = ParseCpuList(nodes);
+		}
+		for (int node: node_ids)
+		{
+			std::string list;
+			if (!ReadSysFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", list))
+			{
+				continue;
+			}
+			for (int cpu: ParseCpuList(list))
+			{
+				for (auto& info: m_cpus)
+				{
+					if (info.cpu == cpu)
+					{
+						info.node = node;
+					}
+				}
+			}
+		}
+		m_nodeCount = node_ids.empty() ? 1 : static_cast<int>(node_ids.size());
+	}
+
+	const CpuTopology& CpuTopology::Get()
+	{
+		static CpuTopology s_topology;
+		return s_topology;
+	}
+
+	int CpuTopology::getCoreCount() const
+	{
+		std::set<std::pair<int, int> > cores;
+		for (auto& info: m_cpus)
+		{
+			cores.insert(std::make_pair(info.package, info.core));
+		}
+		return static_cast<int>(cores.size());
+	}
+
+	std::vector<int> CpuTopology::getNodeCpus(int node) const
+	{
+		std::vector<int> cpus;
+		for (auto& info: m_cpus)
+		{
+			if (info.node == node)
+			{
+				cpus.push_back(info.cpu);
+			}
+		}
+		return cpus;
+	}
+
+	int CpuTopology::getNodeOfCpu(int cpu) const
+	{
+		for (auto& info: m_cpus)
+		{
+			if (info.cpu == cpu)
+			{
+				return info.node;
+			}
+		}
+		return -1;
+	}
+
+	std::vector<int> CpuTopology::onePerPhysicalCore(int node) const
+	{
+		std::vector<CpuInfo> sorted = m_cpus;
+		std::sort(sorted.begin(), sorted.end(), [](const CpuInfo& a, const CpuInfo& b) {
+			if (a.node != b.node)
+			{
+				return a.node < b.node;
+			}
+			if (a.package != b.package)
+			{
+				return a.package < b.package;
+			}
+			if (a.core != b.core)
+			{
+				return a.core < b.core;
+			}
+			return a.cpu < b.cpu;
+		});
+		std::vector<int> cpus;
+		std::set<std::pair<int, int> > seen;
+		for (auto& info: sorted)
+		{
+			if (node >= 0 && info.node != node)
+			{
+				continue;
+			}
+			if (seen.insert(std::make_pair(info.package, info.core)).second)
+			{
+				cpus.push_back(info.cpu);
+			}
+		}
+		return cpus;
+	}
+
+	std::string CpuTopology::toString() const
+	{
+		std::stringstream ss;
+		ss << "cpus=" << m_cpus.size() << " cores=" << getCoreCount() << " nodes=" << m_nodeCount;
+		for (auto& info: m_cpus)
+		{
+			ss << "\n  cpu" << info.cpu << " core=" << info.core << " package=" << info.package
+					<< " node=" << info.node;
+		}
+		return ss.str();
+	}
+#pragma endregion CpuTopology
+
+#pragma region Numa
+	bool NumaBindThread(int node)
+	{
+#ifdef SYS_set_mempolicy
+		if (node >= static_cast<int>(s_max_numa_nodes))
+		{
+			return false;
+		}
+		unsigned long mask = node < 0 ? 0 : 1UL << node;
+		long rt = syscall(SYS_set_mempolicy, node < 0 ? s_mpol_default : s_mpol_bind,
+		                  node < 0 ? nullptr : &mask, node < 0 ? 0 : s_max_numa_nodes + 1);
+		if (rt)
+		{
+			RAREVOYAGER_LOG_WARN(g_logger) << "set_mempolicy node = " << node << " errno = " << errno
+					<< " errstr = " << strerror(errno);
+			return false;
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool NumaBindMemory(void* addr, size_t len, int node)
+	{
+#ifdef SYS_mbind
+		if (node < 0 || node >= static_cast<int>(s_max_numa_nodes))
+		{
+			return false;
+		}
+		unsigned long mask = 1UL << node;
+		long rt = syscall(SYS_mbind, addr, len, s_mpol_bind, &mask, s_max_numa_nodes + 1, 0);
+		if (rt)
+		{
+			RAREVOYAGER_LOG_WARN(g_logger) << "mbind node = " << node << " len = " << len << " errno = " << errno
+					<< " errstr = " << strerror(errno);
+			return false;
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+#pragma endregion Numa
+}
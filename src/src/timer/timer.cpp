@@ -0,0 +1,423 @@
+#include <include/timer/timer.h>
+#include <include/util.h>
+
+namespace RareVoyager
+{
+	// 超过这个时长的定时器先放在最高层的最远槽，转到时再按真实到期时间重新放置
+	static const uint64_t s_timer_max_delta = (1ull << 32) - 1;
+
+	/**
+	 * @brief: 位图 bits 中下标不小于 from 的第一个 1，没有返回 -1
+	 */
+	static int FindNextBit(const uint64_t* bits, uint32_t words, uint32_t from)
+	{
+		for (uint32_t w = from / 64; w < words; ++w)
+		{
+			uint64_t word = bits[w];
+			if (w == from / 64)
+			{
+				word &= ~0ull << (from % 64);
+			}
+			if (word)
+			{
+				return static_cast<int>(w * 64 + __builtin_ctzll(word));
+			}
+		}
+		return -1;
+	}
+
+#pragma region Timer
+	Timer::Timer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager* manager)
+		: m_ms(ms)
+		  , m_cb(std::move(cb))
+		  , m_recurring(recurring)
+		  , m_manager(manager)
+	{
+	}
+
+	bool Timer::cancel()
+	{
+		// 自引用在锁外释放，回调里捕获的对象析构时可能再操作定时器
+		ptr self;
+		std::function<void()> cb;
+		TimerManager::MutexType::Lock lock(&m_manager->m_mutex);
+		if (m_level < 0)
+		{
+			return false;
+		}
+		m_manager->unlink(this);
+		cb.swap(m_cb);
+		self.swap(m_self);
+		return true;
+	}
+
+	bool Timer::refresh()
+	{
+		TimerManager::MutexType::Lock lock(&m_manager->m_mutex);
+		if (m_level < 0)
+		{
+			return false;
+		}
+		m_manager->unlink(this);
+		m_start = m_manager->startTick();
+		m_expire = m_start + m_ms;
+		// 只会变晚，不需要通知
+		m_manager->place(this);
+		return true;
+	}
+
+	bool Timer::reset(uint64_t ms, bool from_now)
+	{
+		if (ms == m_ms && !from_now)
+		{
+			return true;
+		}
+		TimerManager::MutexType::Lock lock(&m_manager->m_mutex);
+		if (m_level < 0)
+		{
+			return false;
+		}
+		m_manager->unlink(this);
+		if (from_now)
+		{
+			m_start = m_manager->startTick();
+		}
+		m_ms = ms;
+		m_expire = m_start + m_ms;
+		m_manager->place(this);
+		bool front = m_manager->markFront(m_expire);
+		lock.unlock();
+		m_manager->notifyFront(front);
+		return true;
+	}
+#pragma endregion Timer
+
+#pragma region TimerManager
+	TimerManager::TimerManager()
+		: m_baseNS(GetMonotonicNS())
+	{
+	}
+
+	TimerManager::~TimerManager()
+	{
+		// 打断等待中定时器的自引用
+		std::vector<Timer::ptr> pending;
+		MutexType::Lock lock(&m_mutex);
+		for (uint32_t level = 0; level <= s_levels; ++level)
+		{
+			uint32_t size = level ? s_levelSize : s_rootSize;
+			for (uint32_t i = 0; i < size; ++i)
+			{
+				Slot& s = slot(level, i);
+				while (s.head)
+				{
+					Timer* timer = s.head;
+					unlink(timer);
+					pending.push_back(std::move(timer->m_self));
+				}
+			}
+		}
+	}
+
+	Timer::ptr TimerManager::addTimer(uint64_t ms, std::function<void()> cb, bool recurring)
+	{
+		Timer::ptr timer(new Timer(ms, std::move(cb), recurring, this));
+		MutexType::Lock lock(&m_mutex);
+		timer->m_start = startTick();
+		timer->m_expire = timer->m_start + ms;
+		timer->m_self = timer;
+		place(timer.get());
+		bool front = markFront(timer->m_expire);
+		lock.unlock();
+		notifyFront(front);
+		return timer;
+	}
+
+	Timer::ptr TimerManager::addConditionTimer(uint64_t ms, std::function<void()> cb, std::weak_ptr<void> weak_cond,
+	                                           bool recurring)
+	{
+		return addTimer(ms, [weak_cond, cb]() {
+			std::shared_ptr<void> tmp = weak_cond.lock();
+			if (tmp)
+			{
+				cb();
+			}
+		}, recurring);
+	}
+
+	uint64_t TimerManager::getNextTimer()
+	{
+		MutexType::Lock lock(&m_mutex);
+		m_tickled = false;
+		if (!m_count)
+		{
+			m_nextHint = UINT64_MAX;
+			return UINT64_MAX;
+		}
+		m_nextHint = nextExpire();
+		uint64_t now = nowTick();
+		return m_nextHint > now ? m_nextHint - now : 0;
+	}
+
+	void TimerManager::listExpiredCallbacks(std::vector<std::function<void()> >& cbs)
+	{
+		std::vector<Timer::ptr> expired;
+		MutexType::Lock lock(&m_mutex);
+		uint64_t now = nowTick();
+		if (m_current > now)
+		{
+			return;
+		}
+		advance(now, expired);
+		cbs.reserve(cbs.size() + expired.size());
+		for (auto& timer: expired)
+		{
+			if (timer->m_recurring)
+			{
+				cbs.push_back(timer->m_cb);
+				timer->m_start = startTick();
+				timer->m_expire = timer->m_start + timer->m_ms;
+				timer->m_self = timer;
+				place(timer.get());
+			}
+			else
+			{
+				cbs.push_back(std::move(timer->m_cb));
+				timer->m_cb = nullptr;
+			}
+		}
+	}
+
+	bool TimerManager::hasTimer()
+	{
+		MutexType::Lock lock(&m_mutex);
+		return m_count != 0;
+	}
+
+	size_t TimerManager::getTimerCount()
+	{
+		MutexType::Lock lock(&m_mutex);
+		return m_count;
+	}
+
+	uint64_t TimerManager::nowTick() const
+	{
+		return (GetMonotonicNS() - m_baseNS) / 1000000;
+	}
+
+	uint64_t TimerManager::startTick() const
+	{
+		return (GetMonotonicNS() - m_baseNS + 999999) / 1000000;
+	}
+
+	void TimerManager::place(Timer* timer)
+	{
+		uint64_t expire = timer->m_expire;
+		uint32_t level;
+		uint32_t index;
+		if (expire < m_current)
+		{
+			// 已经过期，放到下一个要处理的槽
+			level = 0;
+			index = m_current & (s_rootSize - 1);
+		}
+		else
+		{
+			uint64_t delta = expire - m_current;
+			if (delta < s_rootSize)
+			{
+				level = 0;
+				index = expire & (s_rootSize - 1);
+			}
+			else
+			{
+				if (delta > s_timer_max_delta)
+				{
+					expire = m_current + s_timer_max_delta;
+					delta = s_timer_max_delta;
+				}
+				level = 1;
+				uint32_t shift = s_rootBits;
+				while (level < s_levels && delta >= (1ull << (shift + s_levelBits)))
+				{
+					++level;
+					shift += s_levelBits;
+				}
+				index = (expire >> shift) & (s_levelSize - 1);
+			}
+		}
+
+		Slot& s = slot(level, index);
+		timer->m_level = static_cast<int32_t>(level);
+		timer->m_index = index;
+		timer->m_prev = s.tail;
+		timer->m_next = nullptr;
+		if (s.tail)
+		{
+			s.tail->m_next = timer;
+		}
+		else
+		{
+			s.head = timer;
+		}
+		s.tail = timer;
+		if (level)
+		{
+			m_wheelBitmap[level - 1] |= 1ull << index;
+		}
+		else
+		{
+			m_rootBitmap[index / 64] |= 1ull << (index % 64);
+		}
+		++m_count;
+	}
+
+	bool TimerManager::markFront(uint64_t expire)
+	{
+		// 比事件循环正在等待的时间更早，并且这一轮还没通知过
+		if (expire < m_nextHint && !m_tickled)
+		{
+			m_tickled = true;
+			return true;
+		}
+		return false;
+	}
+
+	void TimerManager::unlink(Timer* timer)
+	{
+		uint32_t level = static_cast<uint32_t>(timer->m_level);
+		uint32_t index = timer->m_index;
+		Slot& s = slot(level, index);
+		if (timer->m_prev)
+		{
+			timer->m_prev->m_next = timer->m_next;
+		}
+		else
+		{
+			s.head = timer->m_next;
+		}
+		if (timer->m_next)
+		{
+			timer->m_next->m_prev = timer->m_prev;
+		}
+		else
+		{
+			s.tail = timer->m_prev;
+		}
+		timer->m_prev = timer->m_next = nullptr;
+		timer->m_level = -1;
+		if (!s.head)
+		{
+			if (level)
+			{
+				m_wheelBitmap[level - 1] &= ~(1ull << index);
+			}
+			else
+			{
+				m_rootBitmap[index / 64] &= ~(1ull << (index % 64));
+			}
+		}
+		--m_count;
+	}
+
+	uint32_t TimerManager::cascade(uint32_t level, uint32_t index)
+	{
+		Slot& s = slot(level, index);
+		while (s.head)
+		{
+			Timer* timer = s.head;
+			unlink(timer);
+			place(timer);
+		}
+		return index;
+	}
+
+	void TimerManager::advance(uint64_t tick, std::vector<Timer::ptr>& expired)
+	{
+		if (!m_count)
+		{
+			m_current = tick + 1;
+			return;
+		}
+		while (m_current <= tick)
+		{
+			uint32_t index = m_current & (s_rootSize - 1);
+			// 第 0 层转完一圈，上一层当前槽的定时器落到第 0 层；上一层也转完一圈则继续向上
+			if (!index)
+			{
+				uint32_t shift = s_rootBits;
+				for (uint32_t level = 1; level <= s_levels; ++level)
+				{
+					if (cascade(level, (m_current >> shift) & (s_levelSize - 1)))
+					{
+						break;
+					}
+					shift += s_levelBits;
+				}
+			}
+
+			Slot& s = m_root[index];
+			while (s.head)
+			{
+				Timer* timer = s.head;
+				unlink(timer);
+				expired.push_back(std::move(timer->m_self));
+			}
+
+			if (!m_count)
+			{
+				m_current = tick + 1;
+				break;
+			}
+			// 跳过第 0 层这一圈剩下的空槽
+			int next = FindNextBit(m_rootBitmap, s_rootSize / 64, index + 1);
+			uint64_t step = (next < 0 ? s_rootSize : static_cast<uint32_t>(next)) - index;
+			m_current = std::min(m_current + step, tick + 1);
+		}
+	}
+
+	uint64_t TimerManager::nextExpire() const
+	{
+		uint64_t result = UINT64_MAX;
+		// 第 0 层的定时器都在 m_current 之后 256 个 tick 内，从当前槽往后找
+		uint32_t index = m_current & (s_rootSize - 1);
+		int next = FindNextBit(m_rootBitmap, s_rootSize / 64, index);
+		if (next >= 0)
+		{
+			result = m_current + (next - index);
+		}
+		else if ((next = FindNextBit(m_rootBitmap, s_rootSize / 64, 0)) >= 0)
+		{
+			result = m_current + (next + s_rootSize - index);
+		}
+
+		// 高层的定时器在它所在的槽级联时才可能到期，取下一次级联的时间作为下界
+		uint32_t shift = s_rootBits;
+		for (uint32_t level = 0; level < s_levels; ++level, shift += s_levelBits)
+		{
+			uint64_t bits = m_wheelBitmap[level];
+			while (bits)
+			{
+				uint32_t i = __builtin_ctzll(bits);
+				bits &= bits - 1;
+				uint64_t round = (m_current >> (shift + s_levelBits)) << (shift + s_levelBits);
+				uint64_t cascade_at = round | (static_cast<uint64_t>(i) << shift);
+				if (cascade_at < m_current)
+				{
+					cascade_at += 1ull << (shift + s_levelBits);
+				}
+				result = std::min(result, cascade_at);
+			}
+		}
+		return result;
+	}
+
+	void TimerManager::notifyFront(bool front)
+	{
+		if (front)
+		{
+			onTimerInsertedAtFront();
+		}
+	}
+#pragma endregion TimerManager
+}
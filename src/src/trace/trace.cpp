@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+
+#include <include/trace/trace.h>
+#include <include/config/config.h>
+#include <include/thread/thread.h>
+#include <include/util.h>
+
+namespace RareVoyager
+{
+	static Logger::ptr g_logger = RAREVOYAGER_LOG_NAME("system");
+
+#pragma region TraceClock
+	/**
+	 * @brief: 进程启动时记录一组(TSC, 单调时钟)作为换算基准，
+	 * 换算时再取一组当前值，两者的斜率就是每个 tick 的纳秒数
+	 */
+	struct TraceClockBase
+	{
+		TraceClockBase()
+		{
+			ticks = TraceClock::Now();
+			ns = GetMonotonicNS();
+		}
+
+		uint64_t ticks;
+		uint64_t ns;
+	};
+
+	static TraceClockBase s_trace_clock_base;
+
+	uint64_t TraceClock::NowNS()
+	{
+		return GetMonotonicNS();
+	}
+
+	/**
+	 * @brief: 当前的换算斜率(纳秒/tick)
+	 */
+	static double NsPerTick()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		uint64_t now_ticks = TraceClock::Now();
+		uint64_t now_ns = GetMonotonicNS();
+		if (now_ticks <= s_trace_clock_base.ticks || now_ns <= s_trace_clock_base.ns)
+		{
+			return 1;
+		}
+		return static_cast<double>(now_ns - s_trace_clock_base.ns)
+		       / static_cast<double>(now_ticks - s_trace_clock_base.ticks);
+#else
+		return 1;
+#endif
+	}
+
+	static uint64_t TicksToNS(uint64_t ticks, double ns_per_tick)
+	{
+		double delta = (static_cast<double>(ticks) - static_cast<double>(s_trace_clock_base.ticks)) * ns_per_tick;
+		return s_trace_clock_base.ns + static_cast<int64_t>(delta);
+	}
+
+	uint64_t TraceClock::ToNS(uint64_t ticks)
+	{
+		return TicksToNS(ticks, NsPerTick());
+	}
+#pragma endregion TraceClock
+
+#pragma region TraceBuffer
+	struct TraceEvent
+	{
+		const char* name;
+		uint64_t begin;
+		uint64_t end;
+		uint32_t fiberId;
+	};
+
+	/**
+	 * @brief: 单生产者环形缓冲区。只有所属线程写入，导出线程只读
+	 * head 是写入的事件总数，导出时只取最近 capacity 条
+	 */
+	struct TraceBuffer
+	{
+		typedef std::shared_ptr<TraceBuffer> ptr;
+
+		TraceBuffer(size_t capacity)
+		{
+			size_t n = 1;
+			while (n < capacity)
+			{
+				n <<= 1;
+			}
+			mask = n - 1;
+			events.reset(new TraceEvent[n]);
+		}
+
+		pid_t tid = 0;
+		std::string threadName;
+		std::atomic<bool> alive{true};
+		size_t mask = 0;
+		std::unique_ptr<TraceEvent[]> events;
+		std::atomic<uint64_t> head{0};
+		// Clear 时记下的 head，导出时跳过它之前的事件
+		std::atomic<uint64_t> floor{0};
+	};
+
+	static ConfigVar<bool>::ptr g_trace_enable =
+			Config::Lookup("trace.enable", false, "record RAREVOYAGER_TRACE_SCOPE spans");
+
+	static ConfigVar<uint32_t>::ptr g_trace_buffer_size =
+			Config::Lookup("trace.buffer_size", (uint32_t)16384, "trace events kept per thread");
+
+	static ConfigVar<std::string>::ptr g_trace_dump =
+			Config::Lookup("trace.dump", std::string(""), "write chrome trace json to this file when set");
+
+	static Mutex& GetBuffersMutex()
+	{
+		static Mutex s_mutex;
+		return s_mutex;
+	}
+
+	static std::list<TraceBuffer::ptr>& GetBuffers()
+	{
+		static std::list<TraceBuffer::ptr> s_buffers;
+		return s_buffers;
+	}
+
+	/**
+	 * @brief: 线程退出时把缓冲区标记为已退出，事件保留到下一次 Clear
+	 */
+	struct TraceBufferHolder
+	{
+		~TraceBufferHolder()
+		{
+			if (buffer)
+			{
+				buffer->alive.store(false, std::memory_order_relaxed);
+			}
+		}
+
+		TraceBuffer::ptr buffer;
+	};
+
+	// 热路径只访问这个平凡类型的 thread_local，没有 TLS 初始化检查
+	static thread_local TraceBuffer* t_trace_buffer = nullptr;
+	static thread_local TraceBufferHolder t_trace_holder;
+
+	static TraceBuffer* CreateTraceBuffer()
+	{
+		TraceBuffer::ptr buffer(new TraceBuffer(g_trace_buffer_size->getValue()));
+		buffer->tid = getThreadPid();
+		buffer->threadName = Thread::GetName();
+		{
+			Mutex::Lock lock(&GetBuffersMutex());
+			GetBuffers().push_back(buffer);
+		}
+		t_trace_holder.buffer = buffer;
+		t_trace_buffer = buffer.get();
+		return t_trace_buffer;
+	}
+#pragma endregion TraceBuffer
+
+#pragma region Tracer
+	std::atomic<bool> Tracer::s_enabled{false};
+
+	void Tracer::SetEnabled(bool v)
+	{
+		s_enabled.store(v, std::memory_order_relaxed);
+	}
+
+	void Tracer::Record(const char* name, uint64_t begin, uint64_t end)
+	{
+		TraceBuffer* buffer = t_trace_buffer;
+		if (RAREVOYAGER_UNLIKELY(!buffer))
+		{
+			buffer = CreateTraceBuffer();
+		}
+		uint64_t head = buffer->head.load(std::memory_order_relaxed);
+		TraceEvent& e = buffer->events[head & buffer->mask];
+		e.name = name;
+		e.begin = begin;
+		e.end = end;
+		e.fiberId = getFiberId();
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	static void AppendJsonString(std::stringstream& ss, const char* str)
+	{
+		ss << '"';
+		for (const char* p = str; *p; ++p)
+		{
+			switch (*p)
+			{
+			case '"':
+				ss << "\\\"";
+				break;
+			case '\\':
+				ss << "\\\\";
+				break;
+			case '\n':
+				ss << "\\n";
+				break;
+			default:
+				if (static_cast<unsigned char>(*p) < 0x20)
+				{
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04x", *p);
+					ss << buf;
+				}
+				else
+				{
+					ss << *p;
+				}
+			}
+		}
+		ss << '"';
+	}
+
+	std::string Tracer::ToChromeTraceJson()
+	{
+		std::vector<TraceBuffer::ptr> buffers;
+		{
+			Mutex::Lock lock(&GetBuffersMutex());
+			buffers.assign(GetBuffers().begin(), GetBuffers().end());
+		}
+
+		pid_t pid = getpid();
+		std::stringstream ss;
+		ss.setf(std::ios::fixed);
+		ss.precision(3);
+		ss << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		bool first = true;
+		double ns_per_tick = NsPerTick();
+		std::vector<TraceEvent> events;
+		for (auto& buf: buffers)
+		{
+			// 线程名元数据
+			ss << (first ? "" : ",") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+					<< ",\"tid\":" << buf->tid << ",\"args\":{\"name\":";
+			AppendJsonString(ss, buf->threadName.c_str());
+			ss << "}}";
+			first = false;
+
+			size_t capacity = buf->mask + 1;
+			uint64_t head = buf->head.load(std::memory_order_acquire);
+			uint64_t begin = head > capacity ? head - capacity : 0;
+			begin = std::max(begin, buf->floor.load(std::memory_order_relaxed));
+			events.clear();
+			for (uint64_t i = begin; i < head; ++i)
+			{
+				events.push_back(buf->events[i & buf->mask]);
+			}
+			// 复制期间所属线程可能继续写入，被覆盖的那部分丢弃。
+			// 所属线程写完槽位才推进 head，槽 new_head 可能正在写，也要算作被覆盖
+			uint64_t new_head = buf->head.load(std::memory_order_acquire);
+			size_t skip = new_head + 1 > capacity + begin ? new_head + 1 - capacity - begin : 0;
+
+			for (size_t i = skip; i < events.size(); ++i)
+			{
+				auto& e = events[i];
+				uint64_t b = TicksToNS(e.begin, ns_per_tick);
+				uint64_t d = TicksToNS(e.end, ns_per_tick) - b;
+				ss << ",{\"name\":";
+				AppendJsonString(ss, e.name);
+				ss << ",\"cat\":\"rarevoyager\",\"ph\":\"X\",\"ts\":" << b / 1000.0
+						<< ",\"dur\":" << d / 1000.0
+						<< ",\"pid\":" << pid << ",\"tid\":" << buf->tid
+						<< ",\"args\":{\"fiber\":" << e.fiberId << "}}";
+			}
+		}
+		ss << "]}";
+		return ss.str();
+	}
+
+	bool Tracer::WriteChromeTrace(const std::string& filename)
+	{
+		std::ofstream ofs(filename, std::ios::trunc);
+		if (!ofs)
+		{
+			RAREVOYAGER_LOG_ERROR(g_logger) << "Tracer::WriteChromeTrace open " << filename << " failed";
+			return false;
+		}
+		ofs << ToChromeTraceJson();
+		return static_cast<bool>(ofs);
+	}
+
+	void Tracer::Clear()
+	{
+		Mutex::Lock lock(&GetBuffersMutex());
+		for (auto it = GetBuffers().begin(); it != GetBuffers().end();)
+		{
+			if (!(*it)->alive.load(std::memory_order_relaxed))
+			{
+				it = GetBuffers().erase(it);
+				continue;
+			}
+			// 存活线程的 head 只由它自己推进，这里只移动导出的起点
+			(*it)->floor.store((*it)->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+			++it;
+		}
+	}
+#pragma endregion Tracer
+
+#pragma region TraceIniter
+	struct TraceIniter
+	{
+		TraceIniter()
+		{
+			Tracer::SetEnabled(g_trace_enable->getValue());
+			g_trace_enable->addListener([](const bool& old_value, const bool& new_value) {
+				RAREVOYAGER_LOG_INFO(g_logger) << "trace.enable " << old_value << " -> " << new_value;
+				Tracer::SetEnabled(new_value);
+			});
+			g_trace_dump->addListener([](const std::string& old_value, const std::string& new_value) {
+				if (!new_value.empty())
+				{
+					Tracer::WriteChromeTrace(new_value);
+				}
+			});
+		}
+	};
+
+	static TraceIniter __trace_init;
+#pragma endregion TraceIniter
+}
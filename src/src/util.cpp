@@ -1,6 +1,7 @@
 #include <include/util.h>
 
 #include "include/logger/logger.h"
+#include "include/thread/fiber.h"
 
 #include <pthread.h>
 
@@ -36,7 +37,7 @@ namespace RareVoyager
 
 	uint32_t getFiberId()
 	{
-		return 0;
+		return static_cast<uint32_t>(Fiber::GetFiberId());
 	}
 
 	std::string GetCurrentDateStr()
@@ -53,6 +54,13 @@ namespace RareVoyager
 		return std::string(buf);
 	}
 
+	uint64_t GetMonotonicNS()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+	}
+
 	void Backtrace(std::vector<std::string>& bt, int size, int skip)
 	{
 #if defined(_WIN32)